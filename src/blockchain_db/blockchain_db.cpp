@@ -96,6 +96,16 @@ const command_line::arg_descriptor<bool> arg_db_salvage  = {
 , "Try to salvage a blockchain database if it seems corrupted"
 , false
 };
+const command_line::arg_descriptor<std::string> arg_db_cold_data_dir = {
+  "db-cold-data-dir"
+, "Keep prunable transaction data in this directory, e.g. on slower storage, instead of with the rest of the database"
+, ""
+};
+const command_line::arg_descriptor<bool> arg_db_read_only_replica  = {
+  "db-read-only-replica"
+, "Open the blockchain database read-only and follow the daemon writing to it, serving RPC only"
+, false
+};
 
 BlockchainDB *new_db(const std::string& db_type)
 {
@@ -113,6 +123,14 @@ void BlockchainDB::init_options(boost::program_options::options_description& des
   command_line::add_arg(desc, arg_db_type);
   command_line::add_arg(desc, arg_db_sync_mode);
   command_line::add_arg(desc, arg_db_salvage);
+  command_line::add_arg(desc, arg_db_read_only_replica);
+  command_line::add_arg(desc, arg_db_cold_data_dir);
+}
+
+void BlockchainDB::set_cold_data_folder(const std::string& folder)
+{
+  if (!folder.empty())
+    throw DB_ERROR("This database type does not support a separate cold data folder");
 }
 
 void BlockchainDB::pop_block()
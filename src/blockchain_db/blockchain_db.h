@@ -110,6 +110,8 @@ typedef std::pair<crypto::hash, uint64_t> tx_out_index;
 extern const command_line::arg_descriptor<std::string> arg_db_type;
 extern const command_line::arg_descriptor<std::string> arg_db_sync_mode;
 extern const command_line::arg_descriptor<bool, false> arg_db_salvage;
+extern const command_line::arg_descriptor<bool, false> arg_db_read_only_replica;
+extern const command_line::arg_descriptor<std::string> arg_db_cold_data_dir;
 
 #pragma pack(push, 1)
 
@@ -598,6 +600,17 @@ public:
    */
   virtual void open(const std::string& filename, const int db_flags = 0) = 0;
 
+  /**
+   * @brief keep prunable transaction data in a separate location
+   *
+   * Prunable data is large and rarely read, so it can live on slower
+   * storage than the rest of the database. Must be called before open(),
+   * and the same folder must be given every time the database is opened.
+   *
+   * @param folder the location for prunable data, empty to keep it with the rest
+   */
+  virtual void set_cold_data_folder(const std::string& folder);
+
   /**
    * @brief Gets the current open/ready state of the BlockchainDB
    *
@@ -1587,6 +1600,16 @@ public:
    */
   virtual bool is_read_only() const = 0;
 
+  /**
+   * @brief get the id of the last committed write transaction
+   *
+   * The id changes whenever any process sharing the database commits to it,
+   * so a read-only user can tell when its cached state is stale.
+   *
+   * @return the last committed transaction id
+   */
+  virtual uint64_t get_last_txn_id() const = 0;
+
   /**
    * @brief get disk space requirements
    *
@@ -1594,6 +1617,25 @@ public:
    */
   virtual uint64_t get_database_size() const = 0;
 
+  /**
+   * @brief write a compacted copy of the database to a directory
+   *
+   * The copy reflects a single consistent state of the database, and can be
+   * done while the database is in use.
+   *
+   * @param path the directory to write the copy to
+   */
+  virtual void copy_compacted(const std::string& path) const = 0;
+
+  /**
+   * @brief hash the contents of each table
+   *
+   * All tables are hashed within the same read transaction, in a fixed order.
+   *
+   * @return the table names and the hashes of their contents
+   */
+  virtual std::vector<std::pair<std::string, crypto::hash>> get_table_hashes() const = 0;
+
   // TODO: this should perhaps be (or call) a series of functions which
   // progressively update through version updates
   /**
@@ -38,6 +38,7 @@
 #include "string_tools.h"
 #include "file_io_utils.h"
 #include "common/util.h"
+#include "common/int-util.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
 #include "crypto/crypto.h"
 #include "profile_tools.h"
@@ -210,6 +211,9 @@ const char* const LMDB_HF_VERSIONS = "hf_versions";
 
 const char* const LMDB_PROPERTIES = "properties";
 
+// property set when prunable tx data is kept in a separate environment
+const char* const LMDB_COLD_PRUNABLE_PROPERTY = "cold_prunable";
+
 const char zerokey[8] = {0};
 const MDB_val zerokval = { sizeof(zerokey), (void *)zerokey };
 
@@ -249,6 +253,21 @@ inline void lmdb_db_open(MDB_txn* txn, const char* name, int flags, MDB_dbi& dbi
 	  m_tinfo->m_ti_rflags.m_rf_ ## name = true; \
 	}
 
+// prunable tx data may live in the cold environment, see open_cold()
+#define CURSOR_PRUNABLE() \
+	if (!m_cur_txs_prunable) { \
+	  int result = mdb_cursor_open(m_cold_env ? cold_write_txn() : (MDB_txn*)*m_write_txn, m_txs_prunable, &m_cur_txs_prunable); \
+	  if (result) \
+        throw0(DB_ERROR(lmdb_error("Failed to open cursor: ", result).c_str())); \
+	}
+
+#define RCURSOR_PRUNABLE() \
+	if (m_cold_env) { \
+	  cold_read_cursor(m_cursors); \
+	} else { \
+	  RCURSOR(txs_prunable) \
+	}
+
 namespace cryptonote
 {
 
@@ -313,6 +332,8 @@ mdb_threadinfo::~mdb_threadinfo()
       mdb_cursor_close(cur[i]);
   if (m_ti_rtxn)
     mdb_txn_abort(m_ti_rtxn);
+  if (m_ti_cold_rtxn)
+    mdb_txn_abort(m_ti_cold_rtxn);
 }
 
 mdb_txn_safe::mdb_txn_safe(const bool check) : m_txn(NULL), m_tinfo(NULL), m_check(check)
@@ -333,6 +354,8 @@ mdb_txn_safe::~mdb_txn_safe()
   if (m_tinfo != nullptr)
   {
     mdb_txn_reset(m_tinfo->m_ti_rtxn);
+    if (m_tinfo->m_ti_cold_rtxn)
+      mdb_txn_reset(m_tinfo->m_ti_cold_rtxn);
     memset(&m_tinfo->m_ti_rflags, 0, sizeof(m_tinfo->m_ti_rflags));
   } else if (m_txn != nullptr)
   {
@@ -498,6 +521,19 @@ void BlockchainLMDB::do_resize(uint64_t increase_size)
 
   new_mapsize += (new_mapsize % mst.ms_psize);
 
+  // the cold environment grows by the same amount, it rarely matters which
+  // one filled up first
+  uint64_t new_cold_mapsize = 0;
+  if (m_cold_env)
+  {
+    MDB_envinfo cold_mei;
+    mdb_env_info(m_cold_env, &cold_mei);
+    MDB_stat cold_mst;
+    mdb_env_stat(m_cold_env, &cold_mst);
+    new_cold_mapsize = cold_mei.me_mapsize + (new_mapsize - mei.me_mapsize);
+    new_cold_mapsize += (new_cold_mapsize % cold_mst.ms_psize);
+  }
+
   mdb_txn_safe::prevent_new_txns();
 
   if (m_write_txn != nullptr)
@@ -517,6 +553,8 @@ void BlockchainLMDB::do_resize(uint64_t increase_size)
   int result = mdb_env_set_mapsize(m_env, new_mapsize);
   if (result)
     throw0(DB_ERROR(lmdb_error("Failed to set new mapsize: ", result).c_str()));
+  if (m_cold_env && (result = mdb_env_set_mapsize(m_cold_env, new_cold_mapsize)))
+    throw0(DB_ERROR(lmdb_error("Failed to set new cold mapsize: ", result).c_str()));
 
   MGINFO("LMDB Mapsize increased." << "  Old: " << mei.me_mapsize / (1024 * 1024) << "MiB" << ", New: " << new_mapsize / (1024 * 1024) << "MiB");
 
@@ -528,42 +566,47 @@ bool BlockchainLMDB::need_resize(uint64_t threshold_size) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
 #if defined(ENABLE_AUTO_RESIZE)
-  MDB_envinfo mei;
+  for (MDB_env *env: {m_env, m_cold_env})
+  {
+    if (!env)
+      continue;
 
-  mdb_env_info(m_env, &mei);
+    MDB_envinfo mei;
 
-  MDB_stat mst;
+    mdb_env_info(env, &mei);
 
-  mdb_env_stat(m_env, &mst);
+    MDB_stat mst;
 
-  // size_used doesn't include data yet to be committed, which can be
-  // significant size during batch transactions. For that, we estimate the size
-  // needed at the beginning of the batch transaction and pass in the
-  // additional size needed.
-  uint64_t size_used = mst.ms_psize * mei.me_last_pgno;
+    mdb_env_stat(env, &mst);
 
-  LOG_PRINT_L1("DB map size:     " << mei.me_mapsize);
-  LOG_PRINT_L1("Space used:      " << size_used);
-  LOG_PRINT_L1("Space remaining: " << mei.me_mapsize - size_used);
-  LOG_PRINT_L1("Size threshold:  " << threshold_size);
-  float resize_percent = RESIZE_PERCENT;
-  LOG_PRINT_L1(boost::format("Percent used: %.04f  Percent threshold: %.04f") % ((double)size_used/mei.me_mapsize) % resize_percent);
+    // size_used doesn't include data yet to be committed, which can be
+    // significant size during batch transactions. For that, we estimate the size
+    // needed at the beginning of the batch transaction and pass in the
+    // additional size needed.
+    uint64_t size_used = mst.ms_psize * mei.me_last_pgno;
 
-  if (threshold_size > 0)
-  {
-    if (mei.me_mapsize - size_used < threshold_size)
+    LOG_PRINT_L1("DB map size:     " << mei.me_mapsize);
+    LOG_PRINT_L1("Space used:      " << size_used);
+    LOG_PRINT_L1("Space remaining: " << mei.me_mapsize - size_used);
+    LOG_PRINT_L1("Size threshold:  " << threshold_size);
+    float resize_percent = RESIZE_PERCENT;
+    LOG_PRINT_L1(boost::format("Percent used: %.04f  Percent threshold: %.04f") % ((double)size_used/mei.me_mapsize) % resize_percent);
+
+    if (threshold_size > 0)
     {
-      LOG_PRINT_L1("Threshold met (size-based)");
-      return true;
+      if (mei.me_mapsize - size_used < threshold_size)
+      {
+        LOG_PRINT_L1("Threshold met (size-based)");
+        return true;
+      }
+      continue;
     }
-    else
-      return false;
-  }
 
-  if ((double)size_used / mei.me_mapsize  > resize_percent)
-  {
-    LOG_PRINT_L1("Threshold met (percent-based)");
-    return true;
+    if ((double)size_used / mei.me_mapsize  > resize_percent)
+    {
+      LOG_PRINT_L1("Threshold met (percent-based)");
+      return true;
+    }
   }
   return false;
 #else
@@ -804,7 +847,7 @@ uint64_t BlockchainLMDB::add_transaction_data(const crypto::hash& blk_hash, cons
   uint64_t tx_id = get_tx_count();
 
   CURSOR(txs_pruned)
-  CURSOR(txs_prunable)
+  CURSOR_PRUNABLE()
   CURSOR(txs_prunable_hash)
   CURSOR(tx_indices)
 
@@ -850,6 +893,14 @@ uint64_t BlockchainLMDB::add_transaction_data(const crypto::hash& blk_hash, cons
   cryptonote::blobdata prunable(blob.data() + pruned.size(), blob.size() - pruned.size());
   MDB_val_copy<blobdata> prunable_blob(prunable);
   result = mdb_cursor_put(m_cur_txs_prunable, &val_tx_id, &prunable_blob, MDB_APPEND);
+  if (m_cold_env)
+  {
+    // a cold record for this id may be left from a tx removed earlier, whose
+    // delete is still pending or was lost with a failed commit
+    m_cold_deletes.erase(tx_id);
+    if (result == MDB_KEYEXIST)
+      result = mdb_cursor_put(m_cur_txs_prunable, &val_tx_id, &prunable_blob, 0);
+  }
   if (result)
     throw0(DB_ERROR(lmdb_error("Failed to add prunable tx blob to db transaction: ", result).c_str()));
 
@@ -876,7 +927,8 @@ void BlockchainLMDB::remove_transaction_data(const crypto::hash& tx_hash, const
   mdb_txn_cursors *m_cursors = &m_wcursors;
   CURSOR(tx_indices)
   CURSOR(txs_pruned)
-  CURSOR(txs_prunable)
+  if (!m_cold_env)
+    CURSOR(txs_prunable)
   CURSOR(txs_prunable_hash)
   CURSOR(tx_outputs)
 
@@ -893,11 +945,20 @@ void BlockchainLMDB::remove_transaction_data(const crypto::hash& tx_hash, const
   if (result)
       throw1(DB_ERROR(lmdb_error("Failed to add removal of pruned tx to db transaction: ", result).c_str()));
 
-  if ((result = mdb_cursor_get(m_cur_txs_prunable, &val_tx_id, NULL, MDB_SET)))
-      throw1(DB_ERROR(lmdb_error("Failed to locate prunable tx for removal: ", result).c_str()));
-  result = mdb_cursor_del(m_cur_txs_prunable, 0);
-  if (result)
-      throw1(DB_ERROR(lmdb_error("Failed to add removal of prunable tx to db transaction: ", result).c_str()));
+  if (m_cold_env)
+  {
+    // deleted after m_write_txn commits, so the cold environment never
+    // lacks data for a tx the main one still has
+    m_cold_deletes.insert(tip->data.tx_id);
+  }
+  else
+  {
+    if ((result = mdb_cursor_get(m_cur_txs_prunable, &val_tx_id, NULL, MDB_SET)))
+        throw1(DB_ERROR(lmdb_error("Failed to locate prunable tx for removal: ", result).c_str()));
+    result = mdb_cursor_del(m_cur_txs_prunable, 0);
+    if (result)
+        throw1(DB_ERROR(lmdb_error("Failed to add removal of prunable tx to db transaction: ", result).c_str()));
+  }
 
   if (tx.version > TxVersion::plain)
   {
@@ -1161,6 +1222,8 @@ BlockchainLMDB::BlockchainLMDB(bool batch_transactions): BlockchainDB()
   m_batch_transactions = batch_transactions;
   m_write_txn = nullptr;
   m_write_batch_txn = nullptr;
+  m_cold_env = nullptr;
+  m_cold_write_txn = nullptr;
   m_batch_active = false;
   m_cum_size = 0;
   m_cum_count = 0;
@@ -1170,6 +1233,14 @@ BlockchainLMDB::BlockchainLMDB(bool batch_transactions): BlockchainDB()
   m_hardfork = nullptr;
 }
 
+void BlockchainLMDB::set_cold_data_folder(const std::string& folder)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  if (m_open)
+    throw0(DB_ERROR("The cold data folder must be set before opening the db"));
+  m_cold_folder = folder;
+}
+
 void BlockchainLMDB::open(const std::string& filename, const int db_flags)
 {
   int result;
@@ -1283,7 +1354,6 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
 
   lmdb_db_open(txn, LMDB_TXS, MDB_INTEGERKEY | MDB_CREATE, m_txs, "Failed to open db handle for m_txs");
   lmdb_db_open(txn, LMDB_TXS_PRUNED, MDB_INTEGERKEY | MDB_CREATE, m_txs_pruned, "Failed to open db handle for m_txs_pruned");
-  lmdb_db_open(txn, LMDB_TXS_PRUNABLE, MDB_INTEGERKEY | MDB_CREATE, m_txs_prunable, "Failed to open db handle for m_txs_prunable");
   lmdb_db_open(txn, LMDB_TXS_PRUNABLE_HASH, MDB_INTEGERKEY | MDB_CREATE, m_txs_prunable_hash, "Failed to open db handle for m_txs_prunable_hash");
   lmdb_db_open(txn, LMDB_TX_INDICES, MDB_INTEGERKEY | MDB_CREATE | MDB_DUPSORT | MDB_DUPFIXED, m_tx_indices, "Failed to open db handle for m_tx_indices");
   lmdb_db_open(txn, LMDB_TX_OUTPUTS, MDB_INTEGERKEY | MDB_CREATE, m_tx_outputs, "Failed to open db handle for m_tx_outputs");
@@ -1317,6 +1387,8 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   mdb_set_compare(txn, m_txpool_blob, compare_hash32);
   mdb_set_compare(txn, m_properties, compare_string);
 
+  open_cold(mdb_flags, txn);
+
   if (!(mdb_flags & MDB_RDONLY))
   {
     result = mdb_drop(txn, m_hf_starting_heights, 1);
@@ -1350,6 +1422,8 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
       // Note that there was a schema change within version 0 as well.
       // See commit e5d2680094ee15889934fe28901e4e133cda56f2 2015/07/10
       // We don't handle the old format previous to that commit.
+      if (m_cold_env)
+        throw0(DB_ERROR("The db must be migrated without a cold data folder first"));
       txn.commit();
       m_open = true;
       migrate(db_version);
@@ -1369,6 +1443,11 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   if (!compatible)
   {
     txn.abort();
+    if (m_cold_env)
+    {
+      mdb_env_close(m_cold_env);
+      m_cold_env = nullptr;
+    }
     mdb_env_close(m_env);
     m_open = false;
     MFATAL("Existing lmdb database is incompatible with this version.");
@@ -1387,6 +1466,11 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
       if (put_result != MDB_SUCCESS)
       {
         txn.abort();
+        if (m_cold_env)
+        {
+          mdb_env_close(m_cold_env);
+          m_cold_env = nullptr;
+        }
         mdb_env_close(m_env);
         m_open = false;
         MERROR("Failed to write version to database.");
@@ -1402,6 +1486,202 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   // from here, init should be finished
 }
 
+void BlockchainLMDB::open_cold(int mdb_flags, MDB_txn *txn)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  int result;
+
+  // a db split once must always be opened split, and the other way round
+  MDB_val_copy<const char*> k(LMDB_COLD_PRUNABLE_PROPERTY);
+  MDB_val v;
+  result = mdb_get(txn, m_properties, &k, &v);
+  if (result && result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("Failed to read cold data property: ", result).c_str()));
+  const bool split = result == MDB_SUCCESS;
+
+  if (m_cold_folder.empty())
+  {
+    if (split)
+      throw0(DB_OPEN_FAILURE("Prunable tx data for this db is kept in a cold data folder, which must be given"));
+    lmdb_db_open(txn, LMDB_TXS_PRUNABLE, MDB_INTEGERKEY | MDB_CREATE, m_txs_prunable, "Failed to open db handle for m_txs_prunable");
+    return;
+  }
+
+  MDB_stat db_stats;
+  if ((result = mdb_stat(txn, m_txs_pruned, &db_stats)))
+    throw0(DB_ERROR(lmdb_error("Failed to query m_txs_pruned: ", result).c_str()));
+  const uint64_t num_txs = db_stats.ms_entries;
+
+  if (!split)
+  {
+    if (num_txs > 0 || (mdb_flags & MDB_RDONLY))
+      throw0(DB_OPEN_FAILURE("A cold data folder can only be used for a db created with one"));
+    MDB_val_copy<uint32_t> cv(1);
+    if ((result = mdb_put(txn, m_properties, &k, &cv, 0)))
+      throw0(DB_ERROR(lmdb_error("Failed to write cold data property to database: ", result).c_str()));
+  }
+
+  boost::filesystem::path direc(m_cold_folder);
+  if (!boost::filesystem::exists(direc) && !boost::filesystem::create_directories(direc))
+    throw0(DB_OPEN_FAILURE(std::string("Failed to create directory ").append(m_cold_folder).c_str()));
+
+  if ((result = mdb_env_create(&m_cold_env)))
+    throw0(DB_ERROR(lmdb_error("Failed to create cold lmdb environment: ", result).c_str()));
+  if ((result = mdb_env_set_maxdbs(m_cold_env, 1)))
+    throw0(DB_ERROR(lmdb_error("Failed to set max number of dbs: ", result).c_str()));
+  int threads = tools::get_max_concurrency();
+  if (threads > 110 && (result = mdb_env_set_maxreaders(m_cold_env, threads+16)))
+    throw0(DB_ERROR(lmdb_error("Failed to set max number of readers: ", result).c_str()));
+  if ((result = mdb_env_open(m_cold_env, m_cold_folder.c_str(), mdb_flags, 0644)))
+    throw0(DB_ERROR(lmdb_error("Failed to open cold lmdb environment: ", result).c_str()));
+
+  MDB_envinfo mei;
+  mdb_env_info(m_cold_env, &mei);
+  if (mei.me_mapsize < DEFAULT_MAPSIZE)
+  {
+    if ((result = mdb_env_set_mapsize(m_cold_env, DEFAULT_MAPSIZE)))
+      throw0(DB_ERROR(lmdb_error("Failed to set max memory map size: ", result).c_str()));
+  }
+
+  mdb_txn_safe cold_txn;
+  if ((result = lmdb_txn_begin(m_cold_env, NULL, mdb_flags & MDB_RDONLY, cold_txn)))
+    throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the cold db: ", result).c_str()));
+  lmdb_db_open(cold_txn, LMDB_TXS_PRUNABLE, MDB_INTEGERKEY | MDB_CREATE, m_txs_prunable, "Failed to open db handle for m_txs_prunable");
+
+  if (!(mdb_flags & MDB_RDONLY))
+  {
+    // cold records are written before the main txn commits and deleted after,
+    // so a crash in between can only leave records past the last tx
+    MDB_cursor *cur;
+    if ((result = mdb_cursor_open(cold_txn, m_txs_prunable, &cur)))
+      throw0(DB_ERROR(lmdb_error("Failed to open cursor: ", result).c_str()));
+    uint64_t removed = 0;
+    MDB_val_set(key, num_txs);
+    MDB_val val;
+    result = mdb_cursor_get(cur, &key, &val, MDB_SET_RANGE);
+    while (result == MDB_SUCCESS)
+    {
+      if ((result = mdb_cursor_del(cur, 0)))
+        break;
+      ++removed;
+      result = mdb_cursor_get(cur, &key, &val, MDB_NEXT);
+    }
+    mdb_cursor_close(cur);
+    if (result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error("Failed to remove leftover cold records: ", result).c_str()));
+    if (removed)
+      MWARNING("Removed " << removed << " leftover prunable tx records from the cold data folder");
+  }
+
+  if ((result = mdb_stat(cold_txn, m_txs_prunable, &db_stats)))
+    throw0(DB_ERROR(lmdb_error("Failed to query m_txs_prunable: ", result).c_str()));
+  if (db_stats.ms_entries < num_txs)
+    throw0(DB_OPEN_FAILURE("The cold data folder is missing prunable tx data, is it the right one?"));
+
+  cold_txn.commit();
+  MINFO("Keeping prunable tx data in " << m_cold_folder);
+}
+
+MDB_txn *BlockchainLMDB::cold_write_txn() const
+{
+  if (!m_cold_write_txn)
+  {
+    m_cold_write_txn = new mdb_txn_safe();
+    if (auto mdb_res = lmdb_txn_begin(m_cold_env, NULL, 0, *m_cold_write_txn))
+    {
+      delete m_cold_write_txn;
+      m_cold_write_txn = nullptr;
+      throw0(DB_ERROR_TXN_START(lmdb_error("Failed to create a transaction for the cold db: ", mdb_res).c_str()));
+    }
+  }
+  return *m_cold_write_txn;
+}
+
+void BlockchainLMDB::cold_read_cursor(mdb_txn_cursors *cursors) const
+{
+  int result;
+  if (cursors == &m_wcursors)
+  {
+    // the writer sees its own uncommitted cold records
+    if (!cursors->m_txc_txs_prunable && (result = mdb_cursor_open(cold_write_txn(), m_txs_prunable, &cursors->m_txc_txs_prunable)))
+      throw0(DB_ERROR(lmdb_error("Failed to open cursor: ", result).c_str()));
+    return;
+  }
+
+  mdb_threadinfo *tinfo = m_tinfo.get();
+  if (tinfo->m_ti_rflags.m_rf_txs_prunable)
+    return;
+
+  // the cold snapshot is taken on first use within each read txn; since cold
+  // records outlive the main ones, it covers every tx the read txn can see,
+  // except one being popped at that very moment
+  if (tinfo->m_ti_cold_rtxn)
+  {
+    mdb_txn_reset(tinfo->m_ti_cold_rtxn);
+    result = lmdb_txn_renew(tinfo->m_ti_cold_rtxn);
+  }
+  else
+    result = lmdb_txn_begin(m_cold_env, NULL, MDB_RDONLY, &tinfo->m_ti_cold_rtxn);
+  if (result)
+    throw0(DB_ERROR_TXN_START(lmdb_error("Failed to create a read transaction for the cold db: ", result).c_str()));
+
+  if (!cursors->m_txc_txs_prunable)
+    result = mdb_cursor_open(tinfo->m_ti_cold_rtxn, m_txs_prunable, &cursors->m_txc_txs_prunable);
+  else
+    result = mdb_cursor_renew(tinfo->m_ti_cold_rtxn, cursors->m_txc_txs_prunable);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open cursor: ", result).c_str()));
+  tinfo->m_ti_rflags.m_rf_txs_prunable = true;
+}
+
+void BlockchainLMDB::commit_cold_write_txn()
+{
+  if (!m_cold_write_txn)
+    return;
+  m_wcursors.m_txc_txs_prunable = nullptr;
+  mdb_txn_safe *txn = m_cold_write_txn;
+  m_cold_write_txn = nullptr;
+  try
+  {
+    txn->commit("Failed to commit a transaction to the cold db");
+  }
+  catch (...)
+  {
+    delete txn;
+    throw;
+  }
+  delete txn;
+}
+
+void BlockchainLMDB::apply_cold_deletes()
+{
+  if (m_cold_deletes.empty())
+    return;
+
+  mdb_txn_safe txn;
+  if (auto result = lmdb_txn_begin(m_cold_env, NULL, 0, txn))
+    throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the cold db: ", result).c_str()));
+  for (uint64_t tx_id: m_cold_deletes)
+  {
+    MDB_val_set(k, tx_id);
+    auto result = mdb_del(txn, m_txs_prunable, &k, NULL);
+    if (result && result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error("Failed to remove prunable tx from the cold db: ", result).c_str()));
+  }
+  txn.commit("Failed to commit a transaction to the cold db");
+  m_cold_deletes.clear();
+}
+
+void BlockchainLMDB::abort_cold_write_txn()
+{
+  if (!m_cold_write_txn)
+    return;
+  m_wcursors.m_txc_txs_prunable = nullptr;
+  m_cold_write_txn->abort();
+  delete m_cold_write_txn;
+  m_cold_write_txn = nullptr;
+}
+
 void BlockchainLMDB::close()
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -1414,6 +1694,11 @@ void BlockchainLMDB::close()
   m_tinfo.reset();
 
   // FIXME: not yet thread safe!!!  Use with care.
+  if (m_cold_env)
+  {
+    mdb_env_close(m_cold_env);
+    m_cold_env = nullptr;
+  }
   mdb_env_close(m_env);
   m_open = false;
 }
@@ -1432,12 +1717,19 @@ void BlockchainLMDB::sync()
   {
     throw0(DB_ERROR(lmdb_error("Failed to sync database: ", result).c_str()));
   }
+  if (m_cold_env)
+  {
+    if (auto result = mdb_env_sync(m_cold_env, true))
+      throw0(DB_ERROR(lmdb_error("Failed to sync cold database: ", result).c_str()));
+  }
 }
 
 void BlockchainLMDB::safesyncmode(const bool onoff)
 {
   MINFO("switching safe mode " << (onoff ? "on" : "off"));
   mdb_env_set_flags(m_env, MDB_NOSYNC|MDB_MAPASYNC, !onoff);
+  if (m_cold_env)
+    mdb_env_set_flags(m_cold_env, MDB_NOSYNC|MDB_MAPASYNC, !onoff);
 }
 
 void BlockchainLMDB::reset()
@@ -1457,7 +1749,17 @@ void BlockchainLMDB::reset()
     throw0(DB_ERROR(lmdb_error("Failed to drop m_block_heights: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_txs_pruned, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_txs_pruned: ", result).c_str()));
-  if (auto result = mdb_drop(txn, m_txs_prunable, 0))
+  if (m_cold_env)
+  {
+    // emptied first: leftover cold records past the last tx are dropped on open anyway
+    mdb_txn_safe cold_txn;
+    if (auto result = lmdb_txn_begin(m_cold_env, NULL, 0, cold_txn))
+      throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the cold db: ", result).c_str()));
+    if (auto result = mdb_drop(cold_txn, m_txs_prunable, 0))
+      throw0(DB_ERROR(lmdb_error("Failed to drop m_txs_prunable: ", result).c_str()));
+    cold_txn.commit();
+  }
+  else if (auto result = mdb_drop(txn, m_txs_prunable, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_txs_prunable: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_txs_prunable_hash, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_txs_prunable_hash: ", result).c_str()));
@@ -1482,6 +1784,13 @@ void BlockchainLMDB::reset()
   MDB_val_copy<uint32_t> v(VERSION);
   if (auto result = mdb_put(txn, m_properties, &k, &v, 0))
     throw0(DB_ERROR(lmdb_error("Failed to write version to database: ", result).c_str()));
+  if (m_cold_env)
+  {
+    MDB_val_copy<const char*> ck(LMDB_COLD_PRUNABLE_PROPERTY);
+    MDB_val_copy<uint32_t> cv(1);
+    if (auto result = mdb_put(txn, m_properties, &ck, &cv, 0))
+      throw0(DB_ERROR(lmdb_error("Failed to write cold data property to database: ", result).c_str()));
+  }
 
   txn.commit();
   m_cum_size = 0;
@@ -2309,7 +2618,7 @@ bool BlockchainLMDB::get_tx_blob(const crypto::hash& h, cryptonote::blobdata &bd
   TXN_PREFIX_RDONLY();
   RCURSOR(tx_indices);
   RCURSOR(txs_pruned);
-  RCURSOR(txs_prunable);
+  RCURSOR_PRUNABLE();
 
   MDB_val_set(v, h);
   MDB_val result0, result1;
@@ -2681,7 +2990,7 @@ bool BlockchainLMDB::for_all_transactions(std::function<bool(const crypto::hash&
 
   TXN_PREFIX_RDONLY();
   RCURSOR(txs_pruned);
-  RCURSOR(txs_prunable);
+  RCURSOR_PRUNABLE();
   RCURSOR(tx_indices);
 
   MDB_val k;
@@ -2871,6 +3180,7 @@ void BlockchainLMDB::batch_commit()
 
   LOG_PRINT_L3("batch transaction: committing...");
   TIME_MEASURE_START(time1);
+  commit_cold_write_txn();
   m_write_txn->commit();
   TIME_MEASURE_FINISH(time1);
   time_commit1 += time1;
@@ -2880,11 +3190,13 @@ void BlockchainLMDB::batch_commit()
   delete m_write_batch_txn;
   m_write_batch_txn = nullptr;
   memset(&m_wcursors, 0, sizeof(m_wcursors));
+  apply_cold_deletes();
 }
 
 void BlockchainLMDB::cleanup_batch()
 {
   // for destruction of batch transaction
+  abort_cold_write_txn();
   m_write_txn = nullptr;
   delete m_write_batch_txn;
   m_write_batch_txn = nullptr;
@@ -2906,15 +3218,22 @@ void BlockchainLMDB::batch_stop()
   check_open();
   LOG_PRINT_L3("batch transaction: committing...");
   TIME_MEASURE_START(time1);
+  bool committed = false;
   try
   {
+    commit_cold_write_txn();
     m_write_txn->commit();
+    committed = true;
     TIME_MEASURE_FINISH(time1);
     time_commit1 += time1;
     cleanup_batch();
+    apply_cold_deletes();
   }
   catch (const std::exception &e)
   {
+    // once the main txn is in, pending cold deletes stay queued for the next commit
+    if (!committed)
+      m_cold_deletes.clear();
     cleanup_batch();
     throw;
   }
@@ -2935,6 +3254,8 @@ void BlockchainLMDB::batch_abort()
   check_open();
   // for destruction of batch transaction
   m_write_txn = nullptr;
+  abort_cold_write_txn();
+  m_cold_deletes.clear();
   // explicitly call in case mdb_env_close() (BlockchainLMDB::close()) called before BlockchainLMDB destructor called.
   m_write_batch_txn->abort();
   delete m_write_batch_txn;
@@ -2974,6 +3295,7 @@ bool BlockchainLMDB::block_rtxn_start(MDB_txn **mtxn, mdb_txn_cursors **mcur) co
     m_tinfo.reset(tinfo);
     memset(&tinfo->m_ti_rcursors, 0, sizeof(tinfo->m_ti_rcursors));
     memset(&tinfo->m_ti_rflags, 0, sizeof(tinfo->m_ti_rflags));
+    tinfo->m_ti_cold_rtxn = nullptr;
     if (auto mdb_res = lmdb_txn_begin(m_env, NULL, MDB_RDONLY, &tinfo->m_ti_rtxn))
       throw0(DB_ERROR_TXN_START(lmdb_error("Failed to create a read transaction for the db: ", mdb_res).c_str()));
     ret = true;
@@ -2997,6 +3319,8 @@ void BlockchainLMDB::block_rtxn_stop() const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   mdb_txn_reset(m_tinfo->m_ti_rtxn);
+  if (m_tinfo->m_ti_cold_rtxn)
+    mdb_txn_reset(m_tinfo->m_ti_cold_rtxn);
   memset(&m_tinfo->m_ti_rflags, 0, sizeof(m_tinfo->m_ti_rflags));
 }
 
@@ -3049,6 +3373,7 @@ void BlockchainLMDB::block_txn_stop()
     if (! m_batch_active)
 	{
       TIME_MEASURE_START(time1);
+      commit_cold_write_txn();
       m_write_txn->commit();
       TIME_MEASURE_FINISH(time1);
       time_commit1 += time1;
@@ -3056,11 +3381,14 @@ void BlockchainLMDB::block_txn_stop()
       delete m_write_txn;
       m_write_txn = nullptr;
       memset(&m_wcursors, 0, sizeof(m_wcursors));
+      apply_cold_deletes();
 	}
   }
   else if (m_tinfo->m_ti_rtxn)
   {
     mdb_txn_reset(m_tinfo->m_ti_rtxn);
+    if (m_tinfo->m_ti_cold_rtxn)
+      mdb_txn_reset(m_tinfo->m_ti_cold_rtxn);
     memset(&m_tinfo->m_ti_rflags, 0, sizeof(m_tinfo->m_ti_rflags));
   }
 }
@@ -3072,6 +3400,8 @@ void BlockchainLMDB::block_txn_abort()
   {
     if (! m_batch_active)
     {
+      abort_cold_write_txn();
+      m_cold_deletes.clear();
       delete m_write_txn;
       m_write_txn = nullptr;
       memset(&m_wcursors, 0, sizeof(m_wcursors));
@@ -3080,6 +3410,8 @@ void BlockchainLMDB::block_txn_abort()
   else if (m_tinfo->m_ti_rtxn)
   {
     mdb_txn_reset(m_tinfo->m_ti_rtxn);
+    if (m_tinfo->m_ti_cold_rtxn)
+      mdb_txn_reset(m_tinfo->m_ti_cold_rtxn);
     memset(&m_tinfo->m_ti_rflags, 0, sizeof(m_tinfo->m_ti_rflags));
   }
   else
@@ -3488,6 +3820,19 @@ bool BlockchainLMDB::is_read_only() const
   return false;
 }
 
+uint64_t BlockchainLMDB::get_last_txn_id() const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  // the last txn id is read from the shared meta pages, so it also sees commits
+  // made by other processes
+  MDB_envinfo mei;
+  if (auto result = mdb_env_info(m_env, &mei))
+    throw0(DB_ERROR(lmdb_error("Error getting database environment info: ", result).c_str()));
+  return mei.me_last_txnid;
+}
+
 uint64_t BlockchainLMDB::get_database_size() const
 {
   uint64_t size = 0;
@@ -3495,9 +3840,103 @@ uint64_t BlockchainLMDB::get_database_size() const
   datafile /= CRYPTONOTE_BLOCKCHAINDATA_FILENAME;
   if (!epee::file_io_utils::get_file_size(datafile.string(), size))
     size = 0;
+  if (m_cold_env)
+  {
+    uint64_t cold_size = 0;
+    boost::filesystem::path cold_datafile(m_cold_folder);
+    cold_datafile /= CRYPTONOTE_BLOCKCHAINDATA_FILENAME;
+    if (epee::file_io_utils::get_file_size(cold_datafile.string(), cold_size))
+      size += cold_size;
+  }
   return size;
 }
 
+void BlockchainLMDB::copy_compacted(const std::string& path) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  if (m_cold_env)
+    throw0(DB_ERROR("Copying a db with a cold data folder is not supported"));
+
+  boost::filesystem::path direc(path);
+  if (!boost::filesystem::exists(direc) && !boost::filesystem::create_directories(direc))
+    throw0(DB_ERROR(std::string("Failed to create directory ").append(path).c_str()));
+
+  if (auto result = mdb_env_copy2(m_env, path.c_str(), MDB_CP_COMPACT))
+    throw0(DB_ERROR(lmdb_error("Failed to copy database: ", result).c_str()));
+}
+
+std::vector<std::pair<std::string, crypto::hash>> BlockchainLMDB::get_table_hashes() const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  const std::pair<const char*, MDB_dbi> tables[] = {
+    { LMDB_BLOCKS, m_blocks },
+    { LMDB_BLOCK_HEIGHTS, m_block_heights },
+    { LMDB_BLOCK_INFO, m_block_info },
+    { LMDB_TXS, m_txs },
+    { LMDB_TXS_PRUNED, m_txs_pruned },
+    { LMDB_TXS_PRUNABLE, m_txs_prunable },
+    { LMDB_TXS_PRUNABLE_HASH, m_txs_prunable_hash },
+    { LMDB_TX_INDICES, m_tx_indices },
+    { LMDB_TX_OUTPUTS, m_tx_outputs },
+    { LMDB_OUTPUT_TXS, m_output_txs },
+    { LMDB_OUTPUT_AMOUNTS, m_output_amounts },
+    { LMDB_SPENT_KEYS, m_spent_keys },
+    { LMDB_TXPOOL_META, m_txpool_meta },
+    { LMDB_TXPOOL_BLOB, m_txpool_blob },
+    { LMDB_HF_VERSIONS, m_hf_versions },
+    { LMDB_PROPERTIES, m_properties },
+  };
+
+  TXN_PREFIX_RDONLY();
+
+  mdb_txn_safe cold_txn;
+  if (m_cold_env)
+  {
+    if (auto result = lmdb_txn_begin(m_cold_env, NULL, MDB_RDONLY, cold_txn))
+      throw0(DB_ERROR(lmdb_error("Failed to create a read transaction for the cold db: ", result).c_str()));
+  }
+
+  std::vector<std::pair<std::string, crypto::hash>> hashes;
+  for (const auto &table: tables)
+  {
+    MDB_txn *txn = m_cold_env && table.first == LMDB_TXS_PRUNABLE ? (MDB_txn*)cold_txn : m_txn;
+    MDB_cursor *cur;
+    if (auto result = mdb_cursor_open(txn, table.second, &cur))
+      throw0(DB_ERROR(lmdb_error(std::string("Failed to open cursor for ") + table.first + ": ", result).c_str()));
+
+    // each record is hashed as key size, key, value size, value
+    KECCAK_CTX ctx;
+    keccak_init(&ctx);
+    MDB_val k, v;
+    MDB_cursor_op op = MDB_FIRST;
+    int result;
+    while ((result = mdb_cursor_get(cur, &k, &v, op)) == 0)
+    {
+      op = MDB_NEXT;
+      const uint64_t ksize = SWAP64LE((uint64_t)k.mv_size), vsize = SWAP64LE((uint64_t)v.mv_size);
+      keccak_update(&ctx, (const uint8_t*)&ksize, sizeof(ksize));
+      keccak_update(&ctx, (const uint8_t*)k.mv_data, k.mv_size);
+      keccak_update(&ctx, (const uint8_t*)&vsize, sizeof(vsize));
+      keccak_update(&ctx, (const uint8_t*)v.mv_data, v.mv_size);
+    }
+    mdb_cursor_close(cur);
+    if (result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error(std::string("Failed to enumerate ") + table.first + ": ", result).c_str()));
+
+    crypto::hash hash;
+    keccak_finish(&ctx, (uint8_t*)hash.data);
+    hashes.push_back(std::make_pair(std::string(table.first), hash));
+  }
+
+  TXN_POSTFIX_RDONLY();
+
+  return hashes;
+}
+
 void BlockchainLMDB::fixup()
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
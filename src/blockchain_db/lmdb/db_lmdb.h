@@ -28,6 +28,7 @@
 #pragma once
 
 #include <atomic>
+#include <set>
 
 #include "blockchain_db/blockchain_db.h"
 #include "cryptonote_basic/blobdatatype.h" // for type blobdata
@@ -104,6 +105,7 @@ typedef struct mdb_rflags
 typedef struct mdb_threadinfo
 {
   MDB_txn *m_ti_rtxn;	// per-thread read txn
+  MDB_txn *m_ti_cold_rtxn;	// per-thread read txn on the cold environment, if any
   mdb_txn_cursors m_ti_rcursors;	// per-thread read cursors
   mdb_rflags m_ti_rflags;	// per-thread read state
 
@@ -170,6 +172,8 @@ public:
   BlockchainLMDB(bool batch_transactions=true);
   ~BlockchainLMDB();
 
+  virtual void set_cold_data_folder(const std::string& folder);
+
   virtual void open(const std::string& filename, const int mdb_flags=0);
 
   virtual void close();
@@ -419,8 +423,14 @@ private:
 
   virtual bool is_read_only() const;
 
+  virtual uint64_t get_last_txn_id() const;
+
   virtual uint64_t get_database_size() const;
 
+  virtual void copy_compacted(const std::string& path) const;
+
+  virtual std::vector<std::pair<std::string, crypto::hash>> get_table_hashes() const;
+
   // fix up anything that may be wrong due to past bugs
   virtual void fixup();
 
@@ -438,8 +448,23 @@ private:
 
   void cleanup_batch();
 
+  // open the cold environment holding prunable tx data, within the open txn
+  void open_cold(int mdb_flags, MDB_txn *txn);
+
+  // the write txn on the cold environment, started alongside m_write_txn
+  MDB_txn *cold_write_txn() const;
+
+  // start or renew this thread's cold read txn and prunable cursor
+  void cold_read_cursor(mdb_txn_cursors *cursors) const;
+
+  // commit order is cold writes, then m_write_txn, then cold deletes
+  void commit_cold_write_txn();
+  void apply_cold_deletes();
+  void abort_cold_write_txn();
+
 private:
   MDB_env* m_env;
+  MDB_env* m_cold_env; // prunable tx data, if kept apart from the rest
 
   MDB_dbi m_blocks;
   MDB_dbi m_block_heights;
@@ -468,7 +493,10 @@ private:
   mutable uint64_t m_cum_size;	// used in batch size estimation
   mutable unsigned int m_cum_count;
   std::string m_folder;
+  std::string m_cold_folder;
   mdb_txn_safe* m_write_txn; // may point to either a short-lived txn or a batch txn
+  mutable mdb_txn_safe* m_cold_write_txn;
+  std::set<uint64_t> m_cold_deletes; // tx ids to remove from the cold environment once m_write_txn is committed
   mdb_txn_safe* m_write_batch_txn; // persist batch txn outside of BlockchainLMDB
   boost::thread::id m_writer;
 
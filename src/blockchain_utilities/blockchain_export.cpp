@@ -30,8 +30,10 @@
 #include "bootstrap_file.h"
 #include "blocksdat_file.h"
 #include "common/command_line.h"
+#include "common/util.h"
 #include "cryptonote_core/tx_pool.h"
 #include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/snapshot.h"
 #include "blockchain_db/blockchain_db.h"
 #include "blockchain_db/db_types.h"
 #include "version.h"
@@ -70,6 +72,8 @@ int main(int argc, char* argv[])
     "database", available_dbs.c_str(), default_db_type
   };
   const command_line::arg_descriptor<bool> arg_blocks_dat = {"blocksdat", "Output in blocks.dat format", blocks_dat};
+  const command_line::arg_descriptor<unsigned int> arg_threads = {"threads", "Number of block reader threads", std::max(1u, tools::get_max_concurrency())};
+  const command_line::arg_descriptor<std::string> arg_snapshot = {"snapshot", "Write a compacted database snapshot to this directory instead of a raw export", ""};
 
 
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_data_dir);
@@ -78,8 +82,11 @@ int main(int argc, char* argv[])
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_stagenet_on);
   command_line::add_arg(desc_cmd_sett, arg_log_level);
   command_line::add_arg(desc_cmd_sett, arg_database);
+  command_line::add_arg(desc_cmd_sett, cryptonote::arg_db_cold_data_dir);
   command_line::add_arg(desc_cmd_sett, arg_block_stop);
   command_line::add_arg(desc_cmd_sett, arg_blocks_dat);
+  command_line::add_arg(desc_cmd_sett, arg_threads);
+  command_line::add_arg(desc_cmd_sett, arg_snapshot);
 
   command_line::add_arg(desc_cmd_only, command_line::arg_help);
 
@@ -120,6 +127,12 @@ int main(int argc, char* argv[])
     return 1;
   }
   bool opt_blocks_dat = command_line::get_arg(vm, arg_blocks_dat);
+  unsigned int opt_threads = command_line::get_arg(vm, arg_threads);
+  if (opt_threads == 0 || opt_threads > EXPORT_MAX_READER_THREADS)
+  {
+    std::cerr << "Number of threads must be between 1 and " << EXPORT_MAX_READER_THREADS << std::endl;
+    return 1;
+  }
 
   std::string m_config_folder;
 
@@ -169,6 +182,7 @@ int main(int argc, char* argv[])
   LOG_PRINT_L0("Loading blockchain from folder " << filename << " ...");
   try
   {
+    db->set_cold_data_folder(command_line::get_arg(vm, cryptonote::arg_db_cold_data_dir));
     db->open(filename, DBF_RDONLY);
   }
   catch (const std::exception& e)
@@ -180,17 +194,28 @@ int main(int argc, char* argv[])
 
   CHECK_AND_ASSERT_MES(r, 1, "Failed to initialize source blockchain storage");
   LOG_PRINT_L0("Source blockchain storage initialized OK");
+
+  const std::string snapshot_dir = command_line::get_arg(vm, arg_snapshot);
+  if (!snapshot_dir.empty())
+  {
+    LOG_PRINT_L0("Writing blockchain snapshot...");
+    r = create_snapshot(core_storage->get_db(), snapshot_dir);
+    CHECK_AND_ASSERT_MES(r, 1, "Failed to write blockchain snapshot");
+    LOG_PRINT_L0("Blockchain snapshot written OK");
+    return 0;
+  }
+
   LOG_PRINT_L0("Exporting blockchain raw data...");
 
   if (opt_blocks_dat)
   {
     BlocksdatFile blocksdat;
-    r = blocksdat.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop);
+    r = blocksdat.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop, opt_threads);
   }
   else
   {
     BootstrapFile bootstrap;
-    r = bootstrap.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop);
+    r = bootstrap.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop, opt_threads);
   }
   CHECK_AND_ASSERT_MES(r, 1, "Failed to export blockchain raw data");
   LOG_PRINT_L0("Blockchain raw data exported OK");
@@ -28,6 +28,7 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <algorithm>
 #include <fstream>
@@ -44,6 +45,10 @@
 #include "include_base_utils.h"
 #include "blockchain_db/db_types.h"
 #include "cryptonote_core/cryptonote_core.h"
+#include "mining/miningutil.h"
+#include "ringct/rctSigs.h"
+#include "common/util.h"
+#include "ordered_pipeline.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "bcutil"
@@ -70,6 +75,20 @@ uint64_t db_batch_size = 100;
 // frequently saved
 uint64_t db_batch_size_verify = 5000;
 
+// a batch is also committed once it holds this many bytes of blocks, so the
+// number of blocks per batch adapts to their size
+#if ARCH_WIDTH != 32
+uint64_t db_batch_bytes = 512 * 1024 * 1024;
+#else
+uint64_t db_batch_bytes = 64 * 1024 * 1024;
+#endif
+
+// number of blocks parsed and pre-verified by a worker at a time, range
+// proofs are batch verified across all of them
+const size_t import_blocks_per_work_item = 50;
+
+unsigned int opt_threads = 1;
+
 std::string refresh_string = "\r                                    \r";
 }
 
@@ -166,11 +185,11 @@ int pop_blocks(cryptonote::core& core, int num_blocks)
   return num_blocks;
 }
 
-int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &blocks, bool force)
+int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &blocks, uint64_t blocks_bytes, std::vector<crypto::hash> &preverified_txs, bool force)
 {
   if (blocks.empty())
     return 0;
-  if (!force && blocks.size() < db_batch_size)
+  if (!force && blocks.size() < db_batch_size && blocks_bytes < db_batch_bytes)
     return 0;
 
   // wait till we can verify a full HOH without extra, for speed
@@ -178,6 +197,10 @@ int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &block
   if (!force && new_height % HASH_OF_HASHES_STEP)
     return 0;
 
+  // range proofs of these were batch verified by the pre-verification workers
+  core.add_semantics_preverified_txs(preverified_txs);
+  preverified_txs.clear();
+
   std::vector<crypto::hash> hashes;
   for (const auto &b: blocks)
   {
@@ -215,14 +238,14 @@ int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &block
   for(const block_complete_entry& block_entry: blocks)
   {
     // process transactions
-    for(auto& tx_blob: block_entry.txs)
+    std::vector<tx_verification_context> tvc;
+    core.handle_incoming_txs(block_entry.txs, tvc, true, true, false);
+    for (size_t i = 0; i < tvc.size(); ++i)
     {
-      tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-      core.handle_incoming_tx(tx_blob, tvc, true, true, false);
-      if(tvc.m_verifivation_failed)
+      if(tvc[i].m_verifivation_failed)
       {
         MERROR("transaction verification failed, tx_id = "
-            << epee::string_tools::pod_to_hex(get_blob_hash(tx_blob)));
+            << epee::string_tools::pod_to_hex(get_blob_hash(block_entry.txs[i])));
         core.cleanup_handle_incoming_blocks();
         return 1;
       }
@@ -256,6 +279,98 @@ int check_flush(cryptonote::core &core, std::vector<block_complete_entry> &block
   return 0;
 }
 
+// raw chunks as read from the bootstrap file
+struct import_chunks
+{
+  uint64_t height; // zero-based height of the first block
+  std::vector<std::string> blobs;
+};
+
+struct preverified_block
+{
+  bootstrap::block_package package;
+  block_complete_entry entry; // only filled in when verifying
+  crypto::hash hash;
+  crypto::hash prev_hash; // hash of the parent, taken from the PoS stamp for PoS blocks
+  crypto::hash pos_hash;
+  std::vector<crypto::hash> preverified_txs; // txs of this block whose rct semantics passed
+  size_t size;
+};
+
+// Parses a run of chunks and does all the checks which don't depend on chain
+// state: block and tx hashes, PoS hashes, and batch verification of the rct
+// semantics (including range proofs) of every tx in the run.
+bool preverify_blocks(const import_chunks &chunks, std::vector<preverified_block> &blocks)
+{
+  blocks.resize(chunks.blobs.size());
+  std::vector<const rct::rctSig*> rvv;
+  std::vector<const rct::rctSig*> rvvb;
+  std::vector<std::pair<size_t, crypto::hash>> rv_hashes; // block index and tx hash
+  for (size_t n = 0; n < chunks.blobs.size(); ++n)
+  {
+    preverified_block &pb = blocks[n];
+    if (! ::serialization::parse_binary(chunks.blobs[n], pb.package))
+      throw std::runtime_error("Error in deserialization of chunk");
+    pb.size = chunks.blobs[n].size();
+
+    const block &b = pb.package.block;
+    pb.hash = get_block_hash(b);
+    pb.prev_hash = b.prev_id;
+    pb.pos_hash = pb.hash;
+    if (b.major_version >= HF_VERSION_POS)
+    {
+      tx_extra_pos_stamp ps;
+      if (pb.package.txs.empty() || pb.package.txs[0].vin.size() != 1 || pb.package.txs[0].vin[0].type() != typeid(txin_to_key)
+          || !get_pos_stamp(pb.package.txs[0], ps))
+      {
+        MERROR("Bad coinstake transaction in block " << pb.hash << " at height " << chunks.height + n);
+        return false;
+      }
+      pb.prev_hash = ps.crypto_hash;
+      mining::find_pos_hash(boost::get<txin_to_key>(pb.package.txs[0].vin[0]).k_image, b.prev_id, pb.pos_hash);
+    }
+
+    if (!opt_verify)
+      continue;
+
+    cryptonote::block_to_blob(b, pb.entry.block);
+    pb.entry.txs.reserve(pb.package.txs.size());
+    for (const auto &tx: pb.package.txs)
+    {
+      pb.entry.txs.push_back(cryptonote::blobdata());
+      cryptonote::tx_to_blob(tx, pb.entry.txs.back());
+      if (tx.version < TxVersion::ring_signatures)
+        continue;
+      const rct::rctSig &rv = tx.rct_signatures;
+      if (rv.type == rct::RctType::RCTTypeBulletproof)
+      {
+        rvv.push_back(&rv);
+        rv_hashes.push_back(std::make_pair(n, get_transaction_hash(tx)));
+      }
+      else if (rv.type == rct::RctType::RCTTypeBigBulletproof)
+      {
+        rvvb.push_back(&rv);
+        rv_hashes.push_back(std::make_pair(n, get_transaction_hash(tx)));
+      }
+    }
+  }
+
+  if (!rvv.empty() && !rct::verRctSemanticsSimple(rvv))
+  {
+    MERROR("Bulletproof batch verification failed for blocks " << chunks.height << " - " << chunks.height + blocks.size() - 1);
+    return false;
+  }
+  if (!rvvb.empty() && !rct::verRctSemanticsSimpleBig(rvvb))
+  {
+    MERROR("BigBulletproof batch verification failed for blocks " << chunks.height << " - " << chunks.height + blocks.size() - 1);
+    return false;
+  }
+
+  for (const auto &h: rv_hashes)
+    blocks[h.first].preverified_txs.push_back(h.second);
+  return true;
+}
+
 int import_from_file(cryptonote::core& core, const std::string& import_file_path, uint64_t block_stop=0)
 {
   // Reset stats, in case we're using newly created db, accumulating stats
@@ -305,11 +420,6 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
   // 4 byte magic + (currently) 1024 byte header structures
   bootstrap.seek_to_first_chunk(import_file);
 
-  std::string str1;
-  char buffer1[1024];
-  char buffer_block[BUFFER_SIZE];
-  block b;
-  transaction tx;
   int quit = 0;
   uint64_t bytes_read;
 
@@ -327,11 +437,14 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
       block_stop);
 
   bool use_batch = opt_batch && !opt_verify;
+  bool batch_active = false;
 
   MINFO("Reading blockchain from bootstrap file...");
   std::cout << ENDL;
 
   std::vector<block_complete_entry> blocks;
+  uint64_t blocks_bytes = 0;
+  std::vector<crypto::hash> preverified_txs;
 
   // Skip to start_height before we start adding.
   {
@@ -346,213 +459,206 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
     h = start_height;
   }
 
-  if (use_batch)
   {
-    uint64_t bytes, h2;
-    bool q2;
-    pos = import_file.tellg();
-    bytes = bootstrap.count_bytes(import_file, db_batch_size, h2, q2);
-    if (import_file.eof())
-      import_file.clear();
-    import_file.seekg(pos);
-    core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
-  }
-  while (! quit)
-  {
-    uint32_t chunk_size;
-    import_file.read(buffer1, sizeof(chunk_size));
-    // TODO: bootstrap.read_chunk();
-    if (! import_file) {
-      std::cout << refresh_string;
-      MINFO("End of file reached");
-      quit = 1;
-      break;
-    }
-    bytes_read += sizeof(chunk_size);
+  MINFO("Pre-verifying with " << opt_threads << " thread(s)");
 
-    str1.assign(buffer1, sizeof(chunk_size));
-    if (! ::serialization::parse_binary(str1, chunk_size))
+  // Stage 1, on one worker at a time: read raw chunks from the file.
+  uint64_t read_height = h;
+  bool read_done = false;
+  auto read_chunks = [&](import_chunks &chunks) -> bool
+  {
+    chunks.height = read_height;
+    chunks.blobs.clear();
+    char buffer1[1024];
+    std::string str1;
+    while (!read_done && chunks.blobs.size() < import_blocks_per_work_item)
     {
-      throw std::runtime_error("Error in deserialization of chunk size");
-    }
-    MDEBUG("chunk_size: " << chunk_size);
+      uint32_t chunk_size;
+      import_file.read(buffer1, sizeof(chunk_size));
+      // TODO: bootstrap.read_chunk();
+      if (! import_file) {
+        MINFO("End of file reached");
+        read_done = true;
+        break;
+      }
+      bytes_read += sizeof(chunk_size);
 
-    if (chunk_size > BUFFER_SIZE)
-    {
-      MWARNING("WARNING: chunk_size " << chunk_size << " > BUFFER_SIZE " << BUFFER_SIZE);
-      throw std::runtime_error("Aborting: chunk size exceeds buffer size");
-    }
-    if (chunk_size > CHUNK_SIZE_WARNING_THRESHOLD)
-    {
-      MINFO("NOTE: chunk_size " << chunk_size << " > " << CHUNK_SIZE_WARNING_THRESHOLD);
-    }
-    else if (chunk_size == 0) {
-      MFATAL("ERROR: chunk_size == 0");
-      return 2;
-    }
-    import_file.read(buffer_block, chunk_size);
-    if (! import_file) {
-      if (import_file.eof())
+      str1.assign(buffer1, sizeof(chunk_size));
+      if (! ::serialization::parse_binary(str1, chunk_size))
       {
-        std::cout << refresh_string;
-        MINFO("End of file reached - file was truncated");
-        quit = 1;
-        break;
+        throw std::runtime_error("Error in deserialization of chunk size");
       }
-      else
+      MDEBUG("chunk_size: " << chunk_size);
+
+      if (chunk_size > BUFFER_SIZE)
       {
-        MFATAL("ERROR: unexpected end of file: bytes read before error: "
-            << import_file.gcount() << " of chunk_size " << chunk_size);
-        return 2;
+        MWARNING("WARNING: chunk_size " << chunk_size << " > BUFFER_SIZE " << BUFFER_SIZE);
+        throw std::runtime_error("Aborting: chunk size exceeds buffer size");
       }
-    }
-    bytes_read += chunk_size;
-    MDEBUG("Total bytes read: " << bytes_read);
+      if (chunk_size > CHUNK_SIZE_WARNING_THRESHOLD)
+      {
+        MINFO("NOTE: chunk_size " << chunk_size << " > " << CHUNK_SIZE_WARNING_THRESHOLD);
+      }
+      else if (chunk_size == 0) {
+        throw std::runtime_error("ERROR: chunk_size == 0");
+      }
+      std::string blob(chunk_size, '\0');
+      import_file.read(&blob[0], chunk_size);
+      if (! import_file) {
+        if (import_file.eof())
+        {
+          MINFO("End of file reached - file was truncated");
+          read_done = true;
+          break;
+        }
+        else
+        {
+          MFATAL("ERROR: unexpected end of file: bytes read before error: "
+              << import_file.gcount() << " of chunk_size " << chunk_size);
+          throw std::runtime_error("Aborting: unexpected end of file");
+        }
+      }
+      bytes_read += chunk_size;
+      MDEBUG("Total bytes read: " << bytes_read);
 
-    if (h > block_stop)
-    {
-      std::cout << refresh_string << "block " << h-1
-        << " / " << block_stop
-        << std::flush;
-      std::cout << ENDL << ENDL;
-      MINFO("Specified block number reached - stopping.  block: " << h-1 << "  total blocks: " << h);
-      quit = 1;
-      break;
+      if (read_height > block_stop)
+      {
+        MINFO("Specified block number reached - stopping.  block: " << read_height-1 << "  total blocks: " << read_height);
+        read_done = true;
+        break;
+      }
+      chunks.blobs.push_back(std::move(blob));
+      // NOTE: use of NUM_BLOCKS_PER_CHUNK is a placeholder in case multi-block chunks are later supported.
+      read_height += NUM_BLOCKS_PER_CHUNK;
     }
+    return !chunks.blobs.empty();
+  };
 
-    try
+  // Stage 3, on this thread: commit the pre-verified blocks in file order.
+  const int progress_interval = 10;
+  const auto start_time = std::chrono::steady_clock::now();
+  crypto::hash last_hash = crypto::null_hash, last_pos_hash = crypto::null_hash;
+  uint64_t batch_blocks = 0, batch_bytes = 0, total_bytes = 0;
+  auto commit_blocks = [&](std::vector<preverified_block> &pblocks) -> bool
+  {
+    for (preverified_block &pb: pblocks)
     {
-      str1.assign(buffer_block, chunk_size);
-      bootstrap::block_package bp;
-      if (! ::serialization::parse_binary(str1, bp))
-        throw std::runtime_error("Error in deserialization of chunk");
+      // the chain linkage is the one check that needs the preceding run
+      if (last_hash != crypto::null_hash && (pb.prev_hash != last_hash || pb.package.block.prev_id != last_pos_hash))
+      {
+        MFATAL("Block " << pb.hash << " at height " << h << " does not follow the previous block");
+        return false;
+      }
+      last_hash = pb.hash;
+      last_pos_hash = pb.pos_hash;
+      total_bytes += pb.size;
 
-      int display_interval = 1000;
-      int progress_interval = 10;
-      // NOTE: use of NUM_BLOCKS_PER_CHUNK is a placeholder in case multi-block chunks are later supported.
-      for (int chunk_ind = 0; chunk_ind < NUM_BLOCKS_PER_CHUNK; ++chunk_ind)
+      ++h;
+      MDEBUG("loading block number " << h-1);
+      MDEBUG("block prev_id: " << pb.package.block.prev_id << ENDL);
+
+      if ((h-1) % progress_interval == 0)
+      {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        std::cout << refresh_string << "block " << h-1
+          << " / " << block_stop;
+        if (seconds > 0)
+          std::cout << ", " << (unsigned)(num_imported / seconds) << " blocks/s";
+        std::cout << std::flush;
+      }
+
+      if (opt_verify)
       {
-        ++h;
-        if ((h-1) % display_interval == 0)
+        blocks.push_back(std::move(pb.entry));
+        blocks_bytes += pb.size;
+        preverified_txs.insert(preverified_txs.end(), pb.preverified_txs.begin(), pb.preverified_txs.end());
+        int ret = check_flush(core, blocks, blocks_bytes, preverified_txs, false);
+        if (ret)
         {
-          std::cout << refresh_string;
-          MDEBUG("loading block number " << h-1);
+          quit = 2; // make sure we don't commit partial block data
+          return false;
         }
-        else
+        if (blocks.empty())
+          blocks_bytes = 0;
+      }
+      else
+      {
+        if (use_batch && !batch_active)
         {
-          MDEBUG("loading block number " << h-1);
+          // the reader is ahead of us, so size the batch from what was seen so far
+          const uint64_t bytes = total_bytes / (num_imported + 1) * db_batch_size;
+          core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
+          batch_active = true;
+          batch_blocks = 0;
+          batch_bytes = 0;
         }
-        b = bp.block;
-        MDEBUG("block prev_id: " << b.prev_id << ENDL);
 
-        if ((h-1) % progress_interval == 0)
+        // tx number 1: coinbase tx
+        // tx number 2 onwards: archived_txs
+        //
+        // add_block() calls add_transaction(blk_hash, blk.miner_tx) first, and
+        // then a for loop for the transactions in txs, so the coinbase
+        // transaction is not part of txs.
+        try
         {
-          std::cout << refresh_string << "block " << h-1
-            << " / " << block_stop
-            << std::flush;
+          core.get_blockchain_storage().get_db().add_block(pb.package.block, pb.package.block_weight,
+              pb.package.cumulative_difficulty, pb.package.coins_generated, pb.package.txs);
         }
-
-        if (opt_verify)
+        catch (const std::exception& e)
         {
-          cryptonote::blobdata block;
-          cryptonote::block_to_blob(bp.block, block);
-          std::vector<cryptonote::blobdata> txs;
-          for (const auto &tx: bp.txs)
-          {
-            txs.push_back(cryptonote::blobdata());
-            cryptonote::tx_to_blob(tx, txs.back());
-          }
-          blocks.push_back({block, txs});
-          int ret = check_flush(core, blocks, false);
-          if (ret)
-          {
-            quit = 2; // make sure we don't commit partial block data
-            break;
-          }
+          std::cout << refresh_string;
+          MFATAL("Error adding block to blockchain: " << e.what());
+          quit = 2; // make sure we don't commit partial block data
+          return false;
         }
-        else
+
+        // commit early when blocks are large, so the batch txn stays within the map size estimate
+        batch_bytes += pb.size;
+        if (use_batch && (++batch_blocks >= db_batch_size || batch_bytes >= db_batch_bytes))
         {
-          std::vector<transaction> txs;
-          std::vector<transaction> archived_txs;
-
-          archived_txs = bp.txs;
-
-          // tx number 1: coinbase tx
-          // tx number 2 onwards: archived_txs
-          for (const transaction &tx : archived_txs)
-          {
-            // add blocks with verification.
-            // for Blockchain and blockchain_storage add_new_block().
-            // for add_block() method, without (much) processing.
-            // don't add coinbase transaction to txs.
-            //
-            // because add_block() calls
-            // add_transaction(blk_hash, blk.miner_tx) first, and
-            // then a for loop for the transactions in txs.
-            txs.push_back(tx);
-          }
-
-          size_t block_weight;
-          difficulty_type cumulative_difficulty;
-          uint64_t coins_generated;
-
-          block_weight = bp.block_weight;
-          cumulative_difficulty = bp.cumulative_difficulty;
-          coins_generated = bp.coins_generated;
-
-          try
-          {
-            core.get_blockchain_storage().get_db().add_block(b, block_weight, cumulative_difficulty, coins_generated, txs);
-          }
-          catch (const std::exception& e)
-          {
-            std::cout << refresh_string;
-            MFATAL("Error adding block to blockchain: " << e.what());
-            quit = 2; // make sure we don't commit partial block data
-            break;
-          }
-
-          if (use_batch)
-          {
-            if ((h-1) % db_batch_size == 0)
-            {
-              uint64_t bytes, h2;
-              bool q2;
-              std::cout << refresh_string;
-              // zero-based height
-              std::cout << ENDL << "[- batch commit at height " << h-1 << " -]" << ENDL;
-              core.get_blockchain_storage().get_db().batch_stop();
-              pos = import_file.tellg();
-              bytes = bootstrap.count_bytes(import_file, db_batch_size, h2, q2);
-              import_file.seekg(pos);
-              core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
-              std::cout << ENDL;
-              core.get_blockchain_storage().get_db().show_stats();
-            }
-          }
+          std::cout << refresh_string;
+          // zero-based height
+          std::cout << ENDL << "[- batch commit at height " << h-1 << " -]" << ENDL;
+          core.get_blockchain_storage().get_db().batch_stop();
+          batch_active = false;
+          std::cout << ENDL;
+          core.get_blockchain_storage().get_db().show_stats();
         }
-        ++num_imported;
       }
+      ++num_imported;
     }
-    catch (const std::exception& e)
-    {
-      std::cout << refresh_string;
-      MFATAL("exception while reading from file, height=" << h << ": " << e.what());
-      return 2;
-    }
-  } // while
+    return true;
+  };
+
+  // Stage 2, on every worker: parse and run the stateless checks.
+  ordered_pipeline<import_chunks, std::vector<preverified_block>> pipeline(opt_threads, opt_threads * 2);
+  try
+  {
+    if (!pipeline.run(read_chunks, preverify_blocks, commit_blocks))
+      quit = 2;
+    else if (!quit)
+      quit = 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cout << refresh_string;
+    MFATAL("exception while importing, height=" << h << ": " << e.what());
+    quit = 2;
+  }
+  std::cout << refresh_string << "block " << h-1 << " / " << block_stop << ENDL;
+  }
 
 quitting:
   import_file.close();
 
-  if (opt_verify)
+  if (opt_verify && quit < 2)
   {
-    int ret = check_flush(core, blocks, true);
+    int ret = check_flush(core, blocks, blocks_bytes, preverified_txs, true);
     if (ret)
       return ret;
   }
 
-  if (use_batch)
+  if (batch_active)
   {
     if (quit > 1)
     {
@@ -572,7 +678,7 @@ quitting:
     MINFO("Finished at block: " << h-1 << "  total blocks: " << h);
 
   std::cout << ENDL;
-  return 0;
+  return quit > 1 ? 2 : 0;
 }
 
 int main(int argc, char* argv[])
@@ -602,6 +708,7 @@ int main(int argc, char* argv[])
   const command_line::arg_descriptor<std::string> arg_log_level   = {"log-level",  "0-4 or categories", ""};
   const command_line::arg_descriptor<uint64_t> arg_block_stop  = {"block-stop", "Stop at block number", block_stop};
   const command_line::arg_descriptor<uint64_t> arg_batch_size  = {"batch-size", "", db_batch_size};
+  const command_line::arg_descriptor<unsigned int> arg_threads  = {"threads", "Number of block pre-verification threads", std::max(1u, tools::get_max_concurrency())};
   const command_line::arg_descriptor<uint64_t> arg_pop_blocks  = {"pop-blocks", "Remove blocks from end of blockchain", num_blocks};
   const command_line::arg_descriptor<bool>        arg_drop_hf  = {"drop-hard-fork", "Drop hard fork subdbs", false};
   const command_line::arg_descriptor<bool>     arg_count_blocks = {
@@ -623,6 +730,7 @@ int main(int argc, char* argv[])
   command_line::add_arg(desc_cmd_sett, arg_log_level);
   command_line::add_arg(desc_cmd_sett, arg_database);
   command_line::add_arg(desc_cmd_sett, arg_batch_size);
+  command_line::add_arg(desc_cmd_sett, arg_threads);
   command_line::add_arg(desc_cmd_sett, arg_block_stop);
 
   command_line::add_arg(desc_cmd_only, arg_count_blocks);
@@ -657,6 +765,7 @@ int main(int argc, char* argv[])
   opt_resume    = command_line::get_arg(vm, arg_resume);
   block_stop    = command_line::get_arg(vm, arg_block_stop);
   db_batch_size = command_line::get_arg(vm, arg_batch_size);
+  opt_threads   = command_line::get_arg(vm, arg_threads);
 
   if (command_line::get_arg(vm, command_line::arg_help))
   {
@@ -675,6 +784,11 @@ int main(int argc, char* argv[])
     std::cerr << "Error: batch-size must be > 0" << ENDL;
     return 1;
   }
+  if (! opt_threads)
+  {
+    std::cerr << "Error: threads must be > 0" << ENDL;
+    return 1;
+  }
   if (opt_verify && command_line::is_arg_defaulted(vm, arg_batch_size))
   {
     // usually want batch size default lower if verify on, so progress can be
@@ -752,6 +866,7 @@ int main(int argc, char* argv[])
     MINFO("batch:   " << std::boolalpha << opt_batch << std::noboolalpha);
   }
   MINFO("resume:  " << std::boolalpha << opt_resume  << std::noboolalpha);
+  MINFO("threads: " << opt_threads);
   MINFO("nettype: " << (opt_testnet ? "testnet" : opt_stagenet ? "stagenet" : "mainnet"));
 
   MINFO("bootstrap file path: " << import_file_path);
@@ -107,6 +107,7 @@ int main(int argc, char* argv[])
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_stagenet_on);
   command_line::add_arg(desc_cmd_sett, arg_log_level);
   command_line::add_arg(desc_cmd_sett, arg_database);
+  command_line::add_arg(desc_cmd_sett, cryptonote::arg_db_cold_data_dir);
   command_line::add_arg(desc_cmd_sett, arg_rct_only);
   command_line::add_arg(desc_cmd_sett, arg_input);
   command_line::add_arg(desc_cmd_only, command_line::arg_help);
@@ -184,6 +185,7 @@ int main(int argc, char* argv[])
 
   try
   {
+    db->set_cold_data_folder(command_line::get_arg(vm, cryptonote::arg_db_cold_data_dir));
     db->open(filename, DBF_RDONLY);
   }
   catch (const std::exception& e)
@@ -37,5 +37,8 @@
 #define BUFFER_SIZE 1000000
 #define CHUNK_SIZE_WARNING_THRESHOLD 500000
 #define NUM_BLOCKS_PER_CHUNK 1
+#define EXPORT_BLOCKS_PER_RANGE 64
+// each reader holds an LMDB reader slot
+#define EXPORT_MAX_READER_THREADS 64
 #define BLOCKCHAIN_RAW "blockchain.raw"
 
@@ -28,6 +28,7 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "blocksdat_file.h"
+#include "ordered_pipeline.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "bcutil"
@@ -125,12 +126,11 @@ bool BlocksdatFile::close()
 }
 
 
-bool BlocksdatFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_memory_pool* _tx_pool, boost::filesystem::path& output_file, uint64_t requested_block_stop)
+bool BlocksdatFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_memory_pool* _tx_pool, boost::filesystem::path& output_file, uint64_t requested_block_stop, unsigned int num_threads)
 {
   uint64_t num_blocks_written = 0;
   m_blockchain_storage = _blockchain_storage;
   uint64_t progress_interval = 100;
-  block b;
 
   uint64_t block_start = 0;
   uint64_t block_stop = 0;
@@ -151,18 +151,60 @@ bool BlocksdatFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
     MFATAL("failed to open raw file for write");
     return false;
   }
-  for (m_cur_height = block_start; m_cur_height <= block_stop; ++m_cur_height)
+  if (num_threads == 0)
+    num_threads = 1;
+
+  typedef std::pair<uint64_t, uint64_t> range_type;
+  uint64_t next_height = block_start;
+  m_cur_height = block_start;
+  ordered_pipeline<range_type, std::vector<crypto::hash>> pipeline(num_threads, num_threads * 4);
+  const bool r = pipeline.run(
+    [&](range_type &range) {
+      if (next_height > block_stop)
+        return false;
+      range.first = next_height;
+      range.second = std::min(next_height + EXPORT_BLOCKS_PER_RANGE - 1, block_stop);
+      next_height = range.second + 1;
+      return true;
+    },
+    [this](range_type &range, std::vector<crypto::hash> &hashes) {
+      BlockchainDB &db = m_blockchain_storage->get_db();
+      db.block_txn_start(true);
+      try
+      {
+        hashes.clear();
+        // this method's height refers to 0-based height (genesis block = height 0)
+        for (uint64_t height = range.first; height <= range.second; ++height)
+          hashes.push_back(db.get_block_hash_from_height(height));
+      }
+      catch (...)
+      {
+        db.block_txn_stop();
+        throw;
+      }
+      db.block_txn_stop();
+      return true;
+    },
+    [&](std::vector<crypto::hash> &hashes) {
+      for (const crypto::hash &hash: hashes)
+      {
+        write_block(hash);
+        if (m_cur_height % NUM_BLOCKS_PER_CHUNK == 0) {
+          num_blocks_written += NUM_BLOCKS_PER_CHUNK;
+        }
+        if (m_cur_height % progress_interval == 0) {
+          std::cout << refresh_string;
+          std::cout << "block " << m_cur_height << "/" << block_stop << std::flush;
+        }
+        ++m_cur_height;
+      }
+      return true;
+    });
+  if (!r)
   {
-    // this method's height refers to 0-based height (genesis block = height 0)
-    crypto::hash hash = m_blockchain_storage->get_block_id_by_height(m_cur_height);
-    write_block(hash);
-    if (m_cur_height % NUM_BLOCKS_PER_CHUNK == 0) {
-      num_blocks_written += NUM_BLOCKS_PER_CHUNK;
-    }
-    if (m_cur_height % progress_interval == 0) {
-      std::cout << refresh_string;
-      std::cout << "block " << m_cur_height << "/" << block_stop << std::flush;
-    }
+    MFATAL("Failed to export block hashes, stopped at height " << m_cur_height);
+    BlocksdatFile::close();
+    return false;
   }
   // print message for last block, which may not have been printed yet due to progress_interval
   std::cout << refresh_string;
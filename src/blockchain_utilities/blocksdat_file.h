@@ -60,7 +60,7 @@ class BlocksdatFile
 public:
 
   bool store_blockchain_raw(cryptonote::Blockchain* cs, cryptonote::tx_memory_pool* txp,
-      boost::filesystem::path& output_file, uint64_t use_block_height=0);
+      boost::filesystem::path& output_file, uint64_t use_block_height=0, unsigned int num_threads=1);
 
 protected:
 
@@ -32,6 +32,9 @@
 #include "serialization/json_utils.h" // dump_json()
 
 #include "bootstrap_file.h"
+#include "ordered_pipeline.h"
+
+#include <chrono>
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "bcutil"
@@ -208,7 +211,7 @@ void BootstrapFile::flush_chunk()
   MDEBUG("flushed chunk:  chunk_size: " << chunk_size);
 }
 
-void BootstrapFile::write_block(block& block)
+blobdata BootstrapFile::serialize_block(const block& block) const
 {
   bootstrap::block_package bp;
   bp.block = block;
@@ -246,8 +249,39 @@ void BootstrapFile::write_block(block& block)
     bp.coins_generated = coins_generated;
   }
 
-  blobdata bd = t_serializable_object_to_blob(bp);
-  m_output_stream->write((const char*)bd.data(), bd.size());
+  return t_serializable_object_to_blob(bp);
+}
+
+bool BootstrapFile::read_blocks(uint64_t first, uint64_t last, std::vector<blobdata>& blobs) const
+{
+  BlockchainDB &db = m_blockchain_storage->get_db();
+
+  // one read txn per range, so every block in it is seen from the same snapshot
+  db.block_txn_start(true);
+  try
+  {
+    blobs.clear();
+    blobs.reserve(last - first + 1);
+    for (uint64_t height = first; height <= last; ++height)
+    {
+      // this method's height refers to 0-based height (genesis block = height 0)
+      block b;
+      if (!parse_and_validate_block_from_blob(db.get_block_blob_from_height(height), b))
+      {
+        MFATAL("Failed to parse block at height " << height);
+        db.block_txn_stop();
+        return false;
+      }
+      blobs.push_back(serialize_block(b));
+    }
+  }
+  catch (...)
+  {
+    db.block_txn_stop();
+    throw;
+  }
+  db.block_txn_stop();
+  return true;
 }
 
 bool BootstrapFile::close()
@@ -262,7 +296,7 @@ bool BootstrapFile::close()
 }
 
 
-bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_memory_pool* _tx_pool, boost::filesystem::path& output_file, uint64_t requested_block_stop)
+bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_memory_pool* _tx_pool, boost::filesystem::path& output_file, uint64_t requested_block_stop, unsigned int num_threads)
 {
   uint64_t num_blocks_written = 0;
   m_max_chunk = 0;
@@ -275,7 +309,6 @@ bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
     MFATAL("failed to open raw file for write");
     return false;
   }
-  block b;
 
   // block_start, block_stop use 0-based height. m_height uses 1-based height. So to resume export
   // from last exported block, block_start doesn't need to add 1 here, as it's already at the next
@@ -293,20 +326,57 @@ bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
     block_stop = m_blockchain_storage->get_current_blockchain_height() - 1;
     MINFO("Using block height of source blockchain: " << block_stop);
   }
-  for (m_cur_height = block_start; m_cur_height <= block_stop; ++m_cur_height)
+  if (num_threads == 0)
+    num_threads = 1;
+  MINFO("Exporting with " << num_threads << " reader thread(s)");
+
+  // Readers fetch and serialize ranges of blocks on their own read txns, and
+  // this thread writes the ranges out in height order as they complete.
+  typedef std::pair<uint64_t, uint64_t> range_type;
+  uint64_t next_height = block_start;
+  m_cur_height = block_start;
+  uint64_t bytes_written = 0;
+  const auto start_time = std::chrono::steady_clock::now();
+  ordered_pipeline<range_type, std::vector<blobdata>> pipeline(num_threads, num_threads * 4);
+  const bool r = pipeline.run(
+    [&](range_type &range) {
+      if (next_height > block_stop)
+        return false;
+      range.first = next_height;
+      range.second = std::min(next_height + EXPORT_BLOCKS_PER_RANGE - 1, block_stop);
+      next_height = range.second + 1;
+      return true;
+    },
+    [this](range_type &range, std::vector<blobdata> &blobs) {
+      return read_blocks(range.first, range.second, blobs);
+    },
+    [&](std::vector<blobdata> &blobs) {
+      for (const blobdata &bd: blobs)
+      {
+        m_output_stream->write((const char*)bd.data(), bd.size());
+        bytes_written += bd.size();
+        if (m_cur_height % NUM_BLOCKS_PER_CHUNK == 0) {
+          flush_chunk();
+          num_blocks_written += NUM_BLOCKS_PER_CHUNK;
+        }
+        if (m_cur_height % progress_interval == 0) {
+          const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+          std::cout << refresh_string;
+          std::cout << "block " << m_cur_height << "/" << block_stop;
+          if (seconds > 0)
+            std::cout << ", " << (unsigned)((m_cur_height - block_start + 1) / seconds) << " blocks/s, "
+                << (unsigned)(bytes_written / seconds / 1024) << " kB/s";
+          std::cout << std::flush;
+        }
+        ++m_cur_height;
+      }
+      return true;
+    });
+  if (!r)
   {
-    // this method's height refers to 0-based height (genesis block = height 0)
-    crypto::hash hash = m_blockchain_storage->get_block_id_by_height(m_cur_height);
-    m_blockchain_storage->get_block_by_hash(hash, b);
-    write_block(b);
-    if (m_cur_height % NUM_BLOCKS_PER_CHUNK == 0) {
-      flush_chunk();
-      num_blocks_written += NUM_BLOCKS_PER_CHUNK;
-    }
-    if (m_cur_height % progress_interval == 0) {
-      std::cout << refresh_string;
-      std::cout << "block " << m_cur_height << "/" << block_stop << std::flush;
-    }
+    MFATAL("Failed to export blocks, stopped at height " << m_cur_height);
+    BootstrapFile::close();
+    return false;
   }
   // NOTE: use of NUM_BLOCKS_PER_CHUNK is a placeholder in case multi-block chunks are later supported.
   if (m_cur_height % NUM_BLOCKS_PER_CHUNK != 0)
@@ -320,6 +390,8 @@ bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
   MINFO("Number of blocks exported: " << num_blocks_written);
   if (num_blocks_written > 0)
     MINFO("Largest chunk: " << m_max_chunk << " bytes");
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  MINFO("Exported " << bytes_written << " bytes in " << seconds << " seconds");
 
   return BootstrapFile::close();
 }
@@ -0,0 +1,197 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <utility>
+
+#include "misc_log_ex.h"
+
+// Runs a source -> N workers -> sink pipeline, where the sink sees the work
+// results in exactly the order the source produced the inputs.
+//
+// The source is called by one worker at a time (so it may keep state), the work function runs
+// concurrently on all workers, and the sink runs on the calling thread.
+// At most max_in_flight items are held between the source and the sink, so
+// memory use stays bounded when the sink is the slow stage.
+template<typename In, typename Out>
+class ordered_pipeline
+{
+public:
+  typedef std::function<bool(In&)> source_t;          // false: no more input
+  typedef std::function<bool(In&, Out&)> work_t;      // false: abort
+  typedef std::function<bool(Out&)> sink_t;           // false: abort
+
+  ordered_pipeline(unsigned int num_workers, size_t max_in_flight):
+    m_num_workers(num_workers ? num_workers : 1),
+    m_max_in_flight(max_in_flight ? max_in_flight : 1)
+  {}
+
+  // returns true if the source was drained and every item reached the sink;
+  // exceptions thrown by any stage are rethrown here
+  bool run(const source_t &source, const work_t &work, const sink_t &sink)
+  {
+    m_next_in = 0;
+    m_next_out = 0;
+    m_source_done = false;
+    m_stop = false;
+    m_error = std::exception_ptr();
+    m_done.clear();
+
+    boost::thread_group workers;
+    for (unsigned int i = 0; i < m_num_workers; ++i)
+      workers.create_thread([&]() { worker(source, work); });
+
+    bool success = true;
+    try
+    {
+      while (true)
+      {
+        Out out;
+        {
+          boost::unique_lock<boost::mutex> lock(m_mutex);
+          while (!m_stop && m_done.find(m_next_out) == m_done.end() && !(m_source_done && m_next_out == m_next_in))
+            m_cond_out.wait(lock);
+          if (m_stop)
+            break;
+          auto it = m_done.find(m_next_out);
+          if (it == m_done.end())
+            break; // source drained and everything consumed
+          out = std::move(it->second);
+          m_done.erase(it);
+          ++m_next_out;
+        }
+        m_cond_in.notify_all();
+        if (!sink(out))
+        {
+          success = false;
+          break;
+        }
+      }
+    }
+    catch (...)
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      if (!m_error)
+        m_error = std::current_exception();
+    }
+
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      if (!success || m_error)
+        m_stop = true;
+      success = success && !m_stop;
+    }
+    m_cond_in.notify_all();
+    workers.join_all();
+
+    if (m_error)
+      std::rethrow_exception(m_error);
+    return success;
+  }
+
+private:
+  void worker(const source_t &source, const work_t &work)
+  {
+    try
+    {
+      while (true)
+      {
+        In in;
+        uint64_t seq;
+        {
+          boost::unique_lock<boost::mutex> source_lock(m_source_mutex);
+          {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            while (!m_stop && !m_source_done && m_next_in >= m_next_out + m_max_in_flight)
+              m_cond_in.wait(lock);
+            if (m_stop || m_source_done)
+              return;
+          }
+          // the source may block on I/O, so only the source lock is held here
+          const bool more = source(in);
+          boost::unique_lock<boost::mutex> lock(m_mutex);
+          if (!more)
+          {
+            m_source_done = true;
+            m_cond_out.notify_all();
+            m_cond_in.notify_all();
+            return;
+          }
+          seq = m_next_in++;
+        }
+
+        Out out;
+        const bool r = work(in, out);
+
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        if (!r)
+        {
+          MERROR("Pipeline work item " << seq << " failed");
+          m_stop = true;
+          m_cond_out.notify_all();
+          m_cond_in.notify_all();
+          return;
+        }
+        m_done.emplace(seq, std::move(out));
+        m_cond_out.notify_all();
+      }
+    }
+    catch (...)
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      if (!m_error)
+        m_error = std::current_exception();
+      m_stop = true;
+      m_cond_out.notify_all();
+      m_cond_in.notify_all();
+    }
+  }
+
+  const unsigned int m_num_workers;
+  const size_t m_max_in_flight;
+
+  boost::mutex m_source_mutex;
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond_in;
+  boost::condition_variable m_cond_out;
+  uint64_t m_next_in;
+  uint64_t m_next_out;
+  bool m_source_done;
+  bool m_stop;
+  std::exception_ptr m_error;
+  std::map<uint64_t, Out> m_done;
+};
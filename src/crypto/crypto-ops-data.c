@@ -29,6 +29,8 @@
 // 
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
+#if !defined(CRYPTO_FE_64)
+
 #include <stdint.h>
 
 #include "crypto-ops.h"
@@ -878,3 +880,5 @@ const ge_p3 ge_p3_H = {
   {1, 0, 0, 0, 0, 0, 0, 0, 0, 0},
   {23443568, -5110398, -8776029, -4345135, 6889568, -14710814, 7474843, 3279062, 14550766, -7453428}
 };
+
+#endif
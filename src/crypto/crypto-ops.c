@@ -67,6 +67,208 @@ uint64_t load_4(const unsigned char *in)
   return result;
 }
 
+#if defined(CRYPTO_FE_64)
+
+/*
+64-bit field arithmetic, after curve25519-donna-64bit and ed25519-donna:
+an element is five 51-bit limbs, h = h[0] + 2^51 h[1] + ... + 2^204 h[4],
+and products are accumulated in 128 bits.
+
+Every function below leaves its result carried, with each limb below 2^52,
+which is what they all expect as inputs.
+*/
+
+__extension__ typedef unsigned __int128 fe_uint128;
+
+static const uint64_t fe_mask51 = 0x7ffffffffffff;
+
+static uint64_t load_8(const unsigned char *in) {
+  return load_4(in) | (load_4(in + 4) << 32);
+}
+
+static void fe_carry(fe h) {
+  uint64_t c;
+  c = h[0] >> 51; h[0] &= fe_mask51; h[1] += c;
+  c = h[1] >> 51; h[1] &= fe_mask51; h[2] += c;
+  c = h[2] >> 51; h[2] &= fe_mask51; h[3] += c;
+  c = h[3] >> 51; h[3] &= fe_mask51; h[4] += c;
+  c = h[4] >> 51; h[4] &= fe_mask51; h[0] += c * 19;
+}
+
+static void fe_0(fe h) {
+  h[0] = 0;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+static void fe_1(fe h) {
+  h[0] = 1;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+void fe_add(fe h, const fe f, const fe g) {
+  h[0] = f[0] + g[0];
+  h[1] = f[1] + g[1];
+  h[2] = f[2] + g[2];
+  h[3] = f[3] + g[3];
+  h[4] = f[4] + g[4];
+  fe_carry(h);
+}
+
+/* h = f - g, computed as f + 2p - g so that no limb goes negative */
+static void fe_sub(fe h, const fe f, const fe g) {
+  h[0] = f[0] + 0xfffffffffffda - g[0];
+  h[1] = f[1] + 0xffffffffffffe - g[1];
+  h[2] = f[2] + 0xffffffffffffe - g[2];
+  h[3] = f[3] + 0xffffffffffffe - g[3];
+  h[4] = f[4] + 0xffffffffffffe - g[4];
+  fe_carry(h);
+}
+
+static void fe_neg(fe h, const fe f) {
+  h[0] = 0xfffffffffffda - f[0];
+  h[1] = 0xffffffffffffe - f[1];
+  h[2] = 0xffffffffffffe - f[2];
+  h[3] = 0xffffffffffffe - f[3];
+  h[4] = 0xffffffffffffe - f[4];
+  fe_carry(h);
+}
+
+/* Replace f with g if b == 1, keep f if b == 0, in constant time */
+static void fe_cmov(fe f, const fe g, unsigned int b) {
+  const uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+  f[0] ^= mask & (f[0] ^ g[0]);
+  f[1] ^= mask & (f[1] ^ g[1]);
+  f[2] ^= mask & (f[2] ^ g[2]);
+  f[3] ^= mask & (f[3] ^ g[3]);
+  f[4] ^= mask & (f[4] ^ g[4]);
+}
+
+static void fe_copy(fe h, const fe f) {
+  h[0] = f[0];
+  h[1] = f[1];
+  h[2] = f[2];
+  h[3] = f[3];
+  h[4] = f[4];
+}
+
+/* Reduces the 128-bit column sums of a product into h */
+static void fe_reduce128(fe h, fe_uint128 t0, fe_uint128 t1, fe_uint128 t2, fe_uint128 t3, fe_uint128 t4) {
+  uint64_t r0, r1, r2, r3, r4, c;
+  r0 = (uint64_t) t0 & fe_mask51; t1 += (uint64_t) (t0 >> 51);
+  r1 = (uint64_t) t1 & fe_mask51; t2 += (uint64_t) (t1 >> 51);
+  r2 = (uint64_t) t2 & fe_mask51; t3 += (uint64_t) (t2 >> 51);
+  r3 = (uint64_t) t3 & fe_mask51; t4 += (uint64_t) (t3 >> 51);
+  r4 = (uint64_t) t4 & fe_mask51; c = (uint64_t) (t4 >> 51);
+  r0 += c * 19; c = r0 >> 51; r0 &= fe_mask51;
+  r1 += c;
+  h[0] = r0;
+  h[1] = r1;
+  h[2] = r2;
+  h[3] = r3;
+  h[4] = r4;
+}
+
+/* h = f * g, can overlap h with f or g */
+static void fe_mul(fe h, const fe f, const fe g) {
+  uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  const uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  fe_uint128 t0, t1, t2, t3, t4;
+
+  t0 = (fe_uint128) f0 * g0;
+  t1 = (fe_uint128) f0 * g1 + (fe_uint128) f1 * g0;
+  t2 = (fe_uint128) f0 * g2 + (fe_uint128) f2 * g0 + (fe_uint128) f1 * g1;
+  t3 = (fe_uint128) f0 * g3 + (fe_uint128) f3 * g0 + (fe_uint128) f1 * g2 + (fe_uint128) f2 * g1;
+  t4 = (fe_uint128) f0 * g4 + (fe_uint128) f4 * g0 + (fe_uint128) f3 * g1 + (fe_uint128) f1 * g3 + (fe_uint128) f2 * g2;
+
+  f1 *= 19;
+  f2 *= 19;
+  f3 *= 19;
+  f4 *= 19;
+
+  t0 += (fe_uint128) f4 * g1 + (fe_uint128) f1 * g4 + (fe_uint128) f2 * g3 + (fe_uint128) f3 * g2;
+  t1 += (fe_uint128) f4 * g2 + (fe_uint128) f2 * g4 + (fe_uint128) f3 * g3;
+  t2 += (fe_uint128) f4 * g3 + (fe_uint128) f3 * g4;
+  t3 += (fe_uint128) f4 * g4;
+
+  fe_reduce128(h, t0, t1, t2, t3, t4);
+}
+
+/* h = f * f, can overlap h with f */
+static void fe_sq(fe h, const fe f) {
+  const uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  const uint64_t f0_2 = f0 * 2, f1_2 = f1 * 2;
+  const uint64_t f2_38 = f2 * 38, f3_19 = f3 * 19, f4_19 = f4 * 19, f4_38 = f4_19 * 2;
+  fe_uint128 t0, t1, t2, t3, t4;
+
+  t0 = (fe_uint128) f0 * f0 + (fe_uint128) f4_38 * f1 + (fe_uint128) f2_38 * f3;
+  t1 = (fe_uint128) f0_2 * f1 + (fe_uint128) f4_38 * f2 + (fe_uint128) f3 * f3_19;
+  t2 = (fe_uint128) f0_2 * f2 + (fe_uint128) f1 * f1 + (fe_uint128) f4_38 * f3;
+  t3 = (fe_uint128) f0_2 * f3 + (fe_uint128) f1_2 * f2 + (fe_uint128) f4 * f4_19;
+  t4 = (fe_uint128) f0_2 * f4 + (fe_uint128) f1_2 * f3 + (fe_uint128) f2 * f2;
+
+  fe_reduce128(h, t0, t1, t2, t3, t4);
+}
+
+/* h = 2 * f * f, can overlap h with f */
+static void fe_sq2(fe h, const fe f) {
+  fe_sq(h, f);
+  fe_add(h, h, h);
+}
+
+/*
+Loads 256 bits; with top_bit_mask 0x7ff..ff bit 255 is dropped as in
+fe_frombytes, without it bit 255 counts as 2^255 = 19 (mod p)
+*/
+static void fe_frombytes64(fe h, const unsigned char *s, uint64_t top_mask) {
+  const uint64_t x0 = load_8(s), x1 = load_8(s + 8), x2 = load_8(s + 16), x3 = load_8(s + 24);
+  h[0] = x0 & fe_mask51;
+  h[1] = ((x0 >> 51) | (x1 << 13)) & fe_mask51;
+  h[2] = ((x1 >> 38) | (x2 << 26)) & fe_mask51;
+  h[3] = ((x2 >> 25) | (x3 << 39)) & fe_mask51;
+  h[4] = (x3 & top_mask) >> 12;
+}
+
+void fe_tobytes(unsigned char *s, const fe h) {
+  uint64_t t[5];
+  uint64_t f;
+  int i, j;
+
+  fe_copy(t, h);
+  fe_carry(t);
+  fe_carry(t);
+  /* now t is between 0 and 2^255-1, properly carried */
+  /* case 1: between 0 and 2^255-20. case 2: between 2^255-19 and 2^255-1 */
+  t[0] += 19;
+  fe_carry(t);
+  /* now between 19 and 2^255-1 in both cases, and offset by 19 */
+  t[0] += 0x8000000000000 - 19;
+  t[1] += 0x8000000000000 - 1;
+  t[2] += 0x8000000000000 - 1;
+  t[3] += 0x8000000000000 - 1;
+  t[4] += 0x8000000000000 - 1;
+  /* now between 2^255 and 2^256-20, and offset by 2^255 */
+  t[1] += t[0] >> 51; t[0] &= fe_mask51;
+  t[2] += t[1] >> 51; t[1] &= fe_mask51;
+  t[3] += t[2] >> 51; t[2] &= fe_mask51;
+  t[4] += t[3] >> 51; t[3] &= fe_mask51;
+  t[4] &= fe_mask51;
+
+  for (i = 0; i < 4; i++) {
+    f = (t[i] >> (13 * i)) | (t[i + 1] << (51 - 13 * i));
+    for (j = 0; j < 8; j++, f >>= 8) {
+      *s++ = (unsigned char) f;
+    }
+  }
+}
+
+#else
+
 /* From fe_0.c */
 
 /*
@@ -255,6 +457,8 @@ static void fe_copy(fe h, const fe f) {
   h[9] = f9;
 }
 
+#endif /* CRYPTO_FE_64 */
+
 /* From fe_invert.c */
 
 void fe_invert(fe out, const fe z) {
@@ -342,6 +546,8 @@ static int fe_isnonzero(const fe f) {
     s[27] | s[28] | s[29] | s[30] | s[31]) - 1) >> 8) + 1;
 }
 
+#if !defined(CRYPTO_FE_64)
+
 /* From fe_mul.c */
 
 /*
@@ -1122,6 +1328,8 @@ void fe_tobytes(unsigned char *s, const fe h) {
   s[31] = h9 >> 18;
 }
 
+#endif /* !CRYPTO_FE_64 */
+
 /* From ge_add.c */
 
 void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
@@ -1195,16 +1403,23 @@ B is the Ed25519 base point (x,4/5) with x positive.
 */
 
 void ge_double_scalarmult_base_vartime(ge_p2 *r, const unsigned char *a, const ge_p3 *A, const unsigned char *b) {
+  ge_dsmp Ai; /* A, 3A, 5A, 7A, 9A, 11A, 13A, 15A */
+
+  ge_dsm_precomp(Ai, A);
+  ge_double_scalarmult_base_precomp_vartime(r, a, Ai, b);
+}
+
+/* As ge_double_scalarmult_base_vartime, with A given after ge_dsm_precomp */
+
+void ge_double_scalarmult_base_precomp_vartime(ge_p2 *r, const unsigned char *a, const ge_dsmp Ai, const unsigned char *b) {
   signed char aslide[256];
   signed char bslide[256];
-  ge_dsmp Ai; /* A, 3A, 5A, 7A, 9A, 11A, 13A, 15A */
   ge_p1p1 t;
   ge_p3 u;
   int i;
 
   slide(aslide, a);
   slide(bslide, b);
-  ge_dsm_precomp(Ai, A);
 
   ge_p2_0(r);
 
@@ -1288,6 +1503,15 @@ int ge_frombytes_vartime(ge_p3 *h, const unsigned char *s) {
   fe vxx;
   fe check;
 
+#if defined(CRYPTO_FE_64)
+  fe_frombytes64(h->Y, s, 0x7fffffffffffffff);
+
+  /* Validate the number to be canonical */
+  if (h->Y[4] == fe_mask51 && h->Y[3] == fe_mask51 && h->Y[2] == fe_mask51 && h->Y[1] == fe_mask51 &&
+    h->Y[0] >= fe_mask51 - 18) {
+    return -1;
+  }
+#else
   /* From fe_frombytes.c */
 
   int64_t h0 = load_4(s);
@@ -1342,6 +1566,7 @@ int ge_frombytes_vartime(ge_p3 *h, const unsigned char *s) {
   h->Y[9] = h9;
 
   /* End fe_frombytes.c */
+#endif
 
   fe_1(h->Z);
   fe_sq(u, h->Y);
@@ -1558,20 +1783,20 @@ static void ge_precomp_cmov(ge_precomp *t, const ge_precomp *u, unsigned char b)
   fe_cmov(t->xy2d, u->xy2d, b);
 }
 
-static void select(ge_precomp *t, int pos, signed char b) {
+static void select(ge_precomp *t, const ge_precomp row[8], signed char b) {
   ge_precomp minust;
   unsigned char bnegative = negative(b);
   unsigned char babs = b - (((-bnegative) & b) << 1);
 
   ge_precomp_0(t);
-  ge_precomp_cmov(t, &ge_base[pos][0], equal(babs, 1));
-  ge_precomp_cmov(t, &ge_base[pos][1], equal(babs, 2));
-  ge_precomp_cmov(t, &ge_base[pos][2], equal(babs, 3));
-  ge_precomp_cmov(t, &ge_base[pos][3], equal(babs, 4));
-  ge_precomp_cmov(t, &ge_base[pos][4], equal(babs, 5));
-  ge_precomp_cmov(t, &ge_base[pos][5], equal(babs, 6));
-  ge_precomp_cmov(t, &ge_base[pos][6], equal(babs, 7));
-  ge_precomp_cmov(t, &ge_base[pos][7], equal(babs, 8));
+  ge_precomp_cmov(t, &row[0], equal(babs, 1));
+  ge_precomp_cmov(t, &row[1], equal(babs, 2));
+  ge_precomp_cmov(t, &row[2], equal(babs, 3));
+  ge_precomp_cmov(t, &row[3], equal(babs, 4));
+  ge_precomp_cmov(t, &row[4], equal(babs, 5));
+  ge_precomp_cmov(t, &row[5], equal(babs, 6));
+  ge_precomp_cmov(t, &row[6], equal(babs, 7));
+  ge_precomp_cmov(t, &row[7], equal(babs, 8));
   fe_copy(minust.yplusx, t->yminusx);
   fe_copy(minust.yminusx, t->yplusx);
   fe_neg(minust.xy2d, t->xy2d);
@@ -1588,6 +1813,18 @@ Preconditions:
 */
 
 void ge_scalarmult_base(ge_p3 *h, const unsigned char *a) {
+  ge_scalarmult_precomp(h, a, ge_base);
+}
+
+/*
+h = a * B
+where table was filled by ge_precomp_init from B
+
+Preconditions:
+  a[31] <= 127
+*/
+
+void ge_scalarmult_precomp(ge_p3 *h, const unsigned char *a, const ge_precomp table[32][8]) {
   signed char e[64];
   signed char carry;
   ge_p1p1 r;
@@ -1614,7 +1851,7 @@ void ge_scalarmult_base(ge_p3 *h, const unsigned char *a) {
 
   ge_p3_0(h);
   for (i = 1; i < 64; i += 2) {
-    select(&t, i / 2, e[i]);
+    select(&t, table[i / 2], e[i]);
     ge_madd(&r, h, &t); ge_p1p1_to_p3(h, &r);
   }
 
@@ -1624,7 +1861,7 @@ void ge_scalarmult_base(ge_p3 *h, const unsigned char *a) {
   ge_p2_dbl(&r, &s); ge_p1p1_to_p3(h, &r);
 
   for (i = 0; i < 64; i += 2) {
-    select(&t, i / 2, e[i]);
+    select(&t, table[i / 2], e[i]);
     ge_madd(&r, h, &t); ge_p1p1_to_p3(h, &r);
   }
 }
@@ -1664,6 +1901,36 @@ void ge_tobytes(unsigned char *s, const ge_p2 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+/* Like ge_tobytes for n points, writing 32 * n bytes to s, with one
+   inversion per GE_TOBYTES_BATCH points */
+#define GE_TOBYTES_BATCH 64
+
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, size_t n) {
+  fe products[GE_TOBYTES_BATCH];
+  fe inv, recip, x, y;
+  size_t i, k, m;
+
+  for (i = 0; i < n; i += m) {
+    m = n - i < GE_TOBYTES_BATCH ? n - i : GE_TOBYTES_BATCH;
+    fe_copy(products[0], h[i].Z);
+    for (k = 1; k < m; k++)
+      fe_mul(products[k], products[k - 1], h[i + k].Z);
+    fe_invert(inv, products[m - 1]);
+    for (k = m; k-- > 0; ) {
+      if (k > 0) {
+        fe_mul(recip, inv, products[k - 1]);
+        fe_mul(inv, inv, h[i + k].Z);
+      } else {
+        fe_copy(recip, inv);
+      }
+      fe_mul(x, h[i + k].X, recip);
+      fe_mul(y, h[i + k].Y, recip);
+      fe_tobytes(s + 32 * (i + k), y);
+      s[32 * (i + k) + 31] ^= fe_isnegative(x) << 7;
+    }
+  }
+}
+
 /* From sc_reduce.c */
 
 /*
@@ -1985,13 +2252,61 @@ static void ge_cached_cmov(ge_cached *t, const ge_cached *u, unsigned char b) {
   fe_cmov(t->T2d, u->T2d, b);
 }
 
+/*
+table[i][j] = (j + 1) * 256^i * B, the layout of ge_base, for ge_scalarmult_precomp
+*/
+void ge_precomp_init(ge_precomp table[32][8], const ge_p3 *B) {
+  ge_p3 points[256];
+  fe products[256];
+  ge_p3 row;
+  ge_cached row_cached;
+  ge_p1p1 t;
+  ge_p2 s;
+  fe inv, x, y, zinv;
+  ge_precomp *out;
+  int i, j, k;
+
+  row = *B;
+  for (i = 0; i < 32; i++) {
+    ge_p3_to_cached(&row_cached, &row);
+    points[8 * i] = row;
+    for (j = 1; j < 8; j++) {
+      ge_add(&t, &points[8 * i + j - 1], &row_cached);
+      ge_p1p1_to_p3(&points[8 * i + j], &t);
+    }
+    ge_p3_dbl(&t, &row);
+    for (k = 0; k < 7; k++) {
+      ge_p1p1_to_p2(&s, &t);
+      ge_p2_dbl(&t, &s);
+    }
+    ge_p1p1_to_p3(&row, &t);
+  }
+
+  /* one inversion for all the Z coordinates */
+  fe_copy(products[0], points[0].Z);
+  for (k = 1; k < 256; k++)
+    fe_mul(products[k], products[k - 1], points[k].Z);
+  fe_invert(inv, products[255]);
+  for (k = 255; k >= 0; k--) {
+    if (k > 0) {
+      fe_mul(zinv, inv, products[k - 1]);
+      fe_mul(inv, inv, points[k].Z);
+    } else {
+      fe_copy(zinv, inv);
+    }
+    fe_mul(x, points[k].X, zinv);
+    fe_mul(y, points[k].Y, zinv);
+    out = &table[k / 8][k % 8];
+    fe_add(out->yplusx, y, x);
+    fe_sub(out->yminusx, y, x);
+    fe_mul(out->xy2d, x, y);
+    fe_mul(out->xy2d, out->xy2d, fe_d2);
+  }
+}
+
 /* Assumes that a[31] <= 127 */
-void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
-  signed char e[64];
+void ge_scalarmult_digits(signed char e[64], const unsigned char *a) {
   int carry, carry2, i;
-  ge_cached Ai[8]; /* 1 * A, 2 * A, ..., 8 * A */
-  ge_p1p1 t;
-  ge_p3 u;
 
   carry = 0; /* 0..1 */
   for (i = 0; i < 31; i++) {
@@ -2005,6 +2320,15 @@ void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
   carry2 = (carry + 8) >> 4; /* 0..8 */
   e[62] = carry - (carry2 << 4); /* -8..7 */
   e[63] = carry2; /* 0..8 */
+}
+
+/* e are the digits from ge_scalarmult_digits, so a scalar used for many
+   points only needs to be recoded once */
+void ge_scalarmult_radix16(ge_p2 *r, const signed char e[64], const ge_p3 *A) {
+  int i;
+  ge_cached Ai[8]; /* 1 * A, 2 * A, ..., 8 * A */
+  ge_p1p1 t;
+  ge_p3 u;
 
   ge_p3_to_cached(&Ai[0], A);
   for (i = 0; i < 7; i++) {
@@ -2046,6 +2370,14 @@ void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
   }
 }
 
+/* Assumes that a[31] <= 127 */
+void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
+  signed char e[64];
+
+  ge_scalarmult_digits(e, a);
+  ge_scalarmult_radix16(r, e, A);
+}
+
 void ge_scalarmult_p3(ge_p3 *r3, const unsigned char *a, const ge_p3 *A) {
   signed char e[64];
   int carry, carry2, i;
@@ -2212,6 +2544,9 @@ void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   fe u, v, w, x, y, z;
   unsigned char sign;
 
+#if defined(CRYPTO_FE_64)
+  fe_frombytes64(u, s, 0xffffffffffffffff);
+#else
   /* From fe_frombytes.c */
 
   int64_t h0 = load_4(s);
@@ -2259,6 +2594,7 @@ void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   u[9] = h9;
 
   /* End fe_frombytes.c */
+#endif
 
   fe_sq2(v, u); /* 2 * u^2 */
   fe_1(w);
@@ -3733,6 +4069,12 @@ int sc_isnonzero(const unsigned char *s) {
 
 int ge_p3_is_point_at_infinity(const ge_p3 *p) {
   // X = 0 and Y == Z
+#if defined(CRYPTO_FE_64)
+  /* limbs are only partly reduced here, so compare the values */
+  fe d;
+  fe_sub(d, p->Y, p->Z);
+  return !fe_isnonzero(p->X) && !fe_isnonzero(p->T) && !fe_isnonzero(d);
+#else
   int n;
   for (n = 0; n < 10; ++n)
   {
@@ -3742,4 +4084,5 @@ int ge_p3_is_point_at_infinity(const ge_p3 *p) {
       return 0;
   }
   return 1;
+#endif
 }
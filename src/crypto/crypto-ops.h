@@ -31,11 +31,17 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* From fe.h */
 
+#if defined(CRYPTO_FE_64)
+/* 51-bit limbs, see the USE_FE64 build option */
+typedef uint64_t fe[5];
+#else
 typedef int32_t fe[10];
+#endif
 
 /* From ge.h */
 
@@ -82,6 +88,7 @@ typedef ge_cached ge_dsmp[8];
 extern const ge_precomp ge_Bi[8];
 void ge_dsm_precomp(ge_dsmp r, const ge_p3 *s);
 void ge_double_scalarmult_base_vartime(ge_p2 *, const unsigned char *, const ge_p3 *, const unsigned char *);
+void ge_double_scalarmult_base_precomp_vartime(ge_p2 *, const unsigned char *, const ge_dsmp, const unsigned char *);
 void ge_double_scalarmult_base_vartime_p3(ge_p3 *, const unsigned char *, const ge_p3 *, const unsigned char *);
 
 /* From ge_frombytes.c, modified */
@@ -119,10 +126,12 @@ void ge_p3_tobytes(unsigned char *, const ge_p3 *);
 
 extern const ge_precomp ge_base[32][8];
 void ge_scalarmult_base(ge_p3 *, const unsigned char *);
+void ge_scalarmult_precomp(ge_p3 *, const unsigned char *, const ge_precomp [32][8]);
 
 /* From ge_tobytes.c */
 
 void ge_tobytes(unsigned char *, const ge_p2 *);
+void ge_tobytes_batch(unsigned char *, const ge_p2 *, size_t);
 
 /* From sc_reduce.c */
 
@@ -130,6 +139,9 @@ void sc_reduce(unsigned char *);
 
 /* New code */
 
+void ge_precomp_init(ge_precomp [32][8], const ge_p3 *);
+void ge_scalarmult_digits(signed char [64], const unsigned char *);
+void ge_scalarmult_radix16(ge_p2 *, const signed char [64], const ge_p3 *);
 void ge_scalarmult(ge_p2 *, const unsigned char *, const ge_p3 *);
 void ge_scalarmult_p3(ge_p3 *, const unsigned char *, const ge_p3 *);
 void ge_double_scalarmult_precomp_vartime(ge_p2 *, const unsigned char *, const ge_p3 *, const unsigned char *, const ge_dsmp);
@@ -36,8 +36,6 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/lock_guard.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "common/varint.h"
@@ -101,9 +99,7 @@ const crypto::secret_key &NullKey::s()
 
   void generate_random_bytes_thread_safe(size_t N, uint8_t *bytes)
   {
-    static boost::mutex random_lock;
-    boost::lock_guard<boost::mutex> lock(random_lock);
-    generate_random_bytes_not_thread_safe(N, bytes);
+    generate_random_bytes_thread_local(N, bytes);
   }
 
   static inline bool less32(const unsigned char *k0, const unsigned char *k1)
@@ -255,6 +251,71 @@ const crypto::secret_key &NullKey::s()
     return true;
   }
 
+  void crypto_ops::generate_key_derivations(const public_key *keys, std::size_t n, const secret_key &key, key_derivation *derivations, int *good) {
+    signed char digits[64];
+    std::vector<ge_p2> points(n);
+    assert(sc_check(&key) == 0);
+    // the scalar is the same for every key, so recode it once
+    ge_scalarmult_digits(digits, &unwrap(key));
+    for (std::size_t i = 0; i < n; ++i) {
+      ge_p3 point;
+      ge_p1p1 point2;
+      good[i] = ge_frombytes_vartime(&point, &keys[i]) == 0;
+      if (!good[i]) {
+        ge_p3_to_p2(&points[i], &ge_p3_identity);
+        continue;
+      }
+      ge_scalarmult_radix16(&points[i], digits, &point);
+      ge_mul8(&point2, &points[i]);
+      ge_p1p1_to_p2(&points[i], &point2);
+    }
+    memwipe(digits, sizeof(digits));
+    static_assert(sizeof(key_derivation) == 32, "Unexpected key_derivation size");
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(derivations), points.data(), n);
+  }
+
+  void crypto_ops::derive_subaddress_public_keys(const public_key *out_keys, const key_derivation *derivations, const std::size_t *output_indices, std::size_t n, public_key *derived_keys, int *good) {
+    struct derivation_buffer {
+      key_derivation derivation;
+      char output_index[(sizeof(size_t) * 8 + 6) / 7];
+    };
+    std::vector<derivation_buffer> buffers(n);
+    std::vector<const void*> data(n);
+    std::vector<std::size_t> lengths(n);
+    std::vector<hash> scalars(n);
+    std::vector<ge_p2> points(n);
+
+    // derivation_to_scalar for all of them, with a multi-buffer hash
+    for (std::size_t i = 0; i < n; ++i) {
+      char *end = buffers[i].output_index;
+      buffers[i].derivation = derivations[i];
+      tools::write_varint(end, output_indices[i]);
+      assert(end <= buffers[i].output_index + sizeof buffers[i].output_index);
+      data[i] = &buffers[i];
+      lengths[i] = end - reinterpret_cast<char *>(&buffers[i]);
+    }
+    cn_fast_hash_n(data.data(), lengths.data(), scalars.data(), n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      ge_p3 point1;
+      ge_p3 point2;
+      ge_cached point3;
+      ge_p1p1 point4;
+      good[i] = ge_frombytes_vartime(&point1, &out_keys[i]) == 0;
+      if (!good[i]) {
+        ge_p3_to_p2(&points[i], &ge_p3_identity);
+        continue;
+      }
+      ec_scalar &scalar = reinterpret_cast<ec_scalar &>(scalars[i]);
+      sc_reduce32(&scalar);
+      ge_scalarmult_base(&point2, &scalar);
+      ge_p3_to_cached(&point3, &point2);
+      ge_sub(&point4, &point1, &point3);
+      ge_p1p1_to_p2(&points[i], &point4);
+    }
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(derived_keys), points.data(), n);
+  }
+
   struct s_comm {
     hash h;
     ec_point key;
@@ -395,89 +456,66 @@ const crypto::secret_key &NullKey::s()
   }
 
   bool crypto_ops::check_tx_proof(const hash &prefix_hash, const public_key &R, const public_key &A, const boost::optional<public_key> &B, const public_key &D, const signature &sig) {
-    // sanity check
-    ge_p3 R_p3;
-    ge_p3 A_p3;
-    ge_p3 B_p3;
-    ge_p3 D_p3;
-    if (ge_frombytes_vartime(&R_p3, &R) != 0) return false;
-    if (ge_frombytes_vartime(&A_p3, &A) != 0) return false;
-    if (B && ge_frombytes_vartime(&B_p3, &*B) != 0) return false;
-    if (ge_frombytes_vartime(&D_p3, &D) != 0) return false;
-    if (sc_check(&sig.c) != 0 || sc_check(&sig.r) != 0) return false;
-
-    // compute sig.c*R
-    ge_p3 cR_p3;
-    {
-      ge_p2 cR_p2;
-      ge_scalarmult(&cR_p2, &sig.c, &R_p3);
-      public_key cR;
-      ge_tobytes(&cR, &cR_p2);
-      if (ge_frombytes_vartime(&cR_p3, &cR) != 0) return false;
-    }
+    const tx_proof_entry proof = {prefix_hash, R, A, B, D, sig};
+    int good;
+    check_tx_proofs(&proof, 1, &good);
+    return good;
+  }
 
-    ge_p1p1 X_p1p1;
-    if (B)
-    {
-      // compute X = sig.c*R + sig.r*B
-      ge_p2 rB_p2;
-      ge_scalarmult(&rB_p2, &sig.r, &B_p3);
-      public_key rB;
-      ge_tobytes(&rB, &rB_p2);
-      ge_p3 rB_p3;
-      if (ge_frombytes_vartime(&rB_p3, &rB) != 0) return false;
-      ge_cached rB_cached;
-      ge_p3_to_cached(&rB_cached, &rB_p3);
-      ge_add(&X_p1p1, &cR_p3, &rB_cached);
-    }
-    else
-    {
-      // compute X = sig.c*R + sig.r*G
-      ge_p3 rG_p3;
-      ge_scalarmult_base(&rG_p3, &sig.r);
-      ge_cached rG_cached;
-      ge_p3_to_cached(&rG_cached, &rG_p3);
-      ge_add(&X_p1p1, &cR_p3, &rG_cached);
-    }
-    ge_p2 X_p2;
-    ge_p1p1_to_p2(&X_p2, &X_p1p1);
-
-    // compute sig.c*D
-    ge_p2 cD_p2;
-    ge_scalarmult(&cD_p2, &sig.c, &D_p3);
-
-    // compute sig.r*A
-    ge_p2 rA_p2;
-    ge_scalarmult(&rA_p2, &sig.r, &A_p3);
-
-    // compute Y = sig.c*D + sig.r*A
-    public_key cD;
-    public_key rA;
-    ge_tobytes(&cD, &cD_p2);
-    ge_tobytes(&rA, &rA_p2);
-    ge_p3 cD_p3;
-    ge_p3 rA_p3;
-    if (ge_frombytes_vartime(&cD_p3, &cD) != 0) return false;
-    if (ge_frombytes_vartime(&rA_p3, &rA) != 0) return false;
-    ge_cached rA_cached;
-    ge_p3_to_cached(&rA_cached, &rA_p3);
-    ge_p1p1 Y_p1p1;
-    ge_add(&Y_p1p1, &cD_p3, &rA_cached);
-    ge_p2 Y_p2;
-    ge_p1p1_to_p2(&Y_p2, &Y_p1p1);
+  void crypto_ops::check_tx_proofs(const tx_proof_entry *proofs, std::size_t n, int *good) {
+    // A and B are usually the same address for every proof, so keep their tables
+    const public_key *last_A = NULL, *last_B = NULL;
+    ge_dsmp A_dsmp, B_dsmp;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      const tx_proof_entry &proof = proofs[i];
+      good[i] = 0;
+
+      // sanity check
+      ge_p3 R_p3;
+      ge_p3 D_p3;
+      if (ge_frombytes_vartime(&R_p3, &proof.R) != 0) continue;
+      if (ge_frombytes_vartime(&D_p3, &proof.D) != 0) continue;
+      if (!last_A || *last_A != proof.A) {
+        ge_p3 A_p3;
+        last_A = NULL;
+        if (ge_frombytes_vartime(&A_p3, &proof.A) != 0) continue;
+        ge_dsm_precomp(A_dsmp, &A_p3);
+        last_A = std::addressof(proof.A);
+      }
+      if (proof.B && (!last_B || *last_B != *proof.B)) {
+        ge_p3 B_p3;
+        last_B = NULL;
+        if (ge_frombytes_vartime(&B_p3, &*proof.B) != 0) continue;
+        ge_dsm_precomp(B_dsmp, &B_p3);
+        last_B = std::addressof(*proof.B);
+      }
+      if (sc_check(&proof.sig.c) != 0 || sc_check(&proof.sig.r) != 0) continue;
 
-    // compute c2 = Hs(Msg || D || X || Y)
-    s_comm_2 buf;
-    buf.msg = prefix_hash;
-    buf.D = D;
-    ge_tobytes(&buf.X, &X_p2);
-    ge_tobytes(&buf.Y, &Y_p2);
-    ec_scalar c2;
-    hash_to_scalar(&buf, sizeof(s_comm_2), c2);
+      // compute X = sig.c*R + sig.r*B, or sig.c*R + sig.r*G without B
+      ge_p2 X_p2;
+      if (proof.B)
+        ge_double_scalarmult_precomp_vartime(&X_p2, &proof.sig.c, &R_p3, &proof.sig.r, B_dsmp);
+      else
+        ge_double_scalarmult_base_vartime(&X_p2, &proof.sig.c, &R_p3, &proof.sig.r);
 
-    // test if c2 == sig.c
-    sc_sub(&c2, &c2, &sig.c);
-    return sc_isnonzero(&c2) == 0;
+      // compute Y = sig.c*D + sig.r*A
+      ge_p2 Y_p2;
+      ge_double_scalarmult_precomp_vartime(&Y_p2, &proof.sig.c, &D_p3, &proof.sig.r, A_dsmp);
+
+      // compute c2 = Hs(Msg || D || X || Y)
+      s_comm_2 buf;
+      buf.msg = proof.prefix_hash;
+      buf.D = proof.D;
+      ge_tobytes(&buf.X, &X_p2);
+      ge_tobytes(&buf.Y, &Y_p2);
+      ec_scalar c2;
+      hash_to_scalar(&buf, sizeof(s_comm_2), c2);
+
+      // test if c2 == sig.c
+      sc_sub(&c2, &c2, &proof.sig.c);
+      good[i] = sc_isnonzero(&c2) == 0;
+    }
   }
 
   static void hash_to_ec(const public_key &key, ge_p3 &res) {
@@ -107,6 +107,17 @@ namespace crypto {
     sizeof(key_derivation) == 32 && sizeof(key_image) == 32 &&
     sizeof(signature) == 64, "Invalid structure size");
 
+  /* A tx proof as checked by check_tx_proof
+   */
+  struct tx_proof_entry {
+    hash prefix_hash;
+    public_key R;
+    public_key A;
+    boost::optional<public_key> B;
+    public_key D;
+    signature sig;
+  };
+
   class crypto_ops {
     crypto_ops();
     crypto_ops(const crypto_ops &);
@@ -129,6 +140,10 @@ namespace crypto {
     friend void derive_secret_key(const key_derivation &, std::size_t, const secret_key &, secret_key &);
     static bool derive_subaddress_public_key(const public_key &, const key_derivation &, std::size_t, public_key &);
     friend bool derive_subaddress_public_key(const public_key &, const key_derivation &, std::size_t, public_key &);
+    static void generate_key_derivations(const public_key *, std::size_t, const secret_key &, key_derivation *, int *);
+    friend void generate_key_derivations(const public_key *, std::size_t, const secret_key &, key_derivation *, int *);
+    static void derive_subaddress_public_keys(const public_key *, const key_derivation *, const std::size_t *, std::size_t, public_key *, int *);
+    friend void derive_subaddress_public_keys(const public_key *, const key_derivation *, const std::size_t *, std::size_t, public_key *, int *);
     static void generate_signature(const hash &, const public_key &, const secret_key &, signature &);
     friend void generate_signature(const hash &, const public_key &, const secret_key &, signature &);
     static bool check_signature(const hash &, const public_key &, const signature &);
@@ -137,6 +152,8 @@ namespace crypto {
     friend void generate_tx_proof(const hash &, const public_key &, const public_key &, const boost::optional<public_key> &, const public_key &, const secret_key &, signature &);
     static bool check_tx_proof(const hash &, const public_key &, const public_key &, const boost::optional<public_key> &, const public_key &, const signature &);
     friend bool check_tx_proof(const hash &, const public_key &, const public_key &, const boost::optional<public_key> &, const public_key &, const signature &);
+    static void check_tx_proofs(const tx_proof_entry *, std::size_t, int *);
+    friend void check_tx_proofs(const tx_proof_entry *, std::size_t, int *);
     static void generate_key_image(const public_key &, const secret_key &, key_image &);
     friend void generate_key_image(const public_key &, const secret_key &, key_image &);
     static void generate_ring_signature(const hash &, const key_image &,
@@ -208,6 +225,17 @@ namespace crypto {
     return crypto_ops::derive_subaddress_public_key(out_key, derivation, output_index, result);
   }
 
+  /* Batch versions of generate_key_derivation and derive_subaddress_public_key, setting good[i]
+   * to whether the i-th key could be used. Sharing the work across the batch (the recoded secret
+   * key, one field inversion and a multi-buffer hash) makes these cheaper per key when scanning.
+   */
+  inline void generate_key_derivations(const public_key *keys, std::size_t n, const secret_key &key, key_derivation *derivations, int *good) {
+    crypto_ops::generate_key_derivations(keys, n, key, derivations, good);
+  }
+  inline void derive_subaddress_public_keys(const public_key *out_keys, const key_derivation *derivations, const std::size_t *output_indices, std::size_t n, public_key *derived_keys, int *good) {
+    crypto_ops::derive_subaddress_public_keys(out_keys, derivations, output_indices, n, derived_keys, good);
+  }
+
   /* Generation and checking of a standard signature.
    */
   inline void generate_signature(const hash &prefix_hash, const public_key &pub, const secret_key &sec, signature &sig) {
@@ -228,6 +256,14 @@ namespace crypto {
     return crypto_ops::check_tx_proof(prefix_hash, R, A, B, D, sig);
   }
 
+  /* Checks a batch of tx proofs, setting good[i] to whether the i-th one is valid.
+   * The precomputation for A and B is shared by consecutive proofs with the same keys,
+   * as when they all concern one address.
+   */
+  inline void check_tx_proofs(const tx_proof_entry *proofs, std::size_t n, int *good) {
+    crypto_ops::check_tx_proofs(proofs, n, good);
+  }
+
   /* To send money to a key:
    * * The sender generates an ephemeral key and includes it in transaction output.
    * * To spend the money, the receiver generates a key image from it.
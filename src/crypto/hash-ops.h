@@ -80,6 +80,7 @@ enum {
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
+void cn_fast_hash_n(const void *const *data, const size_t *lengths, char (*hashes)[HASH_SIZE], size_t count);
 void cn_slow_hash(const void *data, size_t length, char *hash, int variant, int prehashed);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
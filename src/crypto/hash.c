@@ -49,3 +49,7 @@ void cn_fast_hash(const void *data, size_t length, char *hash) {
   hash_process(&state, data, length);
   memcpy(hash, &state, HASH_SIZE);
 }
+
+void cn_fast_hash_n(const void *const *data, const size_t *lengths, char (*hashes)[HASH_SIZE], size_t count) {
+  keccak256_n((const uint8_t *const *)data, lengths, (uint8_t (*)[HASH_SIZE])hashes, count);
+}
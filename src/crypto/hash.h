@@ -72,6 +72,13 @@ namespace crypto {
     return h;
   }
 
+  /* Hashes count messages at once, as cn_fast_hash(data[i], lengths[i], hashes[i]).
+   * The hashes must not overlap the messages.
+   */
+  inline void cn_fast_hash_n(const void *const *data, const std::size_t *lengths, hash *hashes, std::size_t count) {
+    cn_fast_hash_n(data, lengths, reinterpret_cast<char (*)[HASH_SIZE]>(hashes), count);
+  }
+
   inline void cn_slow_hash(const void *data, std::size_t length, hash &hash, int variant = 0) {
     cn_slow_hash(data, length, reinterpret_cast<char *>(&hash), variant, 0/*prehashed*/);
   }
@@ -211,3 +211,203 @@ void keccak_finish(KECCAK_CTX * ctx, uint8_t *md){
         memcpy(md, ctx->hash, KECCAK_DIGESTSIZE);
     }
 }
+
+// multi-buffer keccak: several independent states permuted in lock-step,
+// word i of lane l kept at st[i * lanes + l]
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KECCAK_X86_MULTI_BUFFER
+#include <immintrin.h>
+
+#define KECCAK_MAX_LANES 8
+
+typedef void (*keccakf_lanes_t)(uint64_t *st);
+
+// one round on the 25 words s, with XOR, XOR5, CHI(a, b, c) = a ^ (~b & c)
+// and ROL defined for the vector type where it is used
+#define KECCAK_VEC_ROUND(s, B, C, D, rc) do { \
+    int i_; \
+    for (i_ = 0; i_ < 5; i_++) \
+      C[i_] = XOR5(s[i_], s[i_ + 5], s[i_ + 10], s[i_ + 15], s[i_ + 20]); \
+    for (i_ = 0; i_ < 5; i_++) \
+      D[i_] = XOR(C[(i_ + 4) % 5], ROL(C[(i_ + 1) % 5], 1)); \
+    for (i_ = 0; i_ < 25; i_++) \
+      s[i_] = XOR(s[i_], D[i_ % 5]); \
+    B[ 0] = s[ 0];              B[ 1] = ROL(s[ 6], 44); B[ 2] = ROL(s[12], 43); \
+    B[ 3] = ROL(s[18], 21);     B[ 4] = ROL(s[24], 14); B[ 5] = ROL(s[ 3], 28); \
+    B[ 6] = ROL(s[ 9], 20);     B[ 7] = ROL(s[10],  3); B[ 8] = ROL(s[16], 45); \
+    B[ 9] = ROL(s[22], 61);     B[10] = ROL(s[ 1],  1); B[11] = ROL(s[ 7],  6); \
+    B[12] = ROL(s[13], 25);     B[13] = ROL(s[19],  8); B[14] = ROL(s[20], 18); \
+    B[15] = ROL(s[ 4], 27);     B[16] = ROL(s[ 5], 36); B[17] = ROL(s[11], 10); \
+    B[18] = ROL(s[17], 15);     B[19] = ROL(s[23], 56); B[20] = ROL(s[ 2], 62); \
+    B[21] = ROL(s[ 8], 55);     B[22] = ROL(s[14], 39); B[23] = ROL(s[15], 41); \
+    B[24] = ROL(s[21],  2); \
+    for (i_ = 0; i_ < 25; i_ += 5) { \
+      s[i_ + 0] = CHI(B[i_ + 0], B[i_ + 1], B[i_ + 2]); \
+      s[i_ + 1] = CHI(B[i_ + 1], B[i_ + 2], B[i_ + 3]); \
+      s[i_ + 2] = CHI(B[i_ + 2], B[i_ + 3], B[i_ + 4]); \
+      s[i_ + 3] = CHI(B[i_ + 3], B[i_ + 4], B[i_ + 0]); \
+      s[i_ + 4] = CHI(B[i_ + 4], B[i_ + 0], B[i_ + 1]); \
+    } \
+    s[0] = XOR(s[0], rc); \
+  } while (0)
+
+#define XOR(a, b) _mm256_xor_si256(a, b)
+#define XOR5(a, b, c, d, e) XOR(XOR(XOR(a, b), XOR(c, d)), e)
+#define CHI(a, b, c) XOR(a, _mm256_andnot_si256(b, c))
+#define ROL(x, n) _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - (n)))
+
+__attribute__((target("avx2")))
+static void keccakf_x4_avx2(uint64_t *st)
+{
+    __m256i s[25], B[25], C[5], D[5];
+    int i, round;
+
+    for (i = 0; i < 25; i++)
+        s[i] = _mm256_loadu_si256((const __m256i*)(st + 4 * i));
+    for (round = 0; round < KECCAK_ROUNDS; round++)
+        KECCAK_VEC_ROUND(s, B, C, D, _mm256_set1_epi64x(keccakf_rndc[round]));
+    for (i = 0; i < 25; i++)
+        _mm256_storeu_si256((__m256i*)(st + 4 * i), s[i]);
+}
+
+#undef XOR
+#undef XOR5
+#undef CHI
+#undef ROL
+
+#define XOR(a, b) _mm512_xor_si512(a, b)
+#define XOR5(a, b, c, d, e) _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a, b, c, 0x96), d, e, 0x96)
+#define CHI(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0xd2)
+#define ROL(x, n) _mm512_rol_epi64(x, n)
+
+__attribute__((target("avx512f")))
+static void keccakf_x8_avx512(uint64_t *st)
+{
+    __m512i s[25], B[25], C[5], D[5];
+    int i, round;
+
+    for (i = 0; i < 25; i++)
+        s[i] = _mm512_loadu_si512((const void*)(st + 8 * i));
+    for (round = 0; round < KECCAK_ROUNDS; round++)
+        KECCAK_VEC_ROUND(s, B, C, D, _mm512_set1_epi64((long long)keccakf_rndc[round]));
+    for (i = 0; i < 25; i++)
+        _mm512_storeu_si512((void*)(st + 8 * i), s[i]);
+}
+
+#undef XOR
+#undef XOR5
+#undef CHI
+#undef ROL
+#undef KECCAK_VEC_ROUND
+
+// 0 if no multi-buffer kernel can be used, else the widest one's lane count
+static size_t keccak_max_lanes(void)
+{
+    static volatile int lanes = -1;
+    if (lanes < 0)
+    {
+        __builtin_cpu_init();
+        lanes = __builtin_cpu_supports("avx512f") ? 8 : __builtin_cpu_supports("avx2") ? 4 : 0;
+    }
+    return lanes;
+}
+
+// hashes the messages through the lanes, a lane taking the next message as soon as it is done with one
+static void keccak256_lanes(const uint8_t *const *in, const size_t *inlen, uint8_t (*md)[32], size_t n, size_t lanes, keccakf_lanes_t permute)
+{
+    uint64_t st[25 * KECCAK_MAX_LANES];
+    uint8_t temp[HASH_DATA_AREA];
+    size_t msg[KECCAK_MAX_LANES], done[KECCAK_MAX_LANES];
+    int active[KECCAK_MAX_LANES], last[KECCAK_MAX_LANES];
+    size_t next = 0, n_active = 0, l, i;
+
+    memset(st, 0, sizeof(st));
+    for (l = 0; l < lanes; l++)
+    {
+        active[l] = next < n;
+        if (active[l])
+        {
+            msg[l] = next++;
+            done[l] = 0;
+            ++n_active;
+        }
+    }
+
+    while (n_active > 0)
+    {
+        for (l = 0; l < lanes; l++)
+        {
+            const uint8_t *block;
+            if (!active[l])
+                continue;
+            last[l] = inlen[msg[l]] - done[l] < HASH_DATA_AREA;
+            if (last[l])
+            {
+                // last block and padding
+                const size_t rest = inlen[msg[l]] - done[l];
+                memcpy(temp, in[msg[l]] + done[l], rest);
+                temp[rest] = 1;
+                memset(temp + rest + 1, 0, HASH_DATA_AREA - rest - 1);
+                temp[HASH_DATA_AREA - 1] |= 0x80;
+                block = temp;
+            }
+            else
+            {
+                block = in[msg[l]] + done[l];
+                done[l] += HASH_DATA_AREA;
+            }
+            for (i = 0; i < HASH_DATA_AREA / 8; i++)
+            {
+                uint64_t w;
+                memcpy(&w, block + 8 * i, 8);
+                st[i * lanes + l] ^= swap64le(w);
+            }
+        }
+
+        permute(st);
+
+        for (l = 0; l < lanes; l++)
+        {
+            if (!active[l] || !last[l])
+                continue;
+            for (i = 0; i < 4; i++)
+            {
+                const uint64_t w = swap64le(st[i * lanes + l]);
+                memcpy(md[msg[l]] + 8 * i, &w, 8);
+            }
+            for (i = 0; i < 25; i++)
+                st[i * lanes + l] = 0;
+            if (next < n)
+            {
+                msg[l] = next++;
+                done[l] = 0;
+            }
+            else
+            {
+                active[l] = 0;
+                --n_active;
+            }
+        }
+    }
+}
+#endif
+
+void keccak256_n(const uint8_t *const *in, const size_t *inlen, uint8_t (*md)[32], size_t n)
+{
+#ifdef KECCAK_X86_MULTI_BUFFER
+    const size_t lanes = keccak_max_lanes();
+    if (lanes >= 8 && n >= 8)
+    {
+        keccak256_lanes(in, inlen, md, n, 8, keccakf_x8_avx512);
+        return;
+    }
+    if (lanes >= 4 && n >= 2)
+    {
+        keccak256_lanes(in, inlen, md, n, 4, keccakf_x4_avx2);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++)
+        keccak(in[i], inlen[i], md[i], 32);
+}
@@ -29,7 +29,6 @@
 // 
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
-#include <assert.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -96,54 +95,57 @@ static void generate_system_random_bytes(size_t n, void *result) {
 
 #endif
 
-static union hash_state state;
+/* Per thread generators, seeded from the system on first use. A fork bumps
+   the generation so the child reseeds rather than repeat the parent's output. */
+static __thread union hash_state thread_state;
+static __thread unsigned long thread_state_generation;
+static volatile unsigned long random_generation = 1;
 
-#if !defined(NDEBUG)
-static volatile int curstate; /* To catch thread safety problems. */
+#if !defined(_WIN32)
+#include <pthread.h>
+
+/* its destructor wipes a thread's generator when the thread exits */
+static pthread_key_t thread_state_key;
+
+static void wipe_thread_state(void *p) {
+  memset(p, 0, sizeof(union hash_state));
+  thread_state_generation = 0;
+}
+
+static void reseed_after_fork(void) {
+  ++random_generation;
+}
 #endif
 
 FINALIZER(deinit_random) {
-#if !defined(NDEBUG)
-  assert(curstate == 1);
-  curstate = 0;
-#endif
-  memset(&state, 0, sizeof(union hash_state));
+  memset(&thread_state, 0, sizeof(union hash_state));
 }
 
 INITIALIZER(init_random) {
-  generate_system_random_bytes(32, &state);
-  REGISTER_FINALIZER(deinit_random);
-#if !defined(NDEBUG)
-  assert(curstate == 0);
-  curstate = 1;
+#if !defined(_WIN32)
+  pthread_key_create(&thread_state_key, wipe_thread_state);
+  pthread_atfork(NULL, NULL, reseed_after_fork);
 #endif
+  REGISTER_FINALIZER(deinit_random);
 }
 
-void generate_random_bytes_not_thread_safe(size_t n, void *result) {
-#if !defined(NDEBUG)
-  assert(curstate == 1);
-  curstate = 2;
-#endif
-  if (n == 0) {
-#if !defined(NDEBUG)
-    assert(curstate == 2);
-    curstate = 1;
+void generate_random_bytes_thread_local(size_t n, void *result) {
+  if (thread_state_generation != random_generation) {
+    memset(&thread_state, 0, sizeof(union hash_state));
+    generate_system_random_bytes(32, &thread_state);
+    thread_state_generation = random_generation;
+#if !defined(_WIN32)
+    pthread_setspecific(thread_state_key, &thread_state);
 #endif
-    return;
   }
-  for (;;) {
-    hash_permutation(&state);
+  while (n > 0) {
+    hash_permutation(&thread_state);
     if (n <= HASH_DATA_AREA) {
-      memcpy(result, &state, n);
-#if !defined(NDEBUG)
-      assert(curstate == 2);
-      curstate = 1;
-#endif
+      memcpy(result, &thread_state, n);
       return;
-    } else {
-      memcpy(result, &state, HASH_DATA_AREA);
-      result = padd(result, HASH_DATA_AREA);
-      n -= HASH_DATA_AREA;
     }
+    memcpy(result, &thread_state, HASH_DATA_AREA);
+    result = padd(result, HASH_DATA_AREA);
+    n -= HASH_DATA_AREA;
   }
 }
@@ -33,4 +33,4 @@
 
 #include <stddef.h>
 
-void generate_random_bytes_not_thread_safe(size_t n, void *result);
+void generate_random_bytes_thread_local(size_t n, void *result);
@@ -92,22 +92,35 @@ void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
 
     size_t cnt = tree_hash_cnt( count );
 
-    char (*ints)[HASH_SIZE];
+    char (*ints)[HASH_SIZE], (*next)[HASH_SIZE], (*swap)[HASH_SIZE];
     size_t ints_size = cnt * HASH_SIZE;
     ints = alloca(ints_size); 	memset( ints , 0 , ints_size);  // allocate, and zero out as extra protection for using uninitialized mem
+    next = alloca(ints_size); 	memset( next , 0 , ints_size);
+
+    // the pairs of each level are hashed in one batch, into the other buffer
+    const void **data = alloca(cnt * sizeof(const void*));
+    size_t *lengths = alloca(cnt * sizeof(size_t));
+    for (j = 0; j < cnt; ++j) {
+      lengths[j] = 64;
+    }
 
     memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
 
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 64, ints[j]);
+    for (i = 2 * cnt - count, j = 0; i < count; i += 2, ++j) {
+      data[j] = hashes[i];
     }
+    cn_fast_hash_n(data, lengths, ints + 2 * cnt - count, j);
     assert(i == count);
 
     while (cnt > 2) {
       cnt >>= 1;
       for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints[i], 64, ints[j]);
+        data[j] = ints[i];
       }
+      cn_fast_hash_n(data, lengths, next, cnt);
+      swap = ints;
+      ints = next;
+      next = swap;
     }
 
     cn_fast_hash(ints[0], 64, root_hash);
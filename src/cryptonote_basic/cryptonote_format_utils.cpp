@@ -926,6 +926,70 @@ namespace cryptonote
     return boost::none;
   }
   //---------------------------------------------------------------
+  void is_out_to_acc_precomp_batch(const std::unordered_map<crypto::public_key, subaddress_index>& subaddresses, const out_to_acc_query *queries, size_t n, boost::optional<subaddress_receive_info> *results, hw::device &hwdev)
+  {
+    if (hwdev.get_type() != hw::device::SOFTWARE)
+    {
+      static const std::vector<crypto::key_derivation> no_additional_derivations;
+      for (size_t i = 0; i < n; ++i)
+      {
+        const out_to_acc_query &q = queries[i];
+        results[i] = is_out_to_acc_precomp(subaddresses, q.out_key, *q.derivation,
+            q.additional_derivations ? *q.additional_derivations : no_additional_derivations, q.output_index, hwdev);
+      }
+      return;
+    }
+
+    std::vector<crypto::public_key> out_keys(n), spend_keys(n);
+    std::vector<crypto::key_derivation> derivations(n);
+    std::vector<size_t> output_indices(n);
+    std::vector<int> good(n);
+
+    // try the shared tx pubkey
+    for (size_t i = 0; i < n; ++i)
+    {
+      out_keys[i] = queries[i].out_key;
+      derivations[i] = *queries[i].derivation;
+      output_indices[i] = queries[i].output_index;
+    }
+    crypto::derive_subaddress_public_keys(out_keys.data(), derivations.data(), output_indices.data(), n, spend_keys.data(), good.data());
+
+    // try additional tx pubkeys, where available, for the outputs not found yet
+    std::vector<size_t> retry;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const out_to_acc_query &q = queries[i];
+      results[i] = boost::none;
+      auto found = good[i] ? subaddresses.find(spend_keys[i]) : subaddresses.end();
+      if (found != subaddresses.end())
+      {
+        results[i] = subaddress_receive_info{ found->second, *q.derivation };
+        continue;
+      }
+      if (!q.additional_derivations || q.additional_derivations->empty())
+        continue;
+      if (q.output_index >= q.additional_derivations->size())
+      {
+        LOG_ERROR("wrong number of additional derivations");
+        continue;
+      }
+      out_keys[retry.size()] = q.out_key;
+      derivations[retry.size()] = (*q.additional_derivations)[q.output_index];
+      output_indices[retry.size()] = q.output_index;
+      retry.push_back(i);
+    }
+    if (retry.empty())
+      return;
+
+    crypto::derive_subaddress_public_keys(out_keys.data(), derivations.data(), output_indices.data(), retry.size(), spend_keys.data(), good.data());
+    for (size_t j = 0; j < retry.size(); ++j)
+    {
+      auto found = good[j] ? subaddresses.find(spend_keys[j]) : subaddresses.end();
+      if (found != subaddresses.end())
+        results[retry[j]] = subaddress_receive_info{ found->second, derivations[j] };
+    }
+  }
+  //---------------------------------------------------------------
   bool lookup_acc_outs(const account_keys& acc, const transaction& tx, std::vector<size_t>& outs, uint64_t& money_transfered)
   {
     crypto::public_key tx_pub_key = get_tx_pub_key_from_extra(tx);
@@ -1021,10 +1085,8 @@ namespace cryptonote
     return get_transaction_hash(t, res, NULL);
   }
   //---------------------------------------------------------------
-  bool calculate_transaction_prunable_hash(const transaction& t, crypto::hash& res)
+  static bool get_transaction_prunable_blob(const transaction& t, blobdata& blob)
   {
-    if (t.version == TxVersion::plain)
-      return false;
     transaction &tt = const_cast<transaction&>(t);
     std::stringstream ss;
     binary_archive<true> ba(ss);
@@ -1033,7 +1095,18 @@ namespace cryptonote
     const size_t mixin = t.vin.empty() ? 0 : t.vin[0].type() == typeid(txin_to_key) ? boost::get<txin_to_key>(t.vin[0]).key_offsets.size() - 1 : 0;
     bool r = tt.rct_signatures.p.serialize_rctsig_prunable(ba, t.rct_signatures.type, inputs, outputs, mixin, t.version);
     CHECK_AND_ASSERT_MES(r, false, "Failed to serialize rct signatures prunable");
-    cryptonote::get_blob_hash(ss.str(), res);
+    blob = ss.str();
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool calculate_transaction_prunable_hash(const transaction& t, crypto::hash& res)
+  {
+    if (t.version == TxVersion::plain)
+      return false;
+    blobdata blob;
+    if (!get_transaction_prunable_blob(t, blob))
+      return false;
+    cryptonote::get_blob_hash(blob, res);
     return true;
   }
   //---------------------------------------------------------------
@@ -1086,12 +1159,18 @@ namespace cryptonote
 
     // v2 transactions hash different parts together, than hash the set of those hashes
     crypto::hash hashes[3];
-
-    // prefix
-    get_transaction_prefix_hash(t, hashes[0]);
+    blobdata blobs[3];
 
     transaction &tt = const_cast<transaction &>(t);
 
+    // prefix
+    {
+      std::ostringstream s;
+      binary_archive<true> a(s);
+      ::serialization::serialize(a, static_cast<transaction_prefix&>(tt));
+      blobs[0] = s.str();
+    }
+
     // base rct
     {
       std::stringstream ss;
@@ -1100,17 +1179,23 @@ namespace cryptonote
       const size_t outputs = t.vout.size();
       bool r = tt.rct_signatures.serialize_rctsig_base(ba, inputs, outputs);
       CHECK_AND_ASSERT_MES(r, false, "Failed to serialize rct signatures base");
-      cryptonote::get_blob_hash(ss.str(), hashes[1]);
+      blobs[1] = ss.str();
     }
 
     // prunable rct
-    if (rct::is_rct_null(t.rct_signatures.type)) {
-      hashes[2] = crypto::null_hash;
-    } else {
-      CHECK_AND_ASSERT_MES(calculate_transaction_prunable_hash(t, hashes[2]), false,
+    const bool has_prunable = !rct::is_rct_null(t.rct_signatures.type);
+    if (has_prunable) {
+      CHECK_AND_ASSERT_MES(get_transaction_prunable_blob(t, blobs[2]), false,
                            "Failed to get tx prunable hash");
+    } else {
+      hashes[2] = crypto::null_hash;
     }
 
+    // the parts are hashed together, as they are independent
+    const void *data[3] = { blobs[0].data(), blobs[1].data(), blobs[2].data() };
+    const size_t lengths[3] = { blobs[0].size(), blobs[1].size(), blobs[2].size() };
+    crypto::cn_fast_hash_n(data, lengths, hashes, has_prunable ? 3 : 2);
+
     // the tx hash is the hash of the 3 hashes
     res = cn_fast_hash(hashes, sizeof(hashes));
 
@@ -1194,6 +1279,44 @@ namespace cryptonote
     return true;
   }
   //---------------------------------------------------------------
+  void get_block_hashes(const std::vector<block>& blocks, std::vector<crypto::hash>& hashes)
+  {
+    hashes.resize(blocks.size());
+    std::vector<blobdata> blobs;
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      if (blocks[i].is_hash_valid())
+      {
+        hashes[i] = blocks[i].hash;
+        ++block_hashes_cached_count;
+        continue;
+      }
+      // as get_object_hash, which hashes the blob serialized with its length
+      blobs.push_back(t_serializable_object_to_blob(get_block_hashing_blob(blocks[i])));
+      indices.push_back(i);
+    }
+    if (indices.empty())
+      return;
+
+    std::vector<const void*> data(blobs.size());
+    std::vector<size_t> lengths(blobs.size());
+    for (size_t n = 0; n < blobs.size(); ++n)
+    {
+      data[n] = blobs[n].data();
+      lengths[n] = blobs[n].size();
+    }
+    std::vector<crypto::hash> calculated(blobs.size());
+    crypto::cn_fast_hash_n(data.data(), lengths.data(), calculated.data(), calculated.size());
+    for (size_t n = 0; n < indices.size(); ++n)
+    {
+      const block &b = blocks[indices[n]];
+      ++block_hashes_calculated_count;
+      hashes[indices[n]] = b.hash = calculated[n];
+      b.set_hash_valid(true);
+    }
+  }
+  //---------------------------------------------------------------
   crypto::hash get_block_hash(const block& b)
   {
     crypto::hash p = null_hash;
@@ -99,6 +99,14 @@ namespace cryptonote {
     crypto::key_derivation derivation;
   };
   boost::optional<subaddress_receive_info> is_out_to_acc_precomp(const std::unordered_map<crypto::public_key, subaddress_index>& subaddresses, const crypto::public_key& out_key, const crypto::key_derivation& derivation, const std::vector<crypto::key_derivation>& additional_derivations, size_t output_index, hw::device &hwdev);
+  struct out_to_acc_query
+  {
+    crypto::public_key out_key;
+    const crypto::key_derivation *derivation;
+    const std::vector<crypto::key_derivation> *additional_derivations; //!< may be null
+    size_t output_index;
+  };
+  void is_out_to_acc_precomp_batch(const std::unordered_map<crypto::public_key, subaddress_index>& subaddresses, const out_to_acc_query *queries, size_t n, boost::optional<subaddress_receive_info> *results, hw::device &hwdev);
   bool lookup_acc_outs(const account_keys& acc, const transaction& tx, const crypto::public_key& tx_pub_key, const std::vector<crypto::public_key>& additional_tx_public_keys, std::vector<size_t>& outs, uint64_t& money_transfered);
   bool lookup_acc_outs(const account_keys& acc, const transaction& tx, std::vector<size_t>& outs, uint64_t& money_transfered);
   bool get_tx_fee(const transaction& tx, uint64_t & fee);
@@ -123,6 +131,8 @@ namespace cryptonote {
   bool calculate_block_hash(const block& b, crypto::hash& res);
   bool get_block_hash(const block& b, crypto::hash& res);
   crypto::hash get_block_hash(const block& b);
+  // as get_block_hash for each block, hashing those not cached yet in one batch
+  void get_block_hashes(const std::vector<block>& blocks, std::vector<crypto::hash>& hashes);
   bool get_block_longhash(const block& b, crypto::hash& res, uint64_t height);
   crypto::hash get_block_longhash(const block& b, uint64_t height);
   bool parse_and_validate_block_from_blob(const blobdata& b_blob, block& b);
@@ -155,6 +155,17 @@
 
 #define DEFAULT_TXPOOL_MAX_WEIGHT               648000000ull // 3 days at 300000, in bytes
 
+#define DEFAULT_TX_RELAY_COST_RATE              2000 // verification cost units per second and peer, about 20 typical txes
+#define DEFAULT_TX_RELAY_COST_BURST             20000
+
+#define DANDELIONPP_STEMS                       2 // outgoing peers stem transactions may go to, 0 floods
+#define DANDELIONPP_FLUFF_PROBABILITY           10 // percent of epochs in which stem transactions are fluffed
+#define DANDELIONPP_EPOCH                       600 // seconds between stem peer changes
+#define DANDELIONPP_EMBARGO_AVERAGE             39 // seconds until fluffing a stem transaction not seen fluffed
+#define DANDELIONPP_FLUFF_INTERVAL              1000 // milliseconds fluffed transactions are batched for
+
+#define VERIFIED_TX_CACHE_SIZE                  16384 // transactions, a few blocks' worth of pool
+
 #define BULLETPROOF_MAX_OUTPUTS                 16
 
 // New constants are intended to go here
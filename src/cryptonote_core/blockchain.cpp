@@ -53,6 +53,7 @@
 #include "warnings.h"
 #include "crypto/hash.h"
 #include "cryptonote_core.h"
+#include "ringct/rctPointCache.h"
 #include "ringct/rctSigs.h"
 #include "common/perf_timer.h"
 #include "common/notify.h"
@@ -131,10 +132,11 @@ static const struct {
 //------------------------------------------------------------------
 Blockchain::Blockchain(tx_memory_pool& tx_pool) :
   m_db(), m_tx_pool(tx_pool), m_hardfork(NULL), m_timestamps_and_difficulties_height(0), m_current_block_cumul_weight_limit(0), m_current_block_cumul_weight_median(0),
-  m_enforce_dns_checkpoints(false), m_max_prepare_blocks_threads(4), m_db_sync_on_blocks(true), m_db_sync_threshold(1), m_db_sync_mode(db_async), m_db_default_sync(false), m_fast_sync(true), m_show_time_stats(false), m_sync_counter(0), m_bytes_to_sync(0), m_cancel(false),
+  m_enforce_dns_checkpoints(false), m_max_prepare_blocks_threads(4), m_db_sync_on_blocks(true), m_db_sync_threshold(1), m_db_sync_mode(db_async), m_db_default_sync(false), m_fast_sync(true), m_show_time_stats(false), m_sync_counter(0), m_bytes_to_sync(0), m_cancel(false), m_db_txn_id(0),
   m_difficulty_for_next_block_top_hash(crypto::null_hash),
   m_difficulty_for_next_block(1),
-  m_btc_valid(false)
+  m_btc_valid(false),
+  m_verified_ring_sigs(VERIFIED_TX_CACHE_SIZE)
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
 }
@@ -458,6 +460,7 @@ bool Blockchain::init(BlockchainDB* db, const network_type nettype, bool offline
   }
 
   update_next_cumulative_weight_limit();
+  m_db_txn_id = m_db->get_last_txn_id();
   return true;
 }
 //------------------------------------------------------------------
@@ -541,6 +544,27 @@ bool Blockchain::deinit()
   return true;
 }
 //------------------------------------------------------------------
+void Blockchain::pop_blocks(uint64_t nblocks)
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+  CRITICAL_REGION_LOCAL(m_tx_pool);
+  CRITICAL_REGION_LOCAL1(m_blockchain_lock);
+
+  const uint64_t blockchain_height = m_db->height();
+  if (blockchain_height > 0)
+    nblocks = std::min(nblocks, blockchain_height - 1);
+
+  bool stop_batch = m_db->batch_start();
+  for (uint64_t i = 0; i < nblocks; ++i)
+    pop_block_from_blockchain();
+  if (stop_batch)
+    m_db->batch_stop();
+
+  // make sure the hard fork object updates its current version, the stale
+  // hf_versions entries are overwritten as blocks are added again
+  m_hardfork->reorganize_from_chain_height(m_db->height());
+}
+//------------------------------------------------------------------
 // This function tells BlockchainDB to remove the top block from the
 // blockchain and then returns all transactions (except the miner tx, of course)
 // from it to the tx_pool
@@ -2740,7 +2764,7 @@ bool Blockchain::expand_transaction_2(transaction &tx, const crypto::hash &tx_pr
 //        check_tx_input() rather than here, and use this function simply
 //        to iterate the inputs as necessary (splitting the task
 //        using threads, etc.)
-bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height)
+bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height, std::vector<const rct::rctSig*> *deferred_rct)
 {
   PERF_TIMER(check_tx_inputs);
   LOG_PRINT_L3("Blockchain::" << __func__);
@@ -3060,11 +3084,25 @@ bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc,
         }
       }
 
-      if (!rct::verRctNonSemanticsSimple(rv))
+      // the key binds the ring members checked above, so a hit is as good as a new check
+      const crypto::hash ring_key = verified_tx_cache::get_ring_key(get_transaction_hash(tx), rv);
+      if (m_verified_ring_sigs.has(ring_key))
+      {
+        MTRACE("Ring signatures of tx " << get_transaction_hash(tx) << " already verified");
+      }
+      else if (deferred_rct)
+      {
+        deferred_rct->push_back(&rv);
+      }
+      else if (!rct::verRctNonSemanticsSimple(rv))
       {
         MERROR_VER("Failed to check ringct signatures!");
         return false;
       }
+      else
+      {
+        m_verified_ring_sigs.add(ring_key);
+      }
       break;
     }
     case (uint8_t)rct::RctType::RCTTypeFull:
@@ -3983,6 +4021,20 @@ leave:
 
   std::vector<transaction> txs;
   key_images_container keys;
+  // the ring signatures of all the block's txes are verified together, spread over the threadpool
+  std::vector<const rct::rctSig*> deferred_rct;
+  std::vector<crypto::hash> deferred_rct_txids;
+
+  // shared by every check below which finds a tx with wrong inputs
+  const auto reject_wrong_inputs = [&](const crypto::hash &tx_id) {
+    MERROR_VER("Block with id: " << id  << " has at least one transaction (id: " << tx_id << ") with wrong inputs.");
+
+    //TODO: why is this done?  make sure that keeping invalid blocks makes sense.
+    add_block_as_invalid(bl, id);
+    MERROR_VER("Block with id " << id << " added as invalid because of wrong inputs in transactions");
+    bvc.m_verifivation_failed = true;
+    return_tx_to_pool(txs);
+  };
 
   uint64_t fee_summary = 0;
   uint64_t t_checktx = 0;
@@ -4034,6 +4086,7 @@ leave:
     // store the list of transactions all at once or return the ones we've
     // taken from the tx_pool back to it if the block fails verification.
     txs.push_back(tx);
+    transaction &block_tx = txs.back(); // stays put, txs was reserved
     TIME_MEASURE_START(dd);
 
     // FIXME: the storage should not be responsible for validation.
@@ -4059,17 +4112,12 @@ leave:
     {
       // validate that transaction inputs and the keys spending them are correct.
       tx_verification_context tvc;
-      if(!check_tx_inputs(tx, tvc))
+      if(!check_tx_inputs(block_tx, tvc, NULL, &deferred_rct))
       {
-        MERROR_VER("Block with id: " << id  << " has at least one transaction (id: " << tx_id << ") with wrong inputs.");
-
-        //TODO: why is this done?  make sure that keeping invalid blocks makes sense.
-        add_block_as_invalid(bl, id);
-        MERROR_VER("Block with id " << id << " added as invalid because of wrong inputs in transactions");
-        bvc.m_verifivation_failed = true;
-        return_tx_to_pool(txs);
+        reject_wrong_inputs(tx_id);
         goto leave;
       }
+      deferred_rct_txids.resize(deferred_rct.size(), tx_id);
     }
 #if defined(PER_BLOCK_CHECKPOINT)
     else
@@ -4078,20 +4126,15 @@ leave:
       // the transaction inputs, but do some sanity checks anyway.
       if (tx_index >= m_blocks_txs_check.size() || memcmp(&m_blocks_txs_check[tx_index++], &tx_id, sizeof(tx_id)) != 0)
       {
-        MERROR_VER("Block with id: " << id << " has at least one transaction (id: " << tx_id << ") with wrong inputs.");
-        //TODO: why is this done?  make sure that keeping invalid blocks makes sense.
-        add_block_as_invalid(bl, id);
-        MERROR_VER("Block with id " << id << " added as invalid because of wrong inputs in transactions");
-        bvc.m_verifivation_failed = true;
-        return_tx_to_pool(txs);
+        reject_wrong_inputs(tx_id);
         goto leave;
       }
     }
 #endif
 
-    if (tx.is_token_genesis()) {
+    if (block_tx.is_token_genesis()) {
       tx_verification_context tvc;
-      if (!check_tgtx(tvc, bvc, tx)) {
+      if (!check_tgtx(tvc, bvc, block_tx)) {
         MERROR_VER("Block with id: " << id  << " has invalid token genesis transaction (id: " << tx_id << ").");
         bvc.m_verifivation_failed = true;
         return_tx_to_pool(txs);
@@ -4105,6 +4148,20 @@ leave:
     cumulative_block_weight += tx_weight;
   }
 
+  if (!deferred_rct.empty())
+  {
+    TIME_MEASURE_START(cc);
+    std::vector<size_t> bad;
+    if (!rct::verRctNonSemanticsSimple(deferred_rct, bad))
+    {
+      MERROR_VER("Failed to check ringct signatures!");
+      reject_wrong_inputs(deferred_rct_txids[bad.front()]);
+      goto leave;
+    }
+    TIME_MEASURE_FINISH(cc);
+    t_checktx += cc;
+  }
+
   m_blocks_txs_check.clear();
 
   TIME_MEASURE_START(vmt);
@@ -4180,6 +4237,10 @@ leave:
         << target_calculating_time << "/" << longhash_calculating_time << "/"
         << t1 << "/" << t2 << "/" << t3 << "/" << t_exists << "/" << t_pool
         << "/" << t_checktx << "/" << t_dblspnd << "/" << vmt << "/" << addblock << ")ms");
+    const rct::point_cache_stats pcs = rct::get_point_cache().get_stats();
+    const uint64_t lookups = pcs.hits + pcs.misses;
+    MINFO("Ring member point cache: " << pcs.entries << " entries, " << pcs.hits << "/" << lookups << " hits ("
+        << (lookups ? pcs.hits * 100 / lookups : 0) << "%)");
   }
 
   bvc.m_added_to_main_chain = true;
@@ -4293,6 +4354,32 @@ void Blockchain::check_against_checkpoints(const checkpoints& points, bool enfor
     m_db->batch_stop();
 }
 //------------------------------------------------------------------
+// reloads cached chain state if the replica's writer changed the database, returns true if it did
+bool Blockchain::refresh_read_only_db()
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+  const uint64_t txn_id = m_db->get_last_txn_id();
+  if (txn_id == m_db_txn_id)
+    return false;
+
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  m_db_txn_id = txn_id;
+
+  // the writer may have popped blocks as well as added them, so nothing
+  // keyed by height alone can be trusted
+  m_timestamps_and_difficulties_height = 0;
+  {
+    CRITICAL_REGION_LOCAL1(m_difficulty_lock);
+    m_difficulty_for_next_block_top_hash = crypto::null_hash;
+  }
+  invalidate_block_template_cache();
+  m_hardfork->init();
+  update_next_cumulative_weight_limit();
+
+  MDEBUG("Database changed by writer, top block now " << m_db->height() - 1);
+  return true;
+}
+//------------------------------------------------------------------
 // returns false if any of the checkpoints loading returns false.
 // That should happen only if a checkpoint is added that conflicts
 // with an existing checkpoint.
@@ -4610,60 +4697,54 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
     MDEBUG("block_batches: " << batches);
     std::vector<std::unordered_map<crypto::hash, crypto::hash>> maps(threads);
     std::vector < std::vector < block >> blocks(threads);
-    auto it = blocks_entry.begin();
 
+    // parse all the blocks first, so their hashes can be computed together
+    std::vector<block> parsed;
+    parsed.reserve(blocks_entry.size());
+    for (const auto &entry : blocks_entry)
+    {
+      block block;
+      if (parse_and_validate_block_from_blob(entry.block, block))
+        parsed.push_back(std::move(block));
+    }
+    std::vector<crypto::hash> block_hashes;
+    get_block_hashes(parsed, block_hashes);
+
+    size_t k = 0;
     for (uint64_t i = 0; i < threads; i++)
     {
       blocks[i].reserve(batches + 1);
-      for (int j = 0; j < batches; j++)
+      for (int j = 0; j < batches && k < parsed.size(); j++, k++)
       {
-        block block;
-
-        if (!parse_and_validate_block_from_blob(it->block, block))
-        {
-          std::advance(it, 1);
-          continue;
-        }
-
         // check first block and skip all blocks if it's not chained properly
-        if (i == 0 && j == 0)
+        if (k == 0)
         {
           crypto::hash tophash = m_db->top_block_hash();
-          if (get_prev_hash(block) != tophash)
+          if (get_prev_hash(parsed[k]) != tophash)
           {
             MDEBUG("Skipping prepare blocks. New blocks don't belong to chain.");
             return true;
           }
         }
-        if (have_block(get_block_hash(block)))
+        if (have_block(block_hashes[k]))
         {
           blocks_exist = true;
           break;
         }
 
-        blocks[i].push_back(std::move(block));
-        std::advance(it, 1);
+        blocks[i].push_back(std::move(parsed[k]));
       }
     }
 
-    for (int i = 0; i < extra && !blocks_exist; i++)
+    for (int i = 0; i < extra && !blocks_exist && k < parsed.size(); i++, k++)
     {
-      block block;
-
-      if (!parse_and_validate_block_from_blob(it->block, block))
-      {
-        std::advance(it, 1);
-        continue;
-      }
-
-      if (have_block(get_block_hash(block)))
+      if (have_block(block_hashes[k]))
       {
         blocks_exist = true;
         break;
       }
 
-      blocks[i].push_back(std::move(block));
-      std::advance(it, 1);
+      blocks[i].push_back(std::move(parsed[k]));
     }
 
     if (!blocks_exist)
@@ -58,6 +58,7 @@
 #include "checkpoints/checkpoints.h"
 #include "cryptonote_basic/hardfork.h"
 #include "blockchain_db/blockchain_db.h"
+#include "verified_tx_cache.h"
 
 namespace tools { class Notify; }
 
@@ -147,6 +148,17 @@ namespace cryptonote
      */
     bool deinit();
 
+    /**
+     * @brief removes blocks from the top of the blockchain
+     *
+     * Blocks are popped as in a reorganization, so their transactions go
+     * back to the pool and the hard fork state is rescanned afterwards.
+     * The genesis block is never removed.
+     *
+     * @param nblocks the number of blocks to remove
+     */
+    void pop_blocks(uint64_t nblocks);
+
     /**
      * @brief assign a set of blockchain checkpoint hashes
      *
@@ -746,6 +758,17 @@ namespace cryptonote
      */
     bool update_checkpoints(const std::string& file_path, bool check_dns);
 
+    /**
+     * @brief picks up blocks committed to a read-only database by another process
+     *
+     * Checks whether the database has changed since the last call, and if
+     * so drops the caches derived from the chain state, so they are rebuilt
+     * from the new top block.
+     *
+     * @return true if the database had changed, false otherwise
+     */
+    bool refresh_read_only_db();
+
 
     // user options, must be called before calling init()
 
@@ -1091,6 +1114,9 @@ namespace cryptonote
 
     std::atomic<bool> m_cancel;
 
+    // last database transaction seen by a read-only replica
+    uint64_t m_db_txn_id;
+
     // block template cache
     block m_btc;
     account_public_address m_btc_address;
@@ -1100,6 +1126,9 @@ namespace cryptonote
     uint64_t m_btc_expected_reward;
     bool m_btc_valid;
 
+    // ring signatures verified on pool admission, not verified again in a block
+    verified_tx_cache m_verified_ring_sigs;
+
     std::shared_ptr<tools::Notify> m_block_notify;
 
     /**
@@ -1160,15 +1189,17 @@ namespace cryptonote
      * of the most recent block which contains an output used in any input set
      *
      * Currently this function calls ring signature validation for each
-     * transaction.
+     * transaction, unless deferred_rct is not NULL, in which case simple
+     * rct signatures are added to it for the caller to verify in bulk.
      *
      * @param tx the transaction to validate
      * @param tvc returned information about tx verification
      * @param pmax_related_block_height return-by-pointer the height of the most recent block in the input set
+     * @param deferred_rct return-by-pointer rct signatures left to verify, must outlive tx's expansion
      *
      * @return false if any validation step fails, otherwise true
      */
-    bool check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height = NULL);
+    bool check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height = NULL, std::vector<const rct::rctSig*> *deferred_rct = NULL);
 
     /**
      * @brief validate token genesis transaction
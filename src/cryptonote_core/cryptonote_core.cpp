@@ -56,6 +56,7 @@ using namespace epee;
 #include "ringct/rctSigs.h"
 #include "common/notify.h"
 #include "mining/miningutil.h"
+#include "snapshot.h"
 #include "version.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -176,11 +177,17 @@ namespace cryptonote
   , "Run a program for each new block, '%s' will be replaced by the block hash"
   , ""
   };
+  static const command_line::arg_descriptor<std::string> arg_load_snapshot = {
+    "load-snapshot"
+  , "Bootstrap an empty database from a snapshot directory made by blockchain-export --snapshot"
+  , ""
+  };
 
   //-----------------------------------------------------------------------------------------------
   core::core(i_cryptonote_protocol* pprotocol):
               m_mempool(m_blockchain_storage),
               m_blockchain_storage(m_mempool),
+              m_local_txs_waiting(0),
               m_miner(this),
               m_miner_address(boost::value_initialized<account_public_address>()),
               m_starter_message_showed(false),
@@ -189,9 +196,11 @@ namespace cryptonote
               m_last_dns_checkpoints_update(0),
               m_last_json_checkpoints_update(0),
               m_disable_dns_checkpoints(false),
+              m_verified_semantics(VERIFIED_TX_CACHE_SIZE),
               m_update_download(0),
               m_nettype(UNDEFINED),
-              m_update_available(false)
+              m_update_available(false),
+              m_db_read_only_replica(false)
   {
     m_checkpoints_updating.clear();
     set_cryptonote_protocol(pprotocol);
@@ -221,7 +230,7 @@ namespace cryptonote
   //-----------------------------------------------------------------------------------------------
   bool core::update_checkpoints()
   {
-    if (m_nettype != MAINNET || m_disable_dns_checkpoints) return true;
+    if (m_nettype != MAINNET || m_disable_dns_checkpoints || m_db_read_only_replica) return true;
 
     if (m_checkpoints_updating.test_and_set()) return true;
 
@@ -286,6 +295,7 @@ namespace cryptonote
     command_line::add_arg(desc, arg_disable_dns_checkpoints);
     command_line::add_arg(desc, arg_max_txpool_weight);
     command_line::add_arg(desc, arg_block_notify);
+    command_line::add_arg(desc, arg_load_snapshot);
 
     miner::init_options(desc);
     BlockchainDB::init_options(desc);
@@ -330,7 +340,9 @@ namespace cryptonote
     set_enforce_dns_checkpoints(command_line::get_arg(vm, arg_dns_checkpoints));
     test_drop_download_height(command_line::get_arg(vm, arg_test_drop_download_height));
     m_fluffy_blocks_enabled = !get_arg(vm, arg_no_fluffy_blocks);
-    m_offline = get_arg(vm, arg_offline);
+    m_db_read_only_replica = get_arg(vm, arg_db_read_only_replica);
+    // a replica never syncs, it only serves what the writer commits
+    m_offline = get_arg(vm, arg_offline) || m_db_read_only_replica;
     m_disable_dns_checkpoints = get_arg(vm, arg_disable_dns_checkpoints);
     if (!command_line::is_arg_defaulted(vm, arg_fluffy_blocks))
       MWARNING(arg_fluffy_blocks.name << " is obsolete, it is now default");
@@ -384,6 +396,12 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::get_txpool_fee_rate_ladder(uint64_t block_weight, uint64_t n_blocks, std::vector<fee_rate_step> &ladder, std::vector<fee_rate_percentile> &percentiles, uint64_t &txs_total, uint64_t &weight_total) const
+  {
+    m_mempool.get_fee_rate_ladder(block_weight, n_blocks, ladder, percentiles, txs_total, weight_total);
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::get_transactions(const std::vector<crypto::hash>& txs_ids, std::vector<transaction>& txs, std::vector<crypto::hash>& missed_txs) const
   {
     return m_blockchain_storage.get_transactions(txs_ids, txs, missed_txs);
@@ -467,6 +485,12 @@ namespace cryptonote
     bool sync_on_blocks = true;
     uint64_t sync_threshold = 1;
 
+    if (m_db_read_only_replica && (m_nettype == FAKECHAIN || !command_line::is_arg_defaulted(vm, arg_load_snapshot)))
+    {
+      MERROR("A read-only replica can only follow an existing database");
+      return false;
+    }
+
     if (m_nettype == FAKECHAIN)
     {
       // reset the db by removing the database file before opening it
@@ -477,6 +501,30 @@ namespace cryptonote
       }
     }
 
+    // blocks above the last checkpoint the snapshot matched are not trusted,
+    // and get popped once the database is open so they are synced normally
+    uint64_t snapshot_trusted_height = 0;
+    const std::string snapshot_dir = command_line::get_arg(vm, arg_load_snapshot);
+    if (!snapshot_dir.empty())
+    {
+      checkpoints points;
+      points.init_default_checkpoints(m_nettype);
+      if (!m_checkpoints_path.empty() && !points.load_checkpoints_from_json(m_checkpoints_path))
+      {
+        MERROR("Failed to load checkpoints from " << m_checkpoints_path);
+        return false;
+      }
+      if (!m_disable_dns_checkpoints && !m_offline && !points.load_checkpoints_from_dns(m_nettype))
+        MWARNING("Failed to load DNS checkpoints, checking snapshot against other checkpoints only");
+
+      MGINFO("Loading snapshot from " << snapshot_dir << " ...");
+      if (!install_snapshot(snapshot_dir, filename, points, snapshot_trusted_height))
+      {
+        MERROR("Failed to load snapshot from " << snapshot_dir);
+        return false;
+      }
+    }
+
     try
     {
       uint64_t db_flags = 0;
@@ -554,9 +602,22 @@ namespace cryptonote
       if (db_salvage)
         db_flags |= DBF_SALVAGE;
 
+      if (m_db_read_only_replica)
+      {
+        MGINFO("Opening database as a read-only replica");
+        db_flags = DBF_RDONLY;
+      }
+
+      db->set_cold_data_folder(command_line::get_arg(vm, cryptonote::arg_db_cold_data_dir));
       db->open(filename, db_flags);
       if(!db->m_open)
         return false;
+
+      if (m_db_read_only_replica && db->height() == 0)
+      {
+        MERROR("Database in " << filename << " is empty, a read-only replica needs a writer to have created it");
+        return false;
+      }
     }
     catch (const DB_ERROR& e)
     {
@@ -587,9 +648,17 @@ namespace cryptonote
     r = m_mempool.init(max_txpool_weight);
     CHECK_AND_ASSERT_MES(r, false, "Failed to initialize memory pool");
 
+    if (!snapshot_dir.empty() && m_blockchain_storage.get_current_blockchain_height() > snapshot_trusted_height + 1)
+    {
+      const uint64_t nblocks = m_blockchain_storage.get_current_blockchain_height() - snapshot_trusted_height - 1;
+      MGINFO("Removing " << nblocks << " snapshot blocks above checkpoint " << snapshot_trusted_height);
+      m_blockchain_storage.pop_blocks(nblocks);
+    }
+
     // now that we have a valid m_blockchain_storage, we can clean out any
     // transactions in the pool that do not conform to the current fork
-    m_mempool.validate(m_blockchain_storage.get_current_hard_fork_version());
+    if (!m_db_read_only_replica)
+      m_mempool.validate(m_blockchain_storage.get_current_hard_fork_version());
 
     bool show_time_stats = command_line::get_arg(vm, arg_show_time_stats) != 0;
     m_blockchain_storage.set_show_time_stats(show_time_stats);
@@ -773,6 +842,7 @@ namespace cryptonote
 
     std::vector<const rct::rctSig*> rvv;
     std::vector<const rct::rctSig*> rvvb;
+    std::vector<size_t> rvv_txs, rvvb_txs; // index in tx_info of each batched rctSig
     for (size_t n = 0; n < tx_info.size(); ++n)
     {
       if (!check_tx_semantic(*tx_info[n].tx, keeped_by_block))
@@ -782,6 +852,13 @@ namespace cryptonote
         tx_info[n].result = false;
         continue;
       }
+      // layout checks are cheap and still done, only the proofs are skipped
+      bool preverified = false;
+      if (keeped_by_block)
+        preverified = is_semantics_preverified_tx(tx_info[n].tx_hash);
+      // the txid binds the whole tx, so semantics verified once stay verified
+      if (!preverified)
+        preverified = m_verified_semantics.has(tx_info[n].tx_hash);
 
       if (tx_info[n].tx->version < 2)
         continue;
@@ -823,7 +900,11 @@ namespace cryptonote
             tx_info[n].result = false;
             break;
           }
-          rvv.push_back(&rv); // delayed batch verification
+          if (!preverified)
+          {
+            rvv.push_back(&rv); // delayed batch verification
+            rvv_txs.push_back(n);
+          }
           break;
         case (uint8_t)rct::RctType::RCTTypeBigBulletproof:
           if (!is_canonical_big_bulletproof_layout(rv.p.bigBulletproofs))
@@ -834,7 +915,11 @@ namespace cryptonote
             tx_info[n].result = false;
             break;
           }
-          rvvb.push_back(&rv); // delayed batch verification
+          if (!preverified)
+          {
+            rvvb.push_back(&rv); // delayed batch verification
+            rvvb_txs.push_back(n);
+          }
           break;
         default:
           MERROR_VER("Unknown rct type: " << rv.type);
@@ -844,53 +929,73 @@ namespace cryptonote
           break;
       }
     }
-    if (!rvv.empty() && !rct::verRctSemanticsSimple(rvv))
+    // bad proofs in a failed batch are found by bisecting it
+    std::vector<size_t> bad;
+    if (!rct::verRctSemanticsSimple(rvv, bad))
     {
-      LOG_PRINT_L1("One transaction among this group has bad semantics, verifying one at a time");
+      LOG_PRINT_L1(bad.size() << " of " << rvv.size() << " transactions in this group have bad semantics");
       ret = false;
-      const bool assumed_bad = rvv.size() == 1; // if there's only one tx, it must be the bad one
-      for (size_t n = 0; n < tx_info.size(); ++n)
+      for (size_t i: bad)
       {
-        if (!tx_info[n].result)
-          continue;
-        if (tx_info[n].tx->rct_signatures.type != rct::RctType::RCTTypeBulletproof)
-          continue;
-        if (assumed_bad || !rct::verRctSemanticsSimple(tx_info[n].tx->rct_signatures))
-        {
-          set_semantics_failed(tx_info[n].tx_hash);
-          tx_info[n].tvc.m_verifivation_failed = true;
-          tx_info[n].result = false;
-        }
+        const size_t n = rvv_txs[i];
+        set_semantics_failed(tx_info[n].tx_hash);
+        tx_info[n].tvc.m_verifivation_failed = true;
+        tx_info[n].result = false;
       }
     }
 
-    if (!rvvb.empty() && !rct::verRctSemanticsSimpleBig(rvvb))
+    if (!rct::verRctSemanticsSimpleBig(rvvb, bad))
     {
-      LOG_PRINT_L1("One transaction among this group has bad semantics, verifying one at a time");
+      LOG_PRINT_L1(bad.size() << " of " << rvvb.size() << " transactions in this group have bad semantics");
       ret = false;
-      const bool assumed_bad = rvv.size() == 1; // if there's only one tx, it must be the bad one
-//      for (size_t n = 0; n < tx_info.size(); ++n)
-//      {
-//        if (!tx_info[n].result)
-//          continue;
-//        if (tx_info[n].tx->rct_signatures.type != rct::RCTTypeBigBulletproof)
-//          continue;
-//        if (assumed_bad || !rct::verRctSemanticsSimpleBig(tx_info[n].tx->rct_signatures))
-//        {
-//          set_semantics_failed(tx_info[n].tx_hash);
-//          tx_info[n].tvc.m_verifivation_failed = true;
-//          tx_info[n].result = false;
-//        }
-//      }
+      for (size_t i: bad)
+      {
+        const size_t n = rvvb_txs[i];
+        set_semantics_failed(tx_info[n].tx_hash);
+        tx_info[n].tvc.m_verifivation_failed = true;
+        tx_info[n].result = false;
+      }
     }
 
+    for (const size_t n: rvv_txs)
+      if (tx_info[n].result)
+        m_verified_semantics.add(tx_info[n].tx_hash);
+    for (const size_t n: rvvb_txs)
+      if (tx_info[n].result)
+        m_verified_semantics.add(tx_info[n].tx_hash);
+
     return ret;
   }
   //-----------------------------------------------------------------------------------------------
   bool core::handle_incoming_txs(const std::vector<blobdata>& tx_blobs, std::vector<tx_verification_context>& tvc, bool keeped_by_block, bool relayed, bool do_not_relay)
   {
     TRY_ENTRY();
+    // locally submitted txes go ahead of those relayed by peers, so wallets
+    // are not held up behind a flood from the network
+    const bool local = !keeped_by_block && !relayed;
+    {
+      boost::unique_lock<boost::mutex> lock(m_local_txs_lock);
+      if (local)
+        ++m_local_txs_waiting;
+      else if (!keeped_by_block)
+        m_local_txs_cond.wait(lock, [this]() { return m_local_txs_waiting == 0; });
+    }
     CRITICAL_REGION_LOCAL(m_incoming_tx_lock);
+    if (local)
+    {
+      boost::unique_lock<boost::mutex> lock(m_local_txs_lock);
+      if (--m_local_txs_waiting == 0)
+        m_local_txs_cond.notify_all();
+    }
+
+    if (m_db_read_only_replica)
+    {
+      MERROR("Read-only replica cannot accept transactions");
+      tvc.assign(tx_blobs.size(), tx_verification_context());
+      for (auto &v: tvc)
+        v.m_verifivation_failed = true;
+      return false;
+    }
 
     struct result { bool res; cryptonote::transaction tx; crypto::hash hash; crypto::hash prefix_hash; bool in_txpool; bool in_blockchain; };
     std::vector<result> results(tx_blobs.size());
@@ -1463,10 +1568,112 @@ namespace cryptonote
   bool core::prepare_handle_incoming_blocks(const std::vector<block_complete_entry> &blocks)
   {
     m_incoming_tx_lock.lock();
+    preverify_range_proofs(blocks);
     m_blockchain_storage.prepare_handle_incoming_blocks(blocks);
     return true;
   }
 
+  //-----------------------------------------------------------------------------------------------
+  void core::preverify_range_proofs(const std::vector<block_complete_entry> &blocks)
+  {
+    // the caller holds m_incoming_tx_lock, so nothing may escape; failing here
+    // only means the txs get verified one by one when their block is handled
+    try
+    {
+      if (blocks.size() < 2 || m_blockchain_storage.is_within_compiled_block_hash_area())
+        return;
+
+      struct span_tx
+      {
+        const blobdata *blob;
+        size_t block;
+        transaction tx;
+        crypto::hash hash;
+        bool parsed;
+      };
+      std::vector<span_tx> txs;
+      for (size_t b = 0; b < blocks.size(); ++b)
+        for (const blobdata &blob: blocks[b].txs)
+          txs.push_back({&blob, b, transaction(), crypto::null_hash, false});
+      if (txs.empty())
+        return;
+
+      tools::threadpool& tpool = tools::threadpool::getInstance();
+      tools::threadpool::waiter waiter;
+      const size_t threads = std::max(1u, tpool.get_max_concurrency());
+      const size_t chunk = (txs.size() + threads - 1) / threads;
+      for (size_t begin = 0; begin < txs.size(); begin += chunk)
+      {
+        const size_t end = std::min(txs.size(), begin + chunk);
+        tpool.submit(&waiter, [&txs, begin, end]() {
+          for (size_t i = begin; i < end; ++i)
+          {
+            span_tx &stx = txs[i];
+            stx.parsed = parse_and_validate_tx_from_blob(*stx.blob, stx.tx);
+            if (stx.parsed)
+              stx.hash = get_transaction_hash(stx.tx);
+          }
+        });
+      }
+      waiter.wait(&tpool);
+
+      std::vector<const rct::rctSig*> rvv, rvvb;
+      std::vector<size_t> rvv_txs, rvvb_txs;
+      {
+        boost::lock_guard<boost::mutex> lock(m_semantics_preverified_txes_lock);
+        for (size_t i = 0; i < txs.size(); ++i)
+        {
+          const span_tx &stx = txs[i];
+          if (!stx.parsed || stx.tx.version < TxVersion::ring_signatures || m_semantics_preverified_txes.find(stx.hash) != m_semantics_preverified_txes.end())
+            continue;
+          const rct::rctSig &rv = stx.tx.rct_signatures;
+          if (rv.type == rct::RctType::RCTTypeBulletproof && is_canonical_bulletproof_layout(rv.p.bulletproofs))
+          {
+            rvv.push_back(&rv);
+            rvv_txs.push_back(i);
+          }
+          else if (rv.type == rct::RctType::RCTTypeBigBulletproof && is_canonical_big_bulletproof_layout(rv.p.bigBulletproofs))
+          {
+            rvvb.push_back(&rv);
+            rvvb_txs.push_back(i);
+          }
+        }
+      }
+
+      std::vector<crypto::hash> preverified;
+      std::vector<size_t> bad;
+      const auto collect = [&](const std::vector<size_t> &batch_txs) {
+        size_t next_bad = 0;
+        for (size_t i = 0; i < batch_txs.size(); ++i)
+        {
+          const span_tx &stx = txs[batch_txs[i]];
+          if (next_bad < bad.size() && bad[next_bad] == i)
+          {
+            ++next_bad;
+            MERROR_VER("Range proof of tx " << stx.hash << " in block " << stx.block << " of the span failed batch verification");
+            continue;
+          }
+          preverified.push_back(stx.hash);
+        }
+      };
+      rct::verRctSemanticsSimple(rvv, bad);
+      collect(rvv_txs);
+      rct::verRctSemanticsSimpleBig(rvvb, bad);
+      collect(rvvb_txs);
+
+      MDEBUG("Batch verified " << preverified.size() << " range proofs across " << blocks.size() << " blocks");
+      add_semantics_preverified_txs(preverified);
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Failed to batch verify range proofs: " << e.what());
+    }
+    catch (...)
+    {
+      MERROR("Failed to batch verify range proofs");
+    }
+  }
+
   //-----------------------------------------------------------------------------------------------
   bool core::cleanup_handle_incoming_blocks(bool force_sync)
   {
@@ -1475,10 +1682,28 @@ namespace cryptonote
       success = m_blockchain_storage.cleanup_handle_incoming_blocks(force_sync);
     }
     catch (...) {}
+    {
+      boost::lock_guard<boost::mutex> lock(m_semantics_preverified_txes_lock);
+      m_semantics_preverified_txes.clear();
+    }
     m_incoming_tx_lock.unlock();
     return success;
   }
 
+  //-----------------------------------------------------------------------------------------------
+  void core::add_semantics_preverified_txs(const std::vector<crypto::hash> &tx_hashes)
+  {
+    boost::lock_guard<boost::mutex> lock(m_semantics_preverified_txes_lock);
+    m_semantics_preverified_txes.insert(tx_hashes.begin(), tx_hashes.end());
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  bool core::is_semantics_preverified_tx(const crypto::hash &tx_hash)
+  {
+    boost::lock_guard<boost::mutex> lock(m_semantics_preverified_txes_lock);
+    return m_semantics_preverified_txes.find(tx_hash) != m_semantics_preverified_txes.end();
+  }
+
   //-----------------------------------------------------------------------------------------------
   bool core::handle_incoming_block(const blobdata& block_blob, block_verification_context& bvc, bool update_miner_blocktemplate)
   {
@@ -1489,6 +1714,12 @@ namespace cryptonote
     CHECK_AND_ASSERT_MES(update_checkpoints(), false, "One or more checkpoints loaded from json or dns conflicted with existing checkpoints.");
 
     bvc = boost::value_initialized<block_verification_context>();
+    if (m_db_read_only_replica)
+    {
+      MERROR("Read-only replica cannot accept blocks");
+      bvc.m_verifivation_failed = true;
+      return false;
+    }
     if(block_blob.size() > get_max_block_size())
     {
       LOG_PRINT_L1("WRONG BLOCK BLOB, too big size " << block_blob.size() << ", rejected");
@@ -1643,8 +1874,16 @@ namespace cryptonote
       m_starter_message_showed = true;
     }
 
+    if (m_db_read_only_replica)
+    {
+      // the writer may have committed blocks or pool changes since last time
+      if (m_blockchain_storage.refresh_read_only_db())
+        m_mempool.reload();
+    }
+
     m_fork_moaner.do_call(boost::bind(&core::check_fork_time, this));
-    m_txpool_auto_relayer.do_call(boost::bind(&core::relay_txpool_transactions, this));
+    if (!m_db_read_only_replica)
+      m_txpool_auto_relayer.do_call(boost::bind(&core::relay_txpool_transactions, this));
     m_check_updates_interval.do_call(boost::bind(&core::check_updates, this));
     m_check_disk_space_interval.do_call(boost::bind(&core::check_disk_space, this));
     m_miner.on_idle();
@@ -36,6 +36,8 @@
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "cryptonote_protocol/cryptonote_protocol_handler_common.h"
 #include "storages/portable_storage_template_helper.h"
@@ -168,6 +170,43 @@ namespace cryptonote
       */
      bool cleanup_handle_incoming_blocks(bool force_sync = false);
 
+     /**
+      * @brief marks transactions as already having had their rct semantics verified
+      *
+      * Callers which verify range proofs in bulk ahead of time (eg, the
+      * blockchain importer) use this so the transactions are not verified
+      * again when they come in as part of a block.  Only transactions kept
+      * by block are affected, and the marks are dropped by
+      * cleanup_handle_incoming_blocks.
+      *
+      * @param tx_hashes the hashes of the verified transactions
+      */
+     void add_semantics_preverified_txs(const std::vector<crypto::hash> &tx_hashes);
+
+     /**
+      * @brief checks whether a transaction is marked as having had its rct semantics verified
+      *
+      * @param tx_hash the hash of the transaction
+      *
+      * @return true if the transaction is marked, false otherwise
+      */
+     bool is_semantics_preverified_tx(const crypto::hash &tx_hash);
+
+     /**
+      * @brief batch verifies the range proofs of all the transactions in a span of blocks
+      *
+      * Multiexp throughput grows with the batch size, so verifying a whole
+      * span at once beats verifying each block's transactions on their own.
+      * Transactions which pass are marked as preverified; bad ones are found
+      * by bisection and left unmarked, so they fail again, and take their
+      * block down, when it is handled.
+      *
+      * Called by prepare_handle_incoming_blocks, with m_incoming_tx_lock held.
+      *
+      * @param blocks the blocks about to be handled
+      */
+     void preverify_range_proofs(const std::vector<block_complete_entry> &blocks);
+
      /**
       * @brief check the size of a block against the current maximum
       *
@@ -455,6 +494,13 @@ namespace cryptonote
       */
      bool get_txpool_backlog(std::vector<tx_backlog_entry>& backlog) const;
 
+     /**
+      * @copydoc tx_memory_pool::get_fee_rate_ladder
+      *
+      * @note see tx_memory_pool::get_fee_rate_ladder
+      */
+     bool get_txpool_fee_rate_ladder(uint64_t block_weight, uint64_t n_blocks, std::vector<fee_rate_step> &ladder, std::vector<fee_rate_percentile> &percentiles, uint64_t &txs_total, uint64_t &weight_total) const;
+
      /**
       * @copydoc tx_memory_pool::get_transactions
       * @param include_unrelayed_txes include unrelayed txes in result
@@ -803,6 +849,13 @@ namespace cryptonote
       */
      bool offline() const { return m_offline; }
 
+     /**
+      * @brief get whether the core follows a database written by another daemon
+      *
+      * @return whether the core is a read-only replica
+      */
+     bool read_only_replica() const { return m_db_read_only_replica; }
+
    private:
 
      /**
@@ -983,6 +1036,10 @@ namespace cryptonote
 
      epee::critical_section m_incoming_tx_lock; //!< incoming transaction lock
 
+     boost::mutex m_local_txs_lock; //!< guards m_local_txs_waiting
+     boost::condition_variable m_local_txs_cond; //!< signalled when no locally submitted transaction waits
+     unsigned m_local_txs_waiting; //!< locally submitted transactions waiting for m_incoming_tx_lock
+
      //m_miner and m_miner_addres are probably temporary here
      miner m_miner; //!< miner instance
      account_public_address m_miner_address; //!< address to mine to (for miner instance)
@@ -1019,6 +1076,11 @@ namespace cryptonote
      std::unordered_set<crypto::hash> bad_semantics_txes[2];
      boost::mutex bad_semantics_txes_lock;
 
+     std::unordered_set<crypto::hash> m_semantics_preverified_txes; //!< txes whose rct semantics were checked by the caller
+     boost::mutex m_semantics_preverified_txes_lock;
+
+     verified_tx_cache m_verified_semantics; //!< txes whose rct semantics were verified here before
+
      enum {
        UPDATES_DISABLED,
        UPDATES_NOTIFY,
@@ -1032,6 +1094,7 @@ namespace cryptonote
 
      bool m_fluffy_blocks_enabled;
      bool m_offline;
+     bool m_db_read_only_replica; //!< the database is opened read-only and followed, never written
    };
 }
 
@@ -0,0 +1,237 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+
+#include "fee_rate_index.h"
+
+namespace cryptonote
+{
+  struct fee_rate_index::node
+  {
+    key k;
+    uint64_t weight;
+    uint32_t priority;
+    size_t count;           //!< transactions in this subtree
+    uint64_t total_weight;  //!< weight of the transactions in this subtree
+    std::unique_ptr<node> left, right;
+
+    node(const key &k, uint64_t weight, uint32_t priority):
+      k(k), weight(weight), priority(priority), count(1), total_weight(weight) {}
+  };
+  //---------------------------------------------------------------------------------
+  fee_rate_index::fee_rate_index(): m_seed(0x9e3779b9)
+  {
+  }
+  //---------------------------------------------------------------------------------
+  fee_rate_index::~fee_rate_index()
+  {
+  }
+  //---------------------------------------------------------------------------------
+  bool fee_rate_index::less(const key &a, const key &b)
+  {
+    // highest fee per byte first
+    if (a.fee_per_byte != b.fee_per_byte)
+      return a.fee_per_byte > b.fee_per_byte;
+    return memcmp(&a.txid, &b.txid, sizeof(a.txid)) < 0;
+  }
+  //---------------------------------------------------------------------------------
+  void fee_rate_index::update(node *n)
+  {
+    n->count = 1;
+    n->total_weight = n->weight;
+    if (n->left)
+    {
+      n->count += n->left->count;
+      n->total_weight += n->left->total_weight;
+    }
+    if (n->right)
+    {
+      n->count += n->right->count;
+      n->total_weight += n->right->total_weight;
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void fee_rate_index::split(std::unique_ptr<node> t, const key &k, std::unique_ptr<node> &l, std::unique_ptr<node> &r)
+  {
+    if (!t)
+    {
+      l.reset();
+      r.reset();
+      return;
+    }
+    if (less(t->k, k))
+    {
+      split(std::move(t->right), k, t->right, r);
+      update(t.get());
+      l = std::move(t);
+    }
+    else
+    {
+      split(std::move(t->left), k, l, t->left);
+      update(t.get());
+      r = std::move(t);
+    }
+  }
+  //---------------------------------------------------------------------------------
+  std::unique_ptr<fee_rate_index::node> fee_rate_index::merge(std::unique_ptr<node> a, std::unique_ptr<node> b)
+  {
+    if (!a)
+      return b;
+    if (!b)
+      return a;
+    if (a->priority > b->priority)
+    {
+      a->right = merge(std::move(a->right), std::move(b));
+      update(a.get());
+      return a;
+    }
+    b->left = merge(std::move(a), std::move(b->left));
+    update(b.get());
+    return b;
+  }
+  //---------------------------------------------------------------------------------
+  bool fee_rate_index::erase(std::unique_ptr<node> &t, const key &k)
+  {
+    if (!t)
+      return false;
+    bool r;
+    if (less(k, t->k))
+      r = erase(t->left, k);
+    else if (less(t->k, k))
+      r = erase(t->right, k);
+    else
+    {
+      t = merge(std::move(t->left), std::move(t->right));
+      return true;
+    }
+    if (r)
+      update(t.get());
+    return r;
+  }
+  //---------------------------------------------------------------------------------
+  uint32_t fee_rate_index::next_priority()
+  {
+    // xorshift32, the priorities only need to look random to the tree shape
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+  }
+  //---------------------------------------------------------------------------------
+  void fee_rate_index::insert(const crypto::hash &txid, double fee_per_byte, uint64_t weight)
+  {
+    erase(txid);
+    const key k{fee_per_byte, txid};
+    std::unique_ptr<node> l, r;
+    split(std::move(m_root), k, l, r);
+    std::unique_ptr<node> n(new node(k, weight, next_priority()));
+    m_root = merge(merge(std::move(l), std::move(n)), std::move(r));
+    m_fee_rates[txid] = fee_per_byte;
+  }
+  //---------------------------------------------------------------------------------
+  bool fee_rate_index::erase(const crypto::hash &txid)
+  {
+    const auto i = m_fee_rates.find(txid);
+    if (i == m_fee_rates.end())
+      return false;
+    const key k{i->second, txid};
+    m_fee_rates.erase(i);
+    return erase(m_root, k);
+  }
+  //---------------------------------------------------------------------------------
+  void fee_rate_index::clear()
+  {
+    m_root.reset();
+    m_fee_rates.clear();
+  }
+  //---------------------------------------------------------------------------------
+  size_t fee_rate_index::size() const
+  {
+    return m_root ? m_root->count : 0;
+  }
+  //---------------------------------------------------------------------------------
+  uint64_t fee_rate_index::total_weight() const
+  {
+    return m_root ? m_root->total_weight : 0;
+  }
+  //---------------------------------------------------------------------------------
+  const fee_rate_index::node *fee_rate_index::get_by_rank(size_t rank) const
+  {
+    const node *n = m_root.get();
+    while (n)
+    {
+      const size_t left = n->left ? n->left->count : 0;
+      if (rank < left)
+        n = n->left.get();
+      else if (rank == left)
+        return n;
+      else
+      {
+        rank -= left + 1;
+        n = n->right.get();
+      }
+    }
+    return NULL;
+  }
+  //---------------------------------------------------------------------------------
+  double fee_rate_index::get_percentile(double percentile) const
+  {
+    const size_t n = size();
+    if (n == 0)
+      return 0.0;
+    if (percentile < 0.0)
+      percentile = 0.0;
+    else if (percentile > 100.0)
+      percentile = 100.0;
+    // ranks go from the highest fee per byte down
+    const size_t rank_from_lowest = (size_t)(percentile / 100.0 * (n - 1) + 0.5);
+    return get_by_rank(n - 1 - rank_from_lowest)->k.fee_per_byte;
+  }
+  //---------------------------------------------------------------------------------
+  double fee_rate_index::get_fee_rate_at_weight(uint64_t weight) const
+  {
+    if (total_weight() <= weight)
+      return 0.0;
+    const node *n = m_root.get();
+    while (n)
+    {
+      const uint64_t left = n->left ? n->left->total_weight : 0;
+      if (weight < left)
+        n = n->left.get();
+      else if (weight < left + n->weight)
+        return n->k.fee_per_byte;
+      else
+      {
+        weight -= left + n->weight;
+        n = n->right.get();
+      }
+    }
+    return 0.0;
+  }
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include "crypto/hash.h"
+
+namespace cryptonote
+{
+  /**
+   * @brief an order statistic tree of transactions keyed by fee per byte
+   *
+   * Transactions are ordered by decreasing fee per byte, ties broken by
+   * txid, and every node keeps the count and total weight of its subtree,
+   * so ranks, percentiles and cumulative weights are found in O(log n).
+   * This is a treap with deterministic priorities; it is not thread safe.
+   */
+  class fee_rate_index
+  {
+  public:
+    fee_rate_index();
+    ~fee_rate_index();
+
+    /**
+     * @brief adds a transaction, replacing it if already present
+     */
+    void insert(const crypto::hash &txid, double fee_per_byte, uint64_t weight);
+
+    /**
+     * @brief removes a transaction
+     *
+     * @return false if the transaction was not present
+     */
+    bool erase(const crypto::hash &txid);
+
+    void clear();
+
+    size_t size() const;
+    uint64_t total_weight() const;
+
+    /**
+     * @brief get the fee per byte at a given percentile
+     *
+     * @param percentile from 0 (lowest fee per byte) to 100 (highest)
+     *
+     * @return the fee per byte, 0 if empty
+     */
+    double get_percentile(double percentile) const;
+
+    /**
+     * @brief get the fee per byte a transaction needs to come before a given weight
+     *
+     * Walking transactions from the highest fee per byte down, returns the
+     * fee per byte of the one which takes the cumulative weight past
+     * weight. A transaction paying more than that would be mined within
+     * that much block space, if blocks are filled by fee per byte.
+     *
+     * @param weight the weight to fit into
+     *
+     * @return the fee per byte, 0 if all transactions fit in weight
+     */
+    double get_fee_rate_at_weight(uint64_t weight) const;
+
+  private:
+    struct key
+    {
+      double fee_per_byte;
+      crypto::hash txid;
+    };
+    struct node;
+
+    static bool less(const key &a, const key &b);
+    static void update(node *n);
+    static void split(std::unique_ptr<node> t, const key &k, std::unique_ptr<node> &l, std::unique_ptr<node> &r);
+    static std::unique_ptr<node> merge(std::unique_ptr<node> a, std::unique_ptr<node> b);
+    static bool erase(std::unique_ptr<node> &t, const key &k);
+    const node *get_by_rank(size_t rank) const;
+    uint32_t next_priority();
+
+    std::unique_ptr<node> m_root;
+    std::unordered_map<crypto::hash, double> m_fee_rates;
+    uint32_t m_seed;
+  };
+}
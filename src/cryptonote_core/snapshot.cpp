@@ -0,0 +1,217 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <memory>
+#include <boost/filesystem.hpp>
+
+#include "snapshot.h"
+#include "string_tools.h"
+#include "storages/portable_storage_template_helper.h"
+#include "cryptonote_config.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "snapshot"
+
+namespace cryptonote
+{
+  namespace
+  {
+    std::unique_ptr<BlockchainDB> open_snapshot_db(const std::string& db_type, const std::string& snapshot_dir)
+    {
+      std::unique_ptr<BlockchainDB> db(new_db(db_type));
+      if (!db)
+      {
+        MERROR("Unsupported snapshot database type: " << db_type);
+        return nullptr;
+      }
+      db->open(snapshot_dir, DBF_RDONLY);
+      return db;
+    }
+
+    std::vector<snapshot_table_hash> get_table_hashes(const BlockchainDB& db)
+    {
+      std::vector<snapshot_table_hash> tables;
+      for (const auto &table: db.get_table_hashes())
+      {
+        snapshot_table_hash th;
+        th.name = table.first;
+        th.hash = epee::string_tools::pod_to_hex(table.second);
+        tables.push_back(th);
+      }
+      return tables;
+    }
+  }
+
+  bool create_snapshot(const BlockchainDB& db, const std::string& snapshot_dir)
+  {
+    const boost::filesystem::path dir(snapshot_dir);
+    if (boost::filesystem::exists(dir / CRYPTONOTE_BLOCKCHAINDATA_FILENAME))
+    {
+      MERROR("A database already exists in " << snapshot_dir);
+      return false;
+    }
+
+    try
+    {
+      MINFO("Copying database to " << snapshot_dir);
+      db.copy_compacted(snapshot_dir);
+
+      // hash the copy, not the source, which may have moved on since
+      std::unique_ptr<BlockchainDB> copy = open_snapshot_db(db.get_db_name(), snapshot_dir);
+      if (!copy)
+        return false;
+
+      snapshot_manifest manifest;
+      manifest.version = SNAPSHOT_MANIFEST_VERSION;
+      manifest.db_type = copy->get_db_name();
+      manifest.height = copy->height();
+      manifest.top_block_hash = epee::string_tools::pod_to_hex(copy->top_block_hash());
+      MINFO("Hashing database tables");
+      manifest.tables = get_table_hashes(*copy);
+      copy->close();
+
+      const std::string manifest_path = (dir / SNAPSHOT_MANIFEST_FILENAME).string();
+      if (!epee::serialization::store_t_to_json_file(manifest, manifest_path))
+      {
+        MERROR("Failed to write snapshot manifest to " << manifest_path);
+        return false;
+      }
+      MINFO("Snapshot of " << manifest.height << " blocks written to " << snapshot_dir);
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Failed to create snapshot: " << e.what());
+      return false;
+    }
+    return true;
+  }
+
+  bool verify_snapshot(const std::string& snapshot_dir, const checkpoints& points, uint64_t& trusted_height)
+  {
+    const boost::filesystem::path dir(snapshot_dir);
+    const std::string manifest_path = (dir / SNAPSHOT_MANIFEST_FILENAME).string();
+    snapshot_manifest manifest;
+    if (!epee::serialization::load_t_from_json_file(manifest, manifest_path))
+    {
+      MERROR("Failed to load snapshot manifest from " << manifest_path);
+      return false;
+    }
+    if (manifest.version != SNAPSHOT_MANIFEST_VERSION)
+    {
+      MERROR("Unsupported snapshot manifest version " << manifest.version);
+      return false;
+    }
+
+    try
+    {
+      std::unique_ptr<BlockchainDB> db = open_snapshot_db(manifest.db_type, snapshot_dir);
+      if (!db)
+        return false;
+
+      if (db->height() != manifest.height || epee::string_tools::pod_to_hex(db->top_block_hash()) != manifest.top_block_hash)
+      {
+        MERROR("Snapshot top block does not match its manifest");
+        return false;
+      }
+
+      MINFO("Hashing snapshot tables");
+      const std::vector<snapshot_table_hash> tables = get_table_hashes(*db);
+      if (tables.size() != manifest.tables.size())
+      {
+        MERROR("Snapshot has " << tables.size() << " tables, manifest lists " << manifest.tables.size());
+        return false;
+      }
+      for (size_t i = 0; i < tables.size(); ++i)
+      {
+        if (tables[i].name != manifest.tables[i].name || tables[i].hash != manifest.tables[i].hash)
+        {
+          MERROR("Snapshot table " << tables[i].name << " does not match its manifest");
+          return false;
+        }
+      }
+
+      // the table hashes only show the copy is intact: trust comes from the checkpoints
+      bool covered = false;
+      for (const auto &point: points.get_points())
+      {
+        if (point.first >= db->height())
+          break;
+        if (db->get_block_hash_from_height(point.first) != point.second)
+        {
+          MERROR("Snapshot block " << point.first << " does not match checkpoint " << point.second);
+          return false;
+        }
+        trusted_height = point.first;
+        covered = true;
+      }
+      db->close();
+
+      if (!covered)
+      {
+        MERROR("Snapshot is not covered by any checkpoint");
+        return false;
+      }
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Failed to verify snapshot: " << e.what());
+      return false;
+    }
+
+    MINFO("Snapshot of " << manifest.height << " blocks verified up to checkpoint " << trusted_height);
+    return true;
+  }
+
+  bool install_snapshot(const std::string& snapshot_dir, const std::string& db_dir, const checkpoints& points, uint64_t& trusted_height)
+  {
+    const boost::filesystem::path target(db_dir);
+    if (boost::filesystem::exists(target / CRYPTONOTE_BLOCKCHAINDATA_FILENAME))
+    {
+      MERROR("A database already exists in " << db_dir << ", not loading snapshot");
+      return false;
+    }
+
+    if (!verify_snapshot(snapshot_dir, points, trusted_height))
+      return false;
+
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(target) && !boost::filesystem::create_directories(target, ec))
+    {
+      MERROR("Failed to create directory " << db_dir << ": " << ec.message());
+      return false;
+    }
+    boost::filesystem::copy_file(boost::filesystem::path(snapshot_dir) / CRYPTONOTE_BLOCKCHAINDATA_FILENAME, target / CRYPTONOTE_BLOCKCHAINDATA_FILENAME, ec);
+    if (ec)
+    {
+      MERROR("Failed to copy snapshot database to " << db_dir << ": " << ec.message());
+      return false;
+    }
+    MINFO("Snapshot installed to " << db_dir);
+    return true;
+  }
+}
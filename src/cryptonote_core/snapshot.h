@@ -0,0 +1,116 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "serialization/keyvalue_serialization.h"
+#include "blockchain_db/blockchain_db.h"
+#include "checkpoints/checkpoints.h"
+
+#define SNAPSHOT_MANIFEST_FILENAME "manifest.json"
+#define SNAPSHOT_MANIFEST_VERSION 1
+
+namespace cryptonote
+{
+  /**
+   * @brief the hash of the contents of one database table
+   */
+  struct snapshot_table_hash
+  {
+    std::string name;
+    std::string hash;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(name)
+      KV_SERIALIZE(hash)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  /**
+   * @brief describes a database snapshot, stored next to the database copy
+   */
+  struct snapshot_manifest
+  {
+    uint32_t version;
+    std::string db_type;
+    uint64_t height;             //!< number of blocks in the snapshot
+    std::string top_block_hash;
+    std::vector<snapshot_table_hash> tables;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(version)
+      KV_SERIALIZE(db_type)
+      KV_SERIALIZE(height)
+      KV_SERIALIZE(top_block_hash)
+      KV_SERIALIZE(tables)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  /**
+   * @brief writes a compacted copy of the database and its manifest to a directory
+   *
+   * The manifest is computed from the copy rather than the source, so the
+   * source may keep changing while the snapshot is taken.
+   *
+   * @param db the database to snapshot
+   * @param snapshot_dir the directory to write to, must not contain a snapshot already
+   *
+   * @return true on success
+   */
+  bool create_snapshot(const BlockchainDB& db, const std::string& snapshot_dir);
+
+  /**
+   * @brief checks a snapshot against its manifest and a set of checkpoints
+   *
+   * The table hashes and top block in the manifest must match the database
+   * copy, and the copy must agree with every checkpoint at or below its top
+   * block. Blocks above the highest such checkpoint are not attested.
+   *
+   * @param snapshot_dir the snapshot directory
+   * @param points the checkpoints to check against
+   * @param trusted_height return-by-reference the highest checkpoint height covered
+   *
+   * @return true if the snapshot is intact and covered by at least one checkpoint
+   */
+  bool verify_snapshot(const std::string& snapshot_dir, const checkpoints& points, uint64_t& trusted_height);
+
+  /**
+   * @brief verifies a snapshot and copies its database into place
+   *
+   * @param snapshot_dir the snapshot directory
+   * @param db_dir the database directory to install to, must not contain a database yet
+   * @param points the checkpoints to check against
+   * @param trusted_height return-by-reference the highest checkpoint height covered
+   *
+   * @return true on success
+   */
+  bool install_snapshot(const std::string& snapshot_dir, const std::string& db_dir, const checkpoints& points, uint64_t& trusted_height);
+}
@@ -45,6 +45,7 @@
 #include "misc_language.h"
 #include "warnings.h"
 #include "common/perf_timer.h"
+#include "common/threadpool.h"
 #include "crypto/hash.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -92,7 +93,7 @@ namespace cryptonote
 
     // This class is meant to create a batch when none currently exists.
     // If a batch exists, it can't be from another thread, since we can
-    // only be called with the txpool lock taken, and it is held during
+    // only be called with the blockchain lock taken, and it is held during
     // the whole prepare/handle/cleanup incoming block sequence.
     class LockedTXN {
     public:
@@ -107,7 +108,7 @@ namespace cryptonote
   }
   //---------------------------------------------------------------------------------
   //---------------------------------------------------------------------------------
-  tx_memory_pool::tx_memory_pool(Blockchain& bchs): m_blockchain(bchs), m_txpool_max_weight(DEFAULT_TXPOOL_MAX_WEIGHT), m_txpool_weight(0), m_cookie(0)
+  tx_memory_pool::tx_memory_pool(Blockchain& bchs): m_blockchain(bchs), m_txpool_max_weight(DEFAULT_TXPOOL_MAX_WEIGHT), m_txpool_weight(0), m_cookie(0), m_ready_top_id(crypto::null_hash), m_ready_version(0), m_revalidation_pending(false), m_revalidation_total(0), m_revalidation_checked(0)
   {
 
   }
@@ -269,20 +270,15 @@ namespace cryptonote
         meta.double_spend_seen = have_tx_keyimges_as_spent(tx);
         meta.bf_padding = 0;
         memset(meta.padding, 0, sizeof(meta.padding));
-        try
+        if (m_pool_txs.find(id) != m_pool_txs.end())
         {
-          CRITICAL_REGION_LOCAL1(m_blockchain);
-          LockedTXN lock(m_blockchain);
-          m_blockchain.add_txpool_tx(tx, meta);
-          if (!insert_key_images(tx, kept_by_block))
-            return false;
-          m_txs_by_fee_and_receive_time.emplace(std::pair<double, std::time_t>(fee / (double)tx_weight, receive_time), id);
-        }
-        catch (const std::exception &e)
-        {
-          MERROR("transaction already exists at inserting in memory pool: " << e.what());
+          MERROR("transaction already exists at inserting in memory pool: " << id);
           return false;
         }
+        put_pool_tx(id, tx, meta);
+        if (!insert_key_images(tx, kept_by_block))
+          return false;
+        m_txs_by_fee_and_receive_time.emplace(std::pair<double, std::time_t>(fee / (double)tx_weight, receive_time), id);
         tvc.m_verifivation_impossible = true;
         tvc.m_added_to_pool = true;
       }else
@@ -310,22 +306,20 @@ namespace cryptonote
       meta.bf_padding = 0;
       memset(meta.padding, 0, sizeof(meta.padding));
 
-      try
+      put_pool_tx(id, tx, meta);
+      if (!insert_key_images(tx, kept_by_block))
+        return false;
+      m_txs_by_fee_and_receive_time.emplace(std::pair<double, std::time_t>(fee / (double)tx_weight, receive_time), id);
+      tvc.m_added_to_pool = true;
+
+      // the inputs check above is cached, so finding out now whether it can
+      // go in the next block is cheap, and spares the next block template
+      if (meta.fee > 0)
       {
         CRITICAL_REGION_LOCAL1(m_blockchain);
-        LockedTXN lock(m_blockchain);
-        m_blockchain.remove_txpool_tx(get_transaction_hash(tx));
-        m_blockchain.add_txpool_tx(tx, meta);
-        if (!insert_key_images(tx, kept_by_block))
-          return false;
-        m_txs_by_fee_and_receive_time.emplace(std::pair<double, std::time_t>(fee / (double)tx_weight, receive_time), id);
+        sync_ready_txs(version);
+        is_transaction_ready_cached(id, m_pool_txs[id]);
       }
-      catch (const std::exception &e)
-      {
-        MERROR("internal error: transaction already exists at inserting in memory pool: " << e.what());
-        return false;
-      }
-      tvc.m_added_to_pool = true;
 
       if(meta.fee > 0 && !do_not_relay)
         tvc.m_should_be_relayed = true;
@@ -369,8 +363,6 @@ namespace cryptonote
     CRITICAL_REGION_LOCAL(m_transactions_lock);
     if (bytes == 0)
       bytes = m_txpool_max_weight;
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    LockedTXN lock(m_blockchain);
     bool changed = false;
 
     // this will never remove the first one, but we don't care
@@ -379,42 +371,26 @@ namespace cryptonote
     {
       if (m_txpool_weight <= bytes)
         break;
-      try
+      const crypto::hash txid = it->second;
+      const auto i = m_pool_txs.find(txid);
+      if (i == m_pool_txs.end())
       {
-        const crypto::hash &txid = it->second;
-        txpool_tx_meta_t meta;
-        if (!m_blockchain.get_txpool_tx_meta(txid, meta))
-        {
-          MERROR("Failed to find tx in txpool");
-          return;
-        }
-        // don't prune the kept_by_block ones, they're likely added because we're adding a block with those
-        if (meta.kept_by_block)
-        {
-          --it;
-          continue;
-        }
-        cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(txid);
-        cryptonote::transaction tx;
-        if (!parse_and_validate_tx_from_blob(txblob, tx))
-        {
-          MERROR("Failed to parse tx from txpool");
-          return;
-        }
-        // remove first, in case this throws, so key images aren't removed
-        MINFO("Pruning tx " << txid << " from txpool: weight: " << it->first.second << ", fee/byte: " << it->first.first);
-        m_blockchain.remove_txpool_tx(txid);
-        m_txpool_weight -= it->first.second;
-        remove_transaction_keyimages(tx);
-        MINFO("Pruned tx " << txid << " from txpool: weight: " << it->first.second << ", fee/byte: " << it->first.first);
-        m_txs_by_fee_and_receive_time.erase(it--);
-        changed = true;
+        MERROR("Failed to find tx in txpool");
+        return;
       }
-      catch (const std::exception &e)
+      // don't prune the kept_by_block ones, they're likely added because we're adding a block with those
+      if (i->second.meta.kept_by_block)
       {
-        MERROR("Error while pruning txpool: " << e.what());
-        return;
+        --it;
+        continue;
       }
+      MINFO("Pruning tx " << txid << " from txpool: weight: " << it->first.second << ", fee/byte: " << it->first.first);
+      m_txpool_weight -= i->second.meta.weight;
+      remove_transaction_keyimages(i->second.tx);
+      remove_pool_tx(txid);
+      MINFO("Pruned tx " << txid << " from txpool: weight: " << it->first.second << ", fee/byte: " << it->first.first);
+      m_txs_by_fee_and_receive_time.erase(it--);
+      changed = true;
     }
     if (changed)
       ++m_cookie;
@@ -445,7 +421,6 @@ namespace cryptonote
   bool tx_memory_pool::remove_transaction_keyimages(const transaction& tx)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     // ND: Speedup
     // 1. Move transaction hash calcuation outside of loop. ._.
     crypto::hash actual_hash = get_transaction_hash(tx);
@@ -477,43 +452,28 @@ namespace cryptonote
   bool tx_memory_pool::take_tx(const crypto::hash &id, transaction &tx, size_t& tx_weight, uint64_t& fee, bool &relayed, bool &do_not_relay, bool &double_spend_seen)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
 
     auto sorted_it = find_tx_in_sorted_container(id);
     if (sorted_it == m_txs_by_fee_and_receive_time.end())
       return false;
 
-    try
+    const auto i = m_pool_txs.find(id);
+    if (i == m_pool_txs.end())
     {
-      LockedTXN lock(m_blockchain);
-      txpool_tx_meta_t meta;
-      if (!m_blockchain.get_txpool_tx_meta(id, meta))
-      {
-        MERROR("Failed to find tx in txpool");
-        return false;
-      }
-      cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(id);
-      if (!parse_and_validate_tx_from_blob(txblob, tx))
-      {
-        MERROR("Failed to parse tx from txpool");
-        return false;
-      }
-      tx_weight = meta.weight;
-      fee = meta.fee;
-      relayed = meta.relayed;
-      do_not_relay = meta.do_not_relay;
-      double_spend_seen = meta.double_spend_seen;
-
-      // remove first, in case this throws, so key images aren't removed
-      m_blockchain.remove_txpool_tx(id);
-      m_txpool_weight -= tx_weight;
-      remove_transaction_keyimages(tx);
-    }
-    catch (const std::exception &e)
-    {
-      MERROR("Failed to remove tx from txpool: " << e.what());
+      MERROR("Failed to find tx in txpool");
       return false;
     }
+    const txpool_tx_meta_t &meta = i->second.meta;
+    tx = i->second.tx;
+    tx_weight = meta.weight;
+    fee = meta.fee;
+    relayed = meta.relayed;
+    do_not_relay = meta.do_not_relay;
+    double_spend_seen = meta.double_spend_seen;
+
+    m_txpool_weight -= tx_weight;
+    remove_transaction_keyimages(tx);
+    remove_pool_tx(id);
 
     m_txs_by_fee_and_receive_time.erase(sorted_it);
     ++m_cookie;
@@ -523,6 +483,10 @@ namespace cryptonote
   void tx_memory_pool::on_idle()
   {
     m_remove_stuck_tx_interval.do_call([this](){return remove_stuck_transactions();});
+    if (m_revalidation_pending && !m_blockchain.get_db().is_read_only())
+      validate(m_blockchain.get_current_hard_fork_version());
+    m_refresh_ready_interval.do_call([this](){ refresh_ready_txs(); return true; });
+    m_flush_interval.do_call([this](){return flush();});
   }
   //---------------------------------------------------------------------------------
   sorted_tx_container::iterator tx_memory_pool::find_tx_in_sorted_container(const crypto::hash& id) const
@@ -538,9 +502,9 @@ namespace cryptonote
   bool tx_memory_pool::remove_stuck_transactions()
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     std::unordered_set<crypto::hash> remove;
-    m_blockchain.for_all_txpool_txes([this, &remove](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata*) {
+    for_all_pool_txes([this, &remove](const crypto::hash &txid, const pool_tx_entry &e) {
+      const txpool_tx_meta_t &meta = e.meta;
       uint64_t tx_age = time(nullptr) - meta.receive_time;
 
       if((tx_age > CRYPTONOTE_MEMPOOL_TX_LIVETIME && !meta.kept_by_block) ||
@@ -561,35 +525,16 @@ namespace cryptonote
         remove.insert(txid);
       }
       return true;
-    }, false);
+    });
 
     if (!remove.empty())
     {
-      LockedTXN lock(m_blockchain);
       for (const crypto::hash &txid: remove)
       {
-        try
-        {
-          cryptonote::blobdata bd = m_blockchain.get_txpool_tx_blob(txid);
-          cryptonote::transaction tx;
-          if (!parse_and_validate_tx_from_blob(bd, tx))
-          {
-            MERROR("Failed to parse tx from txpool");
-            // continue
-          }
-          else
-          {
-            // remove first, so we only remove key images if the tx removal succeeds
-            m_blockchain.remove_txpool_tx(txid);
-            m_txpool_weight -= get_transaction_weight(tx, bd.size());
-            remove_transaction_keyimages(tx);
-          }
-        }
-        catch (const std::exception &e)
-        {
-          MWARNING("Failed to remove stuck transaction: " << txid);
-          // ignore error
-        }
+        const auto i = m_pool_txs.find(txid);
+        m_txpool_weight -= i->second.meta.weight;
+        remove_transaction_keyimages(i->second.tx);
+        remove_pool_tx(txid);
       }
       ++m_cookie;
     }
@@ -600,10 +545,10 @@ namespace cryptonote
   bool tx_memory_pool::get_relayable_transactions(std::vector<std::pair<crypto::hash, cryptonote::blobdata>> &txs) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     const uint64_t now = time(NULL);
-    txs.reserve(m_blockchain.get_txpool_tx_count());
-    m_blockchain.for_all_txpool_txes([this, now, &txs](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *){
+    txs.reserve(get_pool_tx_count());
+    for_all_pool_txes([now, &txs](const crypto::hash &txid, const pool_tx_entry &e){
+      const txpool_tx_meta_t &meta = e.meta;
       // 0 fee transactions are never relayed
       if(meta.fee > 0 && !meta.do_not_relay && now - meta.last_relayed_time > get_relay_delay(now, meta.receive_time))
       {
@@ -612,46 +557,26 @@ namespace cryptonote
         // flushed txes to be re-added when received from a node which was just about to flush it
         uint64_t max_age = meta.kept_by_block ? CRYPTONOTE_MEMPOOL_TX_FROM_ALT_BLOCK_LIVETIME : CRYPTONOTE_MEMPOOL_TX_LIVETIME;
         if (now - meta.receive_time <= max_age / 2)
-        {
-          try
-          {
-            cryptonote::blobdata bd = m_blockchain.get_txpool_tx_blob(txid);
-            txs.push_back(std::make_pair(txid, bd));
-          }
-          catch (const std::exception &e)
-          {
-            MERROR("Failed to get transaction blob from db");
-            // ignore error
-          }
-        }
+          txs.push_back(std::make_pair(txid, e.blob));
       }
       return true;
-    }, false);
+    });
     return true;
   }
   //---------------------------------------------------------------------------------
   void tx_memory_pool::set_relayed(const std::vector<std::pair<crypto::hash, cryptonote::blobdata>> &txs)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     const time_t now = time(NULL);
-    LockedTXN lock(m_blockchain);
     for (auto it = txs.begin(); it != txs.end(); ++it)
     {
-      try
-      {
-        txpool_tx_meta_t meta;
-        if (m_blockchain.get_txpool_tx_meta(it->first, meta))
-        {
-          meta.relayed = true;
-          meta.last_relayed_time = now;
-          m_blockchain.update_txpool_tx(it->first, meta);
-        }
-      }
-      catch (const std::exception &e)
+      const auto i = m_pool_txs.find(it->first);
+      if (i != m_pool_txs.end())
       {
-        MERROR("Failed to update txpool transaction metadata: " << e.what());
-        // continue
+        txpool_tx_meta_t meta = i->second.meta;
+        meta.relayed = true;
+        meta.last_relayed_time = now;
+        update_pool_tx(it->first, meta);
       }
     }
   }
@@ -659,61 +584,74 @@ namespace cryptonote
   size_t tx_memory_pool::get_transactions_count(bool include_unrelayed_txes) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    return m_blockchain.get_txpool_tx_count(include_unrelayed_txes);
+    return get_pool_tx_count(include_unrelayed_txes);
   }
   //---------------------------------------------------------------------------------
   void tx_memory_pool::get_transactions(std::vector<transaction>& txs, bool include_unrelayed_txes) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    txs.reserve(m_blockchain.get_txpool_tx_count(include_unrelayed_txes));
-    m_blockchain.for_all_txpool_txes([&txs](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
-      transaction tx;
-      if (!parse_and_validate_tx_from_blob(*bd, tx))
-      {
-        MERROR("Failed to parse tx from txpool");
-        // continue
-        return true;
-      }
-      txs.push_back(tx);
+    txs.reserve(get_pool_tx_count(include_unrelayed_txes));
+    for_all_pool_txes([&txs](const crypto::hash &txid, const pool_tx_entry &e){
+      txs.push_back(e.tx);
       return true;
-    }, true, include_unrelayed_txes);
+    }, include_unrelayed_txes);
   }
   //------------------------------------------------------------------
   void tx_memory_pool::get_transaction_hashes(std::vector<crypto::hash>& txs, bool include_unrelayed_txes) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    txs.reserve(m_blockchain.get_txpool_tx_count(include_unrelayed_txes));
-    m_blockchain.for_all_txpool_txes([&txs](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
+    txs.reserve(get_pool_tx_count(include_unrelayed_txes));
+    for_all_pool_txes([&txs](const crypto::hash &txid, const pool_tx_entry &e){
       txs.push_back(txid);
       return true;
-    }, false, include_unrelayed_txes);
+    }, include_unrelayed_txes);
   }
   //------------------------------------------------------------------
   void tx_memory_pool::get_transaction_backlog(std::vector<tx_backlog_entry>& backlog, bool include_unrelayed_txes) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     const uint64_t now = time(NULL);
-    backlog.reserve(m_blockchain.get_txpool_tx_count(include_unrelayed_txes));
-    m_blockchain.for_all_txpool_txes([&backlog, now](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
-      backlog.push_back({meta.weight, meta.fee, meta.receive_time - now});
+    backlog.reserve(get_pool_tx_count(include_unrelayed_txes));
+    for_all_pool_txes([&backlog, now](const crypto::hash &txid, const pool_tx_entry &e){
+      backlog.push_back({e.meta.weight, e.meta.fee, e.meta.receive_time - now});
       return true;
-    }, false, include_unrelayed_txes);
+    }, include_unrelayed_txes);
+  }
+  //------------------------------------------------------------------
+  void tx_memory_pool::get_fee_rate_ladder(uint64_t block_weight, uint64_t n_blocks, std::vector<fee_rate_step> &ladder, std::vector<fee_rate_percentile> &percentiles, uint64_t &txs_total, uint64_t &weight_total) const
+  {
+    static const uint32_t ladder_percentiles[] = {10, 25, 50, 75, 90};
+
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    txs_total = m_fee_rate_index.size();
+    weight_total = m_fee_rate_index.total_weight();
+
+    ladder.clear();
+    ladder.reserve(n_blocks);
+    for (uint64_t blocks = 1; blocks <= n_blocks; ++blocks)
+    {
+      // to be mined within that many blocks, pay more than the transaction at the boundary
+      const double fee_rate = m_fee_rate_index.get_fee_rate_at_weight(block_weight * blocks);
+      ladder.push_back({blocks, fee_rate > 0.0 ? (uint64_t)fee_rate + 1 : 0});
+      if (fee_rate == 0.0)
+        break;
+    }
+
+    percentiles.clear();
+    for (uint32_t percentile: ladder_percentiles)
+      percentiles.push_back({percentile, (uint64_t)(m_fee_rate_index.get_percentile(percentile) + 0.5)});
   }
   //------------------------------------------------------------------
   void tx_memory_pool::get_transaction_stats(struct txpool_stats& stats, bool include_unrelayed_txes) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     const uint64_t now = time(NULL);
     std::map<uint64_t, txpool_histo> agebytes;
-    stats.txs_total = m_blockchain.get_txpool_tx_count(include_unrelayed_txes);
+    stats.txs_total = get_pool_tx_count(include_unrelayed_txes);
     std::vector<uint32_t> weights;
     weights.reserve(stats.txs_total);
-    m_blockchain.for_all_txpool_txes([&stats, &weights, now, &agebytes](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
+    for_all_pool_txes([&stats, &weights, now, &agebytes](const crypto::hash &txid, const pool_tx_entry &e){
+      const txpool_tx_meta_t &meta = e.meta;
       weights.push_back(meta.weight);
       stats.bytes_total += meta.weight;
       if (!stats.bytes_min || meta.weight < stats.bytes_min)
@@ -735,8 +673,10 @@ namespace cryptonote
       if (meta.double_spend_seen)
         ++stats.num_double_spends;
       return true;
-      }, false, include_unrelayed_txes);
+      }, include_unrelayed_txes);
     stats.bytes_med = epee::misc_utils::median(weights);
+    stats.revalidation_total = m_revalidation_total;
+    stats.revalidation_checked = m_revalidation_checked;
     if (stats.txs_total > 1)
     {
       /* looking for 98th percentile */
@@ -785,22 +725,16 @@ namespace cryptonote
   bool tx_memory_pool::get_transactions_and_spent_keys_info(std::vector<tx_info>& tx_infos, std::vector<spent_key_image_info>& key_image_infos, bool include_sensitive_data) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    tx_infos.reserve(m_blockchain.get_txpool_tx_count());
-    key_image_infos.reserve(m_blockchain.get_txpool_tx_count());
-    m_blockchain.for_all_txpool_txes([&tx_infos, key_image_infos, include_sensitive_data](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
+    tx_infos.reserve(get_pool_tx_count());
+    key_image_infos.reserve(get_pool_tx_count());
+    for_all_pool_txes([&tx_infos, key_image_infos, include_sensitive_data](const crypto::hash &txid, const pool_tx_entry &e){
+      const txpool_tx_meta_t &meta = e.meta;
       tx_info txi;
       txi.id_hash = epee::string_tools::pod_to_hex(txid);
-      txi.tx_blob = *bd;
-      transaction tx;
-      if (!parse_and_validate_tx_from_blob(*bd, tx))
-      {
-        MERROR("Failed to parse tx from txpool");
-        // continue
-        return true;
-      }
+      txi.tx_blob = e.blob;
+      transaction tx = e.tx;
       txi.tx_json = obj_to_json_str(tx);
-      txi.blob_size = bd->size();
+      txi.blob_size = e.blob.size();
       txi.weight = meta.weight;
       txi.fee = meta.fee;
       txi.kept_by_block = meta.kept_by_block;
@@ -817,9 +751,8 @@ namespace cryptonote
       txi.double_spend_seen = meta.double_spend_seen;
       tx_infos.push_back(txi);
       return true;
-    }, true, include_sensitive_data);
+    }, include_sensitive_data);
 
-    txpool_tx_meta_t meta;
     for (const key_images_container::value_type& kee : m_spent_key_images) {
       const crypto::key_image& k_image = kee.first;
       const std::unordered_set<crypto::hash>& kei_image_set = kee.second;
@@ -829,22 +762,15 @@ namespace cryptonote
       {
         if (!include_sensitive_data)
         {
-          try
+          const auto i = m_pool_txs.find(tx_id_hash);
+          if (i == m_pool_txs.end())
           {
-            if (!m_blockchain.get_txpool_tx_meta(tx_id_hash, meta))
-            {
-              MERROR("Failed to get tx meta from txpool");
-              return false;
-            }
-            if (!meta.relayed)
-              // Do not include that transaction if in restricted mode and it's not relayed
-              continue;
-          }
-          catch (const std::exception &e)
-          {
-            MERROR("Failed to get tx meta from txpool: " << e.what());
+            MERROR("Failed to get tx meta from txpool");
             return false;
           }
+          if (!i->second.meta.relayed)
+            // Do not include that transaction if in restricted mode and it's not relayed
+            continue;
         }
         ki.txs_hashes.push_back(epee::string_tools::pod_to_hex(tx_id_hash));
       }
@@ -858,21 +784,14 @@ namespace cryptonote
   bool tx_memory_pool::get_pool_for_rpc(std::vector<cryptonote::rpc::tx_in_pool>& tx_infos, cryptonote::rpc::key_images_with_tx_hashes& key_image_infos) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    tx_infos.reserve(m_blockchain.get_txpool_tx_count());
-    key_image_infos.reserve(m_blockchain.get_txpool_tx_count());
-    m_blockchain.for_all_txpool_txes([&tx_infos, key_image_infos](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
+    tx_infos.reserve(get_pool_tx_count());
+    key_image_infos.reserve(get_pool_tx_count());
+    for_all_pool_txes([&tx_infos, key_image_infos](const crypto::hash &txid, const pool_tx_entry &e){
+      const txpool_tx_meta_t &meta = e.meta;
       cryptonote::rpc::tx_in_pool txi;
       txi.tx_hash = txid;
-      transaction tx;
-      if (!parse_and_validate_tx_from_blob(*bd, tx))
-      {
-        MERROR("Failed to parse tx from txpool");
-        // continue
-        return true;
-      }
-      txi.tx = tx;
-      txi.blob_size = bd->size();
+      txi.tx = e.tx;
+      txi.blob_size = e.blob.size();
       txi.weight = meta.weight;
       txi.fee = meta.fee;
       txi.kept_by_block = meta.kept_by_block;
@@ -887,7 +806,7 @@ namespace cryptonote
       txi.double_spend_seen = meta.double_spend_seen;
       tx_infos.push_back(txi);
       return true;
-    }, true, false);
+    }, false);
 
     for (const key_images_container::value_type& kee : m_spent_key_images) {
       std::vector<crypto::hash> tx_hashes;
@@ -921,36 +840,52 @@ namespace cryptonote
   bool tx_memory_pool::get_transaction(const crypto::hash& id, cryptonote::blobdata& txblob) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    try
-    {
-      return m_blockchain.get_txpool_tx_blob(id, txblob);
-    }
-    catch (const std::exception &e)
-    {
+    const auto i = m_pool_txs.find(id);
+    if (i == m_pool_txs.end())
       return false;
-    }
+    txblob = i->second.blob;
+    return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const crypto::hash& top_block_id)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
     m_input_cache.clear();
+
+    // anything which was not ready may have become ready, and is checked again
+    for (auto it = m_ready_txs.begin(); it != m_ready_txs.end(); )
+    {
+      const auto i = m_pool_txs.find(it->first);
+      if (!it->second || i == m_pool_txs.end() || !stays_ready_on_new_block(i->second.tx, m_blockchain.have_tx_keyimges_as_spent(i->second.tx)))
+        it = m_ready_txs.erase(it);
+      else
+        ++it;
+    }
+    m_ready_top_id = top_block_id;
     return true;
   }
   //---------------------------------------------------------------------------------
+  bool tx_memory_pool::stays_ready_on_new_block(const transaction &tx, bool key_images_spent)
+  {
+    return !key_images_spent && !tx.is_token_genesis();
+  }
+  //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const crypto::hash& top_block_id)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
     m_input_cache.clear();
+    // outputs used by pool transactions may be gone
+    m_ready_txs.clear();
+    // and transactions returned from the old chain may conflict with the new one
+    m_revalidation_pending = true;
+    m_ready_top_id = top_block_id;
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::have_tx(const crypto::hash &id) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    return m_blockchain.get_db().txpool_has_tx(id);
+    return m_pool_txs.find(id) != m_pool_txs.end();
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::have_tx_keyimges_as_spent(const transaction& tx) const
@@ -1001,25 +936,26 @@ namespace cryptonote
     return ret;
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const cryptonote::blobdata &txblob, transaction &tx) const
+  bool tx_memory_pool::is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const transaction &tx) const
   {
-    struct transction_parser
+    // input checks may expand the transaction, so they get a copy, made only if
+    // the result is not cached already
+    struct transaction_copier
     {
-      transction_parser(const cryptonote::blobdata &txblob, transaction &tx): txblob(txblob), tx(tx), parsed(false) {}
+      transaction_copier(const transaction &tx): tx(tx), copied(false) {}
       cryptonote::transaction &operator()()
       {
-        if (!parsed)
+        if (!copied)
         {
-          if (!parse_and_validate_tx_from_blob(txblob, tx))
-            throw std::runtime_error("failed to parse transaction blob");
-          parsed = true;
+          copy = tx;
+          copied = true;
         }
-        return tx;
+        return copy;
       }
-      const cryptonote::blobdata &txblob;
-      transaction &tx;
-      bool parsed;
-    } lazy_tx(txblob, tx);
+      const transaction &tx;
+      transaction copy;
+      bool copied;
+    } lazy_tx(tx);
 
     //not the best implementation at this time, sorry :(
     //check is ring_signature already checked ?
@@ -1064,7 +1000,7 @@ namespace cryptonote
       }
     }
     //if we here, transaction seems valid, but, anyway, check for key_images collisions with blockchain, just to be sure
-    if(m_blockchain.have_tx_keyimges_as_spent(lazy_tx()))
+    if(m_blockchain.have_tx_keyimges_as_spent(tx))
     {
       txd.double_spend_seen = true;
       return false;
@@ -1074,6 +1010,53 @@ namespace cryptonote
     return true;
   }
   //---------------------------------------------------------------------------------
+  bool tx_memory_pool::is_transaction_ready_cached(const crypto::hash &txid, const pool_tx_entry &entry)
+  {
+    const auto i = m_ready_txs.find(txid);
+    if (i != m_ready_txs.end())
+      return i->second;
+
+    txpool_tx_meta_t meta = entry.meta;
+    bool ready = false;
+    try
+    {
+      ready = is_transaction_ready_to_go(meta, txid, entry.tx);
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Failed to check transaction readiness: " << e.what());
+      // continue, not fatal
+    }
+    if (memcmp(&entry.meta, &meta, sizeof(meta)))
+      update_pool_tx(txid, meta);
+    m_ready_txs[txid] = ready;
+    return ready;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::sync_ready_txs(uint8_t version)
+  {
+    const crypto::hash top_id = m_blockchain.get_tail_id();
+    if (top_id != m_ready_top_id || version != m_ready_version)
+    {
+      m_ready_txs.clear();
+      m_ready_top_id = top_id;
+      m_ready_version = version;
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::refresh_ready_txs()
+  {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    CRITICAL_REGION_LOCAL1(m_blockchain);
+    sync_ready_txs(m_blockchain.get_current_hard_fork_version());
+    for (const auto &e: m_pool_txs)
+    {
+      // zero fee transactions never go in a template
+      if (e.second.meta.fee)
+        is_transaction_ready_cached(e.first, e.second);
+    }
+  }
+  //---------------------------------------------------------------------------------
   bool tx_memory_pool::have_key_images(const std::unordered_set<crypto::key_image>& k_images, const transaction& tx)
   {
     for(size_t i = 0; i!= tx.vin.size(); i++)
@@ -1099,9 +1082,7 @@ namespace cryptonote
   void tx_memory_pool::mark_double_spend(const transaction &tx)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     bool changed = false;
-    LockedTXN lock(m_blockchain);
     for(size_t i = 0; i!= tx.vin.size(); i++)
     {
       CHECKED_GET_SPECIFIC_VARIANT(tx.vin[i], const txin_to_key, itk, void());
@@ -1110,27 +1091,20 @@ namespace cryptonote
       {
         for (const crypto::hash &txid: it->second)
         {
-          txpool_tx_meta_t meta;
-          if (!m_blockchain.get_txpool_tx_meta(txid, meta))
+          const auto i = m_pool_txs.find(txid);
+          if (i == m_pool_txs.end())
           {
             MERROR("Failed to find tx meta in txpool");
             // continue, not fatal
             continue;
           }
-          if (!meta.double_spend_seen)
+          if (!i->second.meta.double_spend_seen)
           {
             MDEBUG("Marking " << txid << " as double spending " << itk.k_image);
+            txpool_tx_meta_t meta = i->second.meta;
             meta.double_spend_seen = true;
             changed = true;
-            try
-            {
-              m_blockchain.update_txpool_tx(txid, meta);
-            }
-            catch (const std::exception &e)
-            {
-              MERROR("Failed to update tx meta: " << e.what());
-              // continue, not fatal
-            }
+            update_pool_tx(txid, meta);
           }
         }
       }
@@ -1143,19 +1117,14 @@ namespace cryptonote
   {
     std::stringstream ss;
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    m_blockchain.for_all_txpool_txes([&ss, short_format](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *txblob) {
+    for_all_pool_txes([&ss, short_format](const crypto::hash &txid, const pool_tx_entry &e) {
+      const txpool_tx_meta_t &meta = e.meta;
       ss << "id: " << txid << std::endl;
       if (!short_format) {
-        cryptonote::transaction tx;
-        if (!parse_and_validate_tx_from_blob(*txblob, tx))
-        {
-          MERROR("Failed to parse tx from txpool");
-          return true; // continue
-        }
+        cryptonote::transaction tx = e.tx;
         ss << obj_to_json_str(tx) << std::endl;
       }
-      ss << "blob_size: " << (short_format ? "-" : std::to_string(txblob->size())) << std::endl
+      ss << "blob_size: " << (short_format ? "-" : std::to_string(e.blob.size())) << std::endl
         << "weight: " << meta.weight << std::endl
         << "fee: " << print_money(meta.fee) << std::endl
         << "kept_by_block: " << (meta.kept_by_block ? 'T' : 'F') << std::endl
@@ -1165,7 +1134,7 @@ namespace cryptonote
         << "last_failed_height: " << meta.last_failed_height << std::endl
         << "last_failed_id: " << meta.last_failed_id << std::endl;
       return true;
-    }, !short_format);
+    });
 
     return ss.str();
   }
@@ -1173,20 +1142,12 @@ namespace cryptonote
   bool tx_memory_pool::token_genesis_in_mempool(TokenId token_id) const
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    bool not_in_mempool = m_blockchain.for_all_txpool_txes([token_id](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd){
-      transaction tx;
-      if (!parse_and_validate_tx_from_blob(*bd, tx))
-      {
-        MERROR("Failed to parse tx from txpool");
-        // break
-        return false;
-      }
+    bool not_in_mempool = for_all_pool_txes([token_id](const crypto::hash &txid, const pool_tx_entry &e){
       tx_extra_token_data token_data;
-      get_token_data(tx, token_data);
+      get_token_data(e.tx, token_data);
       if (token_data.d_id == token_id) return false;
       return true;
-    }, true, true);
+    });
     return !not_in_mempool;
   }
   //---------------------------------------------------------------------------------
@@ -1210,16 +1171,17 @@ namespace cryptonote
 
     LOG_PRINT_L2("Filling block template, median weight " << median_weight << ", " << m_txs_by_fee_and_receive_time.size() << " txes in the pool");
 
-    LockedTXN lock(m_blockchain);
+    sync_ready_txs(version);
 
     for (auto sorted_it = m_txs_by_fee_and_receive_time.begin(); sorted_it != m_txs_by_fee_and_receive_time.end(); ++sorted_it)
     {
-      txpool_tx_meta_t meta;
-      if (!m_blockchain.get_txpool_tx_meta(sorted_it->second, meta))
+      const auto i = m_pool_txs.find(sorted_it->second);
+      if (i == m_pool_txs.end())
       {
         MERROR("  failed to find tx meta");
         continue;
       }
+      txpool_tx_meta_t meta = i->second.meta;
       LOG_PRINT_L2("Considering " << sorted_it->second << ", weight " << meta.weight << ", current block weight " << total_weight << "/" << max_total_weight << ", current coinbase " << print_money(best_coinbase));
       if (!meta.fee)
       {
@@ -1249,34 +1211,12 @@ namespace cryptonote
         continue;
       }
 
-      cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(sorted_it->second);
-      cryptonote::transaction tx;
+      const cryptonote::transaction &tx = i->second.tx;
 
       // Skip transactions that are not ready to be
       // included into the blockchain or that are
       // missing key images
-      const cryptonote::txpool_tx_meta_t original_meta = meta;
-      bool ready = false;
-      try
-      {
-        ready = is_transaction_ready_to_go(meta, sorted_it->second, txblob, tx);
-      }
-      catch (const std::exception &e)
-      {
-        MERROR("Failed to check transaction readiness: " << e.what());
-        // continue, not fatal
-      }
-      if (memcmp(&original_meta, &meta, sizeof(meta)))
-      {
-        try {
-          m_blockchain.update_txpool_tx(sorted_it->second, meta);
-        }
-        catch (const std::exception &e) {
-          MERROR("Failed to update tx meta: " << e.what());
-          // continue, not fatal
-        }
-      }
-      if (!ready)
+      if (!is_transaction_ready_cached(sorted_it->second, i->second))
       {
         LOG_PRINT_L2("  not ready to go");
         continue;
@@ -1312,62 +1252,104 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   size_t tx_memory_pool::validate(uint8_t version)
   {
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
-    size_t tx_weight_limit = get_transaction_weight_limit(version);
-    std::unordered_set<crypto::hash> remove;
+    struct revalidated_tx
+    {
+      crypto::hash txid;
+      uint64_t weight;
+      std::vector<crypto::key_image> key_images;
+      const char *reason;
+    };
 
-    m_txpool_weight = 0;
-    m_blockchain.for_all_txpool_txes([this, &remove, tx_weight_limit](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata*) {
-      m_txpool_weight += meta.weight;
-      if (meta.weight > tx_weight_limit) {
-        LOG_PRINT_L1("Transaction " << txid << " is too big (" << meta.weight << " bytes), removing it from pool");
-        remove.insert(txid);
-      }
-      else if (m_blockchain.have_tx(txid)) {
-        LOG_PRINT_L1("Transaction " << txid << " is in the blockchain, removing it from pool");
-        remove.insert(txid);
+    const size_t tx_weight_limit = get_transaction_weight_limit(version);
+    std::vector<revalidated_tx> txs;
+    {
+      CRITICAL_REGION_LOCAL(m_transactions_lock);
+      m_revalidation_pending = false;
+      txs.reserve(m_pool_txs.size());
+      for (const auto &e: m_pool_txs)
+      {
+        txs.push_back({e.first, e.second.meta.weight, {}, nullptr});
+        for (const auto &in: e.second.tx.vin)
+          if (in.type() == typeid(txin_to_key))
+            txs.back().key_images.push_back(boost::get<txin_to_key>(in).k_image);
       }
-      return true;
-    }, false);
+      m_revalidation_total = txs.size();
+      m_revalidation_checked = 0;
+    }
 
-    size_t n_removed = 0;
-    if (!remove.empty())
-    {
-      LockedTXN lock(m_blockchain);
-      for (const crypto::hash &txid: remove)
+    // check stage: the pool is not locked, and the blockchain queries used
+    // here are lock free and read only, so this runs in parallel
+    const Blockchain &blockchain = m_blockchain;
+    const auto check = [&blockchain, tx_weight_limit](revalidated_tx &tx) {
+      if (tx.weight > tx_weight_limit)
+        tx.reason = "is too big";
+      else if (blockchain.have_tx(tx.txid))
+        tx.reason = "is in the blockchain";
+      else
       {
-        try
+        for (const crypto::key_image &k_image: tx.key_images)
         {
-          cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(txid);
-          cryptonote::transaction tx;
-          if (!parse_and_validate_tx_from_blob(txblob, tx))
-          {
-            MERROR("Failed to parse tx from txpool");
-            continue;
-          }
-          // remove tx from db first
-          m_blockchain.remove_txpool_tx(txid);
-          m_txpool_weight -= get_transaction_weight(tx, txblob.size());
-          remove_transaction_keyimages(tx);
-          auto sorted_it = find_tx_in_sorted_container(txid);
-          if (sorted_it == m_txs_by_fee_and_receive_time.end())
+          if (blockchain.have_tx_keyimg_as_spent(k_image))
           {
-            LOG_PRINT_L1("Removing tx " << txid << " from tx pool, but it was not found in the sorted txs container!");
+            tx.reason = "spends a key image spent in the blockchain";
+            break;
           }
-          else
-          {
-            m_txs_by_fee_and_receive_time.erase(sorted_it);
-          }
-          ++n_removed;
         }
-        catch (const std::exception &e)
+      }
+    };
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    tools::threadpool::waiter waiter;
+    const size_t threads = std::max(1u, tpool.get_max_concurrency());
+    const size_t chunk_size = (txs.size() + threads - 1) / threads;
+    for (size_t begin = 0; begin < txs.size(); begin += chunk_size)
+    {
+      const size_t end = std::min(begin + chunk_size, txs.size());
+      tpool.submit(&waiter, [this, &txs, &check, begin, end]() {
+        for (size_t n = begin; n < end; ++n)
         {
-          MERROR("Failed to remove invalid tx from pool");
-          // continue
+          check(txs[n]);
+          ++m_revalidation_checked;
         }
+      });
+    }
+    waiter.wait(&tpool);
+
+    // commit stage: the chain may have moved on meanwhile, so candidates are
+    // checked again before removal, with everything locked
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    CRITICAL_REGION_LOCAL1(m_blockchain);
+    size_t n_removed = 0;
+    for (revalidated_tx &tx: txs)
+    {
+      if (!tx.reason)
+        continue;
+      const auto i = m_pool_txs.find(tx.txid);
+      if (i == m_pool_txs.end())
+        continue;
+      tx.reason = nullptr;
+      check(tx);
+      if (!tx.reason)
+        continue;
+      LOG_PRINT_L1("Transaction " << tx.txid << " " << tx.reason << ", removing it from pool");
+      remove_transaction_keyimages(i->second.tx);
+      remove_pool_tx(tx.txid);
+      auto sorted_it = find_tx_in_sorted_container(tx.txid);
+      if (sorted_it == m_txs_by_fee_and_receive_time.end())
+      {
+        LOG_PRINT_L1("Removing tx " << tx.txid << " from tx pool, but it was not found in the sorted txs container!");
       }
+      else
+      {
+        m_txs_by_fee_and_receive_time.erase(sorted_it);
+      }
+      ++n_removed;
     }
+
+    m_txpool_weight = 0;
+    for (const auto &e: m_pool_txs)
+      m_txpool_weight += e.second.meta.weight;
+    m_revalidation_total = 0;
+    m_revalidation_checked = 0;
     if (n_removed > 0)
       ++m_cookie;
     return n_removed;
@@ -1381,52 +1363,79 @@ namespace cryptonote
     m_txpool_max_weight = max_txpool_weight ? max_txpool_weight : DEFAULT_TXPOOL_MAX_WEIGHT;
     m_txs_by_fee_and_receive_time.clear();
     m_spent_key_images.clear();
+    m_pool_txs.clear();
+    m_fee_rate_index.clear();
+    m_dirty_txs.clear();
+    m_ready_txs.clear();
     m_txpool_weight = 0;
-    std::vector<crypto::hash> remove;
+
+    // parse stage: the blobs are read in one pass, then parsed in parallel
+    struct loaded_tx
+    {
+      crypto::hash txid;
+      txpool_tx_meta_t meta;
+      cryptonote::blobdata blob;
+      transaction tx;
+      bool parsed;
+    };
+    std::vector<loaded_tx> txs;
+    m_blockchain.for_all_txpool_txes([&txs](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd) {
+      txs.push_back({txid, meta, *bd, transaction(), false});
+      return true;
+    }, true);
+    m_revalidation_total = txs.size();
+    m_revalidation_checked = 0;
+
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    tools::threadpool::waiter waiter;
+    const size_t threads = std::max(1u, tpool.get_max_concurrency());
+    const size_t chunk_size = (txs.size() + threads - 1) / threads;
+    for (size_t begin = 0; begin < txs.size(); begin += chunk_size)
+    {
+      const size_t end = std::min(begin + chunk_size, txs.size());
+      tpool.submit(&waiter, [this, &txs, begin, end]() {
+        for (size_t n = begin; n < end; ++n)
+        {
+          txs[n].parsed = parse_and_validate_tx_from_blob(txs[n].blob, txs[n].tx);
+          ++m_revalidation_checked;
+        }
+      });
+    }
+    waiter.wait(&tpool);
+    m_revalidation_total = 0;
+    m_revalidation_checked = 0;
 
     // first add the not kept by block, then the kept by block,
     // to avoid rejection due to key image collision
     for (int pass = 0; pass < 2; ++pass)
     {
       const bool kept = pass == 1;
-      bool r = m_blockchain.for_all_txpool_txes([this, &remove, kept](const crypto::hash &txid, const txpool_tx_meta_t &meta, const cryptonote::blobdata *bd) {
-        if (!!kept != !!meta.kept_by_block)
-          return true;
-        cryptonote::transaction tx;
-        if (!parse_and_validate_tx_from_blob(*bd, tx))
+      for (loaded_tx &tx: txs)
+      {
+        if (!!kept != !!tx.meta.kept_by_block)
+          continue;
+        if (!tx.parsed)
         {
           MWARNING("Failed to parse tx from txpool, removing");
-          remove.push_back(txid);
-          return true;
+          remove_pool_tx(tx.txid);
+          continue;
         }
-        if (!insert_key_images(tx, meta.kept_by_block))
+        if (!insert_key_images(tx.tx, tx.meta.kept_by_block))
         {
           MFATAL("Failed to insert key images from txpool tx");
           return false;
         }
-        m_txs_by_fee_and_receive_time.emplace(std::pair<double, time_t>(meta.fee / (double)meta.weight, meta.receive_time), txid);
-        m_txpool_weight += meta.weight;
-        return true;
-      }, true);
-      if (!r)
-        return false;
-    }
-    if (!remove.empty())
-    {
-      LockedTXN lock(m_blockchain);
-      for (const auto &txid: remove)
-      {
-        try
-        {
-          m_blockchain.remove_txpool_tx(txid);
-        }
-        catch (const std::exception &e)
-        {
-          MWARNING("Failed to remove corrupt transaction: " << txid);
-          // ignore error
-        }
+        pool_tx_entry &e = m_pool_txs[tx.txid];
+        e.meta = tx.meta;
+        e.blob = std::move(tx.blob);
+        e.tx = tx.tx;
+        m_fee_rate_index.insert(tx.txid, tx.meta.fee / (double)tx.meta.weight, tx.meta.weight);
+        m_txs_by_fee_and_receive_time.emplace(std::pair<double, time_t>(tx.meta.fee / (double)tx.meta.weight, tx.meta.receive_time), tx.txid);
+        m_txpool_weight += tx.meta.weight;
       }
     }
+    // corrupt transactions were queued for removal from the database
+    flush();
 
     m_cookie = 0;
 
@@ -1434,9 +1443,119 @@ namespace cryptonote
     return true;
   }
 
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::reload()
+  {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    const uint64_t cookie = m_cookie;
+    const bool r = init(m_txpool_max_weight);
+    // make sure anything cached against the old pool is seen as stale
+    m_cookie = cookie + 1;
+    return r;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::flush()
+  {
+    // take the pending changes, so the pool is not locked while writing
+    std::unordered_set<crypto::hash> dirty;
+    std::vector<std::pair<crypto::hash, pool_tx_entry>> puts;
+    {
+      CRITICAL_REGION_LOCAL(m_transactions_lock);
+      dirty.swap(m_dirty_txs);
+      for (const crypto::hash &txid: dirty)
+      {
+        const auto i = m_pool_txs.find(txid);
+        if (i != m_pool_txs.end())
+          puts.push_back(*i);
+      }
+    }
+    if (dirty.empty())
+      return true;
+    if (m_blockchain.get_db().is_read_only())
+      return true;
+
+    bool r = true;
+    try
+    {
+      CRITICAL_REGION_LOCAL1(m_blockchain);
+      LockedTXN lock(m_blockchain);
+      // every dirty record is rewritten from scratch, so a failed flush can just be repeated
+      for (const crypto::hash &txid: dirty)
+        if (m_blockchain.get_db().txpool_has_tx(txid))
+          m_blockchain.remove_txpool_tx(txid);
+      for (auto &put: puts)
+        m_blockchain.add_txpool_tx(put.second.tx, put.second.meta);
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Failed to write txpool changes to the database: " << e.what());
+      r = false;
+    }
+
+    if (!r)
+    {
+      CRITICAL_REGION_LOCAL(m_transactions_lock);
+      m_dirty_txs.insert(dirty.begin(), dirty.end());
+      return false;
+    }
+    MDEBUG("Wrote " << puts.size() << " txpool transactions and " << dirty.size() - puts.size() << " removals to the database");
+    return true;
+  }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::deinit()
   {
+    flush();
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::put_pool_tx(const crypto::hash &txid, const transaction &tx, const txpool_tx_meta_t &meta)
+  {
+    pool_tx_entry &e = m_pool_txs[txid];
+    e.meta = meta;
+    e.blob = tx_to_blob(tx);
+    e.tx = tx;
+    m_fee_rate_index.insert(txid, meta.fee / (double)meta.weight, meta.weight);
+    m_dirty_txs.insert(txid);
+    m_ready_txs.erase(txid);
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::update_pool_tx(const crypto::hash &txid, const txpool_tx_meta_t &meta)
+  {
+    const auto i = m_pool_txs.find(txid);
+    if (i == m_pool_txs.end())
+      return;
+    i->second.meta = meta;
+    m_dirty_txs.insert(txid);
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::remove_pool_tx(const crypto::hash &txid)
+  {
+    m_pool_txs.erase(txid);
+    m_fee_rate_index.erase(txid);
+    m_dirty_txs.insert(txid);
+    m_ready_txs.erase(txid);
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::for_all_pool_txes(std::function<bool(const crypto::hash&, const pool_tx_entry&)> f, bool include_unrelayed_txes) const
+  {
+    for (const auto &e: m_pool_txs)
+    {
+      if (!include_unrelayed_txes && e.second.meta.do_not_relay)
+        continue;
+      if (!f(e.first, e.second))
+        return false;
+    }
     return true;
   }
+  //---------------------------------------------------------------------------------
+  size_t tx_memory_pool::get_pool_tx_count(bool include_unrelayed_txes) const
+  {
+    if (include_unrelayed_txes)
+      return m_pool_txs.size();
+    size_t count = 0;
+    for (const auto &e: m_pool_txs)
+      if (!e.second.meta.do_not_relay)
+        ++count;
+    return count;
+  }
 }
@@ -46,6 +46,7 @@
 #include "cryptonote_basic/verification_context.h"
 #include "blockchain_db/blockchain_db.h"
 #include "crypto/hash.h"
+#include "fee_rate_index.h"
 #include "rpc/core_rpc_server_commands_defs.h"
 #include "rpc/message_data_structs.h"
 
@@ -157,7 +158,8 @@ namespace cryptonote
     /**
      * @brief action to take when notified of a block added to the blockchain
      *
-     * Currently does nothing
+     * Keeps the cached readiness of transactions which can still go in the
+     * next block, and drops the rest so they get checked again
      *
      * @param new_block_height the height of the blockchain after the change
      * @param top_block_id the hash of the new top block
@@ -166,10 +168,24 @@ namespace cryptonote
      */
     bool on_blockchain_inc(uint64_t new_block_height, const crypto::hash& top_block_id);
 
+    /**
+     * @brief checks if a transaction found ready stays ready when a block is added
+     *
+     * A block only adds outputs and tokens and spends key images, so this
+     * holds unless it spent one of the transaction's key images, or the
+     * transaction creates a token, which the block may have created first.
+     *
+     * @param tx the transaction
+     * @param key_images_spent whether one of tx's key images is now spent
+     *
+     * @return false if the transaction has to be checked again
+     */
+    static bool stays_ready_on_new_block(const transaction &tx, bool key_images_spent);
+
     /**
      * @brief action to take when notified of a block removed from the blockchain
      *
-     * Currently does nothing
+     * Drops all cached transaction readiness
      *
      * @param new_block_height the height of the blockchain after the change
      * @param top_block_id the hash of the new top block
@@ -181,7 +197,9 @@ namespace cryptonote
     /**
      * @brief action to take periodically
      *
-     * Currently checks transaction pool for stale ("stuck") transactions
+     * Checks transaction pool for stale ("stuck") transactions, checks
+     * whether new transactions can go in the next block, and writes pending
+     * pool changes to the database
      */
     void on_idle();
 
@@ -207,13 +225,28 @@ namespace cryptonote
     bool init(size_t max_txpool_weight = 0);
 
     /**
-     * @brief attempts to save the transaction pool state to disk
+     * @brief reloads the pool from disk, after another process changed it
+     *
+     * @return true
+     */
+    bool reload();
+
+    /**
+     * @brief writes pending pool changes to the database
      *
-     * Currently fails (returns false) if the data directory from init()
-     * does not exist and cannot be created, but returns true even if
-     * saving to disk is unsuccessful.
+     * The pool is served from memory, and its database copy is only kept
+     * so the pool survives a restart. Changes are queued as they happen
+     * and written here in a single batch, outside of tx admission and
+     * block template creation.
      *
-     * @return true in most cases (see above)
+     * @return false if writing failed, in which case the changes stay queued
+     */
+    bool flush();
+
+    /**
+     * @brief writes pending pool changes to the database before shutdown
+     *
+     * @return true
      */
     bool deinit();
 
@@ -260,6 +293,22 @@ namespace cryptonote
      */
     void get_transaction_backlog(std::vector<tx_backlog_entry>& backlog, bool include_unrelayed_txes = true) const;
 
+    /**
+     * @brief get the fee per byte needed to be mined soon, and fee per byte percentiles
+     *
+     * Answered from a fee rate index in O(log n) per entry, assuming blocks
+     * are filled by decreasing fee per byte. A fee per byte of 0 means the
+     * pool does not fill that many blocks, so the base fee is enough.
+     *
+     * @param block_weight the weight of transactions a block takes
+     * @param n_blocks the number of ladder steps to return, one per block
+     * @param ladder return-by-reference the fee per byte needed to be mined within 1 to n_blocks blocks
+     * @param percentiles return-by-reference the fee per byte at the 10th, 25th, 50th, 75th and 90th percentiles
+     * @param txs_total return-by-reference the number of transactions in the pool
+     * @param weight_total return-by-reference the weight of transactions in the pool
+     */
+    void get_fee_rate_ladder(uint64_t block_weight, uint64_t n_blocks, std::vector<fee_rate_step> &ladder, std::vector<fee_rate_percentile> &percentiles, uint64_t &txs_total, uint64_t &weight_total) const;
+
     /**
      * @brief get a summary statistics of all transaction hashes in the pool
      *
@@ -359,7 +408,13 @@ namespace cryptonote
      *
      * With new versions of the currency, what conditions render a transaction
      * invalid may change.  This function clears those which were received
-     * before a version change and no longer conform to requirements.
+     * before a version change and no longer conform to requirements, and
+     * those which a reorg made unminable (already in the chain, or spending
+     * a key image the chain spends).
+     *
+     * Transactions are checked in parallel without the pool locked, then
+     * removed in one go with it locked. Progress is reported in
+     * get_transaction_stats.
      *
      * @param version the version the transactions must conform to
      *
@@ -513,12 +568,11 @@ namespace cryptonote
      *
      * @param txd the transaction to check (and info about it)
      * @param txid the txid of the transaction to check
-     * @param txblob the transaction blob to check
-     * @param tx the parsed transaction, if successful
+     * @param tx the transaction to check
      *
      * @return true if the transaction is good to go, otherwise false
      */
-    bool is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const cryptonote::blobdata &txblob, transaction &tx) const;
+    bool is_transaction_ready_to_go(txpool_tx_meta_t& txd, const crypto::hash &txid, const transaction &tx) const;
 
     /**
      * @brief mark all transactions double spending the one passed
@@ -532,6 +586,76 @@ namespace cryptonote
      */
     void prune(size_t bytes = 0);
 
+    /**
+     * @brief a transaction held in the pool
+     */
+    struct pool_tx_entry
+    {
+      txpool_tx_meta_t meta;
+      cryptonote::blobdata blob;
+      transaction tx;
+    };
+
+    //! container for the pool's transactions, by txid
+    typedef std::unordered_map<crypto::hash, pool_tx_entry> pool_txs_container;
+
+    /**
+     * @brief adds or replaces a transaction, and queues it for the database
+     */
+    void put_pool_tx(const crypto::hash &txid, const transaction &tx, const txpool_tx_meta_t &meta);
+
+    /**
+     * @brief replaces a transaction's metadata, and queues it for the database
+     */
+    void update_pool_tx(const crypto::hash &txid, const txpool_tx_meta_t &meta);
+
+    /**
+     * @brief removes a transaction, and queues the removal for the database
+     */
+    void remove_pool_tx(const crypto::hash &txid);
+
+    /**
+     * @brief runs a function over all pool transactions
+     *
+     * @param f the function to run, returning false stops the iteration
+     * @param include_unrelayed_txes whether to include do_not_relay transactions
+     *
+     * @return false if the function returned false, otherwise true
+     */
+    bool for_all_pool_txes(std::function<bool(const crypto::hash&, const pool_tx_entry&)> f, bool include_unrelayed_txes = true) const;
+
+    /**
+     * @brief get the number of transactions in the pool
+     *
+     * @param include_unrelayed_txes whether to include do_not_relay transactions
+     */
+    size_t get_pool_tx_count(bool include_unrelayed_txes = true) const;
+
+    /**
+     * @brief check if a pool transaction can go in the next block, caching the result
+     *
+     * Cached results are kept up to date by on_blockchain_inc and
+     * on_blockchain_dec, so block templates only check new transactions.
+     *
+     * @param txid the txid of the transaction to check
+     * @param entry the transaction to check
+     *
+     * @return true if the transaction is good to go, otherwise false
+     */
+    bool is_transaction_ready_cached(const crypto::hash &txid, const pool_tx_entry &entry);
+
+    /**
+     * @brief drop cached readiness computed for another top block or version
+     *
+     * @param version the hard fork version the next block is for
+     */
+    void sync_ready_txs(uint8_t version);
+
+    /**
+     * @brief check all pool transactions which have no cached readiness yet
+     */
+    void refresh_ready_txs();
+
     //TODO: confirm the below comments and investigate whether or not this
     //      is the desired behavior
     //! map key images to transactions which spent them
@@ -562,6 +686,30 @@ private:
     //!< container for transactions organized by fee per size and receive time
     sorted_tx_container m_txs_by_fee_and_receive_time;
 
+    //! the pool's transactions, parsed, with their blob and metadata
+    pool_txs_container m_pool_txs;
+
+    //! the pool's transactions by fee per byte, for percentile queries
+    fee_rate_index m_fee_rate_index;
+
+    //! txids changed since the last flush, written to the database on the next one
+    std::unordered_set<crypto::hash> m_dirty_txs;
+
+    //! whether pool transactions can go in the next block, per txid
+    std::unordered_map<crypto::hash, bool> m_ready_txs;
+    crypto::hash m_ready_top_id; //!< the top block m_ready_txs was computed for
+    uint8_t m_ready_version; //!< the hard fork version m_ready_txs was computed for
+
+    //! interval on which to check the readiness of transactions which have none cached
+    epee::math_helper::once_a_time_seconds<10> m_refresh_ready_interval;
+
+    std::atomic<bool> m_revalidation_pending; //!< a reorg happened, validate on the next on_idle
+    std::atomic<uint32_t> m_revalidation_total; //!< transactions in the running load or validate, 0 if none
+    std::atomic<uint32_t> m_revalidation_checked; //!< transactions done so far in the running load or validate
+
+    //! interval on which to write pending pool changes to the database
+    epee::math_helper::once_a_time_seconds<5> m_flush_interval;
+
     std::atomic<uint64_t> m_cookie; //!< incremented at each change
 
     /**
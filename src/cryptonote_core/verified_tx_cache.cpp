@@ -0,0 +1,98 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "verified_tx_cache.h"
+
+namespace cryptonote
+{
+  //---------------------------------------------------------------------------------
+  verified_tx_cache::verified_tx_cache(size_t max_entries):
+    m_max_entries(max_entries)
+  {
+  }
+  //---------------------------------------------------------------------------------
+  crypto::hash verified_tx_cache::get_ring_key(const crypto::hash &txid, const rct::rctSig &rv)
+  {
+    rct::keyV data;
+    size_t n_keys = 1;
+    for (const rct::ctkeyV &ring: rv.mixRing)
+      n_keys += ring.size() * 2;
+    data.reserve(n_keys);
+    data.push_back(rct::hash2rct(txid));
+    for (const rct::ctkeyV &ring: rv.mixRing)
+    {
+      for (const rct::ctkey &member: ring)
+      {
+        data.push_back(member.dest);
+        data.push_back(member.mask);
+      }
+    }
+    return crypto::cn_fast_hash(data.data(), data.size() * sizeof(rct::key));
+  }
+  //---------------------------------------------------------------------------------
+  void verified_tx_cache::add(const crypto::hash &key)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+      return;
+    }
+    m_lru.push_front(key);
+    m_entries.insert(std::make_pair(key, m_lru.begin()));
+    if (m_entries.size() > m_max_entries)
+    {
+      m_entries.erase(m_lru.back());
+      m_lru.pop_back();
+    }
+  }
+  //---------------------------------------------------------------------------------
+  bool verified_tx_cache::has(const crypto::hash &key)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+      return false;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void verified_tx_cache::clear()
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    m_lru.clear();
+    m_entries.clear();
+  }
+  //---------------------------------------------------------------------------------
+  size_t verified_tx_cache::size() const
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    return m_entries.size();
+  }
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <boost/thread/mutex.hpp>
+
+#include "crypto/hash.h"
+#include "ringct/rctTypes.h"
+
+namespace cryptonote
+{
+  /**
+   * @brief a bounded record of transactions whose signatures verified
+   *
+   * Entries are keys which bind everything the verification depended on,
+   * so a hit means the same check would pass again. The least recently
+   * used entries are dropped when full. Thread safe.
+   */
+  class verified_tx_cache
+  {
+  public:
+    explicit verified_tx_cache(size_t max_entries);
+
+    /**
+     * @brief the key for the ring signatures of a transaction
+     *
+     * The ring signatures depend on the transaction, which the txid binds
+     * in full, and on the ring members' keys and commitments from the
+     * chain, which are hashed in.
+     *
+     * @param txid the transaction hash
+     * @param rv the transaction's rct signatures, with the mix ring expanded
+     */
+    static crypto::hash get_ring_key(const crypto::hash &txid, const rct::rctSig &rv);
+
+    void add(const crypto::hash &key);
+    bool has(const crypto::hash &key);
+    void clear();
+    size_t size() const;
+
+  private:
+    mutable boost::mutex m_lock;
+    std::list<crypto::hash> m_lru;
+    std::unordered_map<crypto::hash, std::list<crypto::hash>::iterator> m_entries;
+    size_t m_max_entries;
+  };
+}
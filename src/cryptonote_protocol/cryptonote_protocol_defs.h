@@ -147,9 +147,13 @@ namespace cryptonote
     struct request
     {
       std::vector<blobdata>   txs;
+      bool dandelionpp;       // stem phase, peers not knowing it flood the txes
+
+      request(): dandelionpp(false) {}
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(txs)
+        KV_SERIALIZE_OPT(dandelionpp, false)
       END_KV_SERIALIZE_MAP()
     };
   };
@@ -35,6 +35,7 @@
 
 #pragma once
 
+#include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <string>
 
@@ -44,6 +45,8 @@
 #include "cryptonote_protocol_defs.h"
 #include "cryptonote_protocol_handler_common.h"
 #include "block_queue.h"
+#include "dandelionpp.h"
+#include "tx_admission.h"
 #include "cryptonote_basic/connection_context.h"
 #include "cryptonote_basic/cryptonote_stat_info.h"
 #include <boost/circular_buffer.hpp>
@@ -93,6 +96,7 @@ namespace cryptonote
       HANDLE_NOTIFY_T2(NOTIFY_REQUEST_FLUFFY_MISSING_TX, &cryptonote_protocol_handler::handle_request_fluffy_missing_tx)						
     END_INVOKE_MAP2()
 
+    static void init_options(boost::program_options::options_description& desc);
     bool on_idle();
     bool init(const boost::program_options::variables_map& vm);
     bool deinit();
@@ -132,6 +136,8 @@ namespace cryptonote
     bool should_download_next_span(cryptonote_connection_context& context) const;
     void drop_connection(cryptonote_connection_context &context, bool add_fail, bool flush_all_spans);
     bool kick_idle_peers();
+    bool update_tx_relay();
+    void flush_fluff_batch(uint64_t now_ms);
     int try_add_next_blocks(cryptonote_connection_context &context);
 
     t_core& m_core;
@@ -143,6 +149,8 @@ namespace cryptonote
     std::atomic<bool> m_stopping;
     boost::mutex m_sync_lock;
     block_queue m_block_queue;
+    tx_admission m_tx_admission;
+    dandelionpp_relay m_dandelionpp;
     epee::math_helper::once_a_time_seconds<30> m_idle_peer_kicker;
 
     boost::mutex m_buffer_mutex;
@@ -74,8 +74,23 @@ namespace cryptonote
   }
   //-----------------------------------------------------------------------------------------------------------------------
   template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::init_options(boost::program_options::options_description& desc)
+  {
+    command_line::add_arg(desc, arg_tx_relay_cost_rate);
+    command_line::add_arg(desc, arg_tx_relay_cost_burst);
+    command_line::add_arg(desc, arg_tx_relay_stems);
+    command_line::add_arg(desc, arg_tx_relay_fluff_interval);
+  }
+  //-----------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
   bool t_cryptonote_protocol_handler<t_core>::init(const boost::program_options::variables_map& vm)
   {
+    // not registered when embedded in tests
+    if (vm.count(arg_tx_relay_cost_rate.name) && vm.count(arg_tx_relay_cost_burst.name))
+      m_tx_admission.set_limits(command_line::get_arg(vm, arg_tx_relay_cost_rate), command_line::get_arg(vm, arg_tx_relay_cost_burst));
+    if (vm.count(arg_tx_relay_stems.name) && vm.count(arg_tx_relay_fluff_interval.name))
+      m_dandelionpp.set_config(command_line::get_arg(vm, arg_tx_relay_stems), DANDELIONPP_FLUFF_PROBABILITY,
+          DANDELIONPP_EPOCH * 1000, DANDELIONPP_EMBARGO_AVERAGE * 1000, command_line::get_arg(vm, arg_tx_relay_fluff_interval));
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
@@ -778,10 +793,24 @@ namespace cryptonote
       return 1;
     }
 
+    // including txes we already have, which we may be holding back in the stem phase
+    if (!arg.dandelionpp)
+      for (const cryptonote::blobdata &blob: arg.txs)
+        m_dandelionpp.on_fluff_seen(blob);
+
     std::vector<cryptonote::blobdata> newtxs;
     newtxs.reserve(arg.txs.size());
+    size_t refused = 0;
     for (size_t i = 0; i < arg.txs.size(); ++i)
     {
+      // blobs which do not parse are left to the core to reject, dropping the connection
+      cryptonote::transaction tx;
+      if (parse_and_validate_tx_base_from_blob(arg.txs[i], tx) && !m_tx_admission.admit(context.m_connection_id, estimate_tx_verification_cost(tx)))
+      {
+        ++refused;
+        continue;
+      }
+
       cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
       m_core.handle_incoming_tx(arg.txs[i], tvc, false, true, false);
       if(tvc.m_verifivation_failed)
@@ -794,6 +823,8 @@ namespace cryptonote
         newtxs.push_back(std::move(arg.txs[i]));
     }
     arg.txs = std::move(newtxs);
+    if (refused)
+      LOG_DEBUG_CC(context, "Refused " << refused << " txes over the relay rate limit, " << m_tx_admission.get_refused_count() << " since startup");
 
     if(arg.txs.size())
     {
@@ -1227,10 +1258,29 @@ skip:
   bool t_cryptonote_protocol_handler<t_core>::on_idle()
   {
     m_idle_peer_kicker.do_call(boost::bind(&t_cryptonote_protocol_handler<t_core>::kick_idle_peers, this));
+    update_tx_relay();
     return m_core.on_idle();
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::update_tx_relay()
+  {
+    std::vector<boost::uuids::uuid> outgoing;
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id, uint32_t support_flags)->bool
+    {
+      if (peer_id && !context.m_is_income && context.m_state == cryptonote_connection_context::state_normal)
+        outgoing.push_back(context.m_connection_id);
+      return true;
+    });
+
+    const uint64_t now = epee::misc_utils::get_tick_count();
+    m_dandelionpp.update_peers(outgoing, now);
+    m_dandelionpp.check_embargoes(now);
+    flush_fluff_batch(now);
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
   bool t_cryptonote_protocol_handler<t_core>::kick_idle_peers()
   {
     MTRACE("Checking for idle peers...");
@@ -1745,7 +1795,74 @@ skip:
     // no check for success, so tell core they're relayed unconditionally
     for(auto tx_blob_it = arg.txs.begin(); tx_blob_it!=arg.txs.end(); ++tx_blob_it)
       m_core.on_transaction_relayed(*tx_blob_it);
-    return relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(arg, exclude_context);
+
+    const uint64_t now = epee::misc_utils::get_tick_count();
+    std::map<boost::uuids::uuid, NOTIFY_NEW_TRANSACTIONS::request> stems;
+    for (cryptonote::blobdata &blob: arg.txs)
+    {
+      boost::uuids::uuid stem_peer;
+      if (arg.dandelionpp && m_dandelionpp.route_stem(exclude_context.m_connection_id, blob, stem_peer, now))
+        stems[stem_peer].txs.push_back(std::move(blob));
+      else
+        m_dandelionpp.queue_fluff(blob, exclude_context.m_connection_id);
+    }
+
+    for (auto &stem: stems)
+    {
+      stem.second.dandelionpp = true;
+      std::string blob;
+      epee::serialization::store_t_to_binary(stem.second, blob);
+      m_p2p->relay_notify_to_list(NOTIFY_NEW_TRANSACTIONS::ID, blob, std::list<boost::uuids::uuid>{stem.first});
+    }
+
+    flush_fluff_batch(now);
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::flush_fluff_batch(uint64_t now_ms)
+  {
+    std::vector<cryptonote::blobdata> txs;
+    std::vector<boost::uuids::uuid> sources;
+    if (!m_dandelionpp.take_fluff_batch(txs, sources, now_ms))
+      return;
+
+    // peers are not sent back the txes they sent us, which needs a message of their own
+    std::list<boost::uuids::uuid> all_connections;
+    std::vector<boost::uuids::uuid> source_connections;
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id, uint32_t support_flags)->bool
+    {
+      if (peer_id)
+      {
+        if (std::find(sources.begin(), sources.end(), context.m_connection_id) == sources.end())
+          all_connections.push_back(context.m_connection_id);
+        else
+          source_connections.push_back(context.m_connection_id);
+      }
+      return true;
+    });
+
+    NOTIFY_NEW_TRANSACTIONS::request arg;
+    if (!all_connections.empty())
+    {
+      arg.txs = txs;
+      std::string blob;
+      epee::serialization::store_t_to_binary(arg, blob);
+      m_p2p->relay_notify_to_list(NOTIFY_NEW_TRANSACTIONS::ID, blob, all_connections);
+    }
+    for (const boost::uuids::uuid &connection_id: source_connections)
+    {
+      arg.txs.clear();
+      for (size_t i = 0; i < txs.size(); ++i)
+        if (sources[i] != connection_id)
+          arg.txs.push_back(txs[i]);
+      if (arg.txs.empty())
+        continue;
+      std::string blob;
+      epee::serialization::store_t_to_binary(arg, blob);
+      m_p2p->relay_notify_to_list(NOTIFY_NEW_TRANSACTIONS::ID, blob, std::list<boost::uuids::uuid>{connection_id});
+    }
+    MDEBUG("Fluffed " << txs.size() << " txes to " << all_connections.size() + source_connections.size() << " peers");
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core>
@@ -1779,6 +1896,8 @@ skip:
     }
 
     m_block_queue.flush_spans(context.m_connection_id, false);
+    m_tx_admission.remove_connection(context.m_connection_id);
+    m_dandelionpp.remove_connection(context.m_connection_id);
   }
 
   //------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,254 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <boost/uuid/nil_generator.hpp>
+#include "crypto/crypto.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_config.h"
+#include "dandelionpp.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "cn.protocol.dandelionpp"
+
+namespace cryptonote
+{
+  const command_line::arg_descriptor<size_t> arg_tx_relay_stems = {
+    "tx-relay-stems"
+  , "Number of outgoing peers transactions may be stemmed to before being flooded (0 to flood right away). "
+    "This only hides a transaction's origin from p2p peers: stem transactions are added to the pool as usual, "
+    "so anyone with access to the RPC of a node on the stem can see them before they are flooded"
+  , DANDELIONPP_STEMS
+  };
+  const command_line::arg_descriptor<uint64_t> arg_tx_relay_fluff_interval = {
+    "tx-relay-fluff-interval"
+  , "Milliseconds to batch flooded transactions for, sending one message per peer and batch (0 to send right away)"
+  , DANDELIONPP_FLUFF_INTERVAL
+  };
+
+  //---------------------------------------------------------------------------------
+  dandelionpp_relay::dandelionpp_relay():
+    dandelionpp_relay(crypto::rand<uint64_t>())
+  {
+  }
+  //---------------------------------------------------------------------------------
+  dandelionpp_relay::dandelionpp_relay(uint64_t seed):
+    m_rng(seed),
+    m_stems(DANDELIONPP_STEMS),
+    m_fluff_probability(DANDELIONPP_FLUFF_PROBABILITY),
+    m_epoch_ms(DANDELIONPP_EPOCH * 1000),
+    m_embargo_ms(DANDELIONPP_EMBARGO_AVERAGE * 1000),
+    m_fluff_interval_ms(DANDELIONPP_FLUFF_INTERVAL),
+    m_epoch_start_ms(0),
+    m_fluff_epoch(false),
+    m_next_fluff_ms(0)
+  {
+  }
+  //---------------------------------------------------------------------------------
+  void dandelionpp_relay::set_config(size_t stems, unsigned fluff_probability, uint64_t epoch_ms, uint64_t embargo_ms, uint64_t fluff_interval_ms)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    m_stems = stems;
+    m_fluff_probability = std::min(fluff_probability, 100u);
+    m_epoch_ms = epoch_ms;
+    m_embargo_ms = embargo_ms;
+    m_fluff_interval_ms = fluff_interval_ms;
+
+    // start a new epoch on the next update
+    m_epoch_start_ms = 0;
+    m_stem_peers.clear();
+    m_routes.clear();
+  }
+  //---------------------------------------------------------------------------------
+  bool dandelionpp_relay::is_stem_enabled() const
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    return m_stems > 0;
+  }
+  //---------------------------------------------------------------------------------
+  bool dandelionpp_relay::is_fluff_epoch() const
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    return m_fluff_epoch;
+  }
+  //---------------------------------------------------------------------------------
+  void dandelionpp_relay::select_stems(const std::vector<connection_id> &candidates)
+  {
+    if (m_stem_peers.size() >= m_stems)
+      return;
+
+    std::vector<connection_id> unused;
+    for (const connection_id &id: candidates)
+      if (std::find(m_stem_peers.begin(), m_stem_peers.end(), id) == m_stem_peers.end())
+        unused.push_back(id);
+    std::shuffle(unused.begin(), unused.end(), m_rng);
+    for (size_t i = 0; i < unused.size() && m_stem_peers.size() < m_stems; ++i)
+      m_stem_peers.push_back(unused[i]);
+  }
+  //---------------------------------------------------------------------------------
+  void dandelionpp_relay::update_peers(const std::vector<connection_id> &outgoing, uint64_t now_ms)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    m_candidates = outgoing;
+
+    if (m_epoch_start_ms == 0 || now_ms >= m_epoch_start_ms + m_epoch_ms)
+    {
+      m_epoch_start_ms = std::max<uint64_t>(now_ms, 1);
+      m_fluff_epoch = m_rng() % 100 < m_fluff_probability;
+      m_stem_peers.clear();
+      m_routes.clear();
+      MDEBUG("New epoch, " << (m_fluff_epoch ? "fluffing" : "stemming") << " transactions");
+    }
+    else
+    {
+      auto gone = [&outgoing](const connection_id &id) { return std::find(outgoing.begin(), outgoing.end(), id) == outgoing.end(); };
+      m_stem_peers.erase(std::remove_if(m_stem_peers.begin(), m_stem_peers.end(), gone), m_stem_peers.end());
+    }
+
+    select_stems(m_candidates);
+  }
+  //---------------------------------------------------------------------------------
+  bool dandelionpp_relay::route_stem(const connection_id &from, const blobdata &blob, connection_id &to, uint64_t now_ms)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    if (m_stems == 0)
+      return false;
+    // a node fluffing for an epoch still stems its own transactions
+    if (m_fluff_epoch && from != boost::uuids::nil_uuid())
+      return false;
+
+    const auto route = m_routes.find(from);
+    if (route != m_routes.end() && std::find(m_stem_peers.begin(), m_stem_peers.end(), route->second) != m_stem_peers.end())
+    {
+      to = route->second;
+    }
+    else
+    {
+      std::vector<connection_id> peers;
+      for (const connection_id &id: m_stem_peers)
+        if (id != from)
+          peers.push_back(id);
+      if (peers.empty())
+        return false;
+      to = peers[m_rng() % peers.size()];
+      m_routes[from] = to;
+    }
+
+    // exponentially distributed, so the embargo length says little about the stem length
+    uint64_t embargo_ms = 0;
+    if (m_embargo_ms > 0)
+    {
+      std::exponential_distribution<double> distribution(1.0 / m_embargo_ms);
+      embargo_ms = std::min<uint64_t>(distribution(m_rng), 4 * m_embargo_ms);
+    }
+    m_embargoes[get_blob_hash(blob)] = {blob, now_ms + embargo_ms};
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool dandelionpp_relay::lift_embargo(const crypto::hash &id)
+  {
+    return m_embargoes.erase(id) > 0;
+  }
+  //---------------------------------------------------------------------------------
+  void dandelionpp_relay::queue_fluff(const blobdata &blob, const connection_id &from)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    lift_embargo(get_blob_hash(blob));
+    m_fluff_txs.push_back(blob);
+    m_fluff_sources.push_back(from);
+  }
+  //---------------------------------------------------------------------------------
+  void dandelionpp_relay::on_fluff_seen(const blobdata &blob)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    if (m_embargoes.empty())
+      return;
+    lift_embargo(get_blob_hash(blob));
+  }
+  //---------------------------------------------------------------------------------
+  size_t dandelionpp_relay::check_embargoes(uint64_t now_ms)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    size_t expired = 0;
+    for (auto i = m_embargoes.begin(); i != m_embargoes.end(); )
+    {
+      if (i->second.deadline_ms <= now_ms)
+      {
+        m_fluff_txs.push_back(std::move(i->second.blob));
+        m_fluff_sources.push_back(boost::uuids::nil_uuid());
+        i = m_embargoes.erase(i);
+        ++expired;
+      }
+      else
+        ++i;
+    }
+    if (expired)
+      MDEBUG(expired << " stem transactions not seen fluffed before their embargo, fluffing");
+    return expired;
+  }
+  //---------------------------------------------------------------------------------
+  bool dandelionpp_relay::take_fluff_batch(std::vector<blobdata> &txs, std::vector<connection_id> &sources, uint64_t now_ms)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    if (m_fluff_txs.empty() || now_ms < m_next_fluff_ms)
+      return false;
+    txs.clear();
+    sources.clear();
+    txs.swap(m_fluff_txs);
+    sources.swap(m_fluff_sources);
+    m_next_fluff_ms = now_ms + m_fluff_interval_ms;
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void dandelionpp_relay::remove_connection(const connection_id &id)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    m_candidates.erase(std::remove(m_candidates.begin(), m_candidates.end(), id), m_candidates.end());
+    const auto stem = std::find(m_stem_peers.begin(), m_stem_peers.end(), id);
+    if (stem == m_stem_peers.end())
+    {
+      m_routes.erase(id);
+      return;
+    }
+    m_stem_peers.erase(stem);
+    for (auto i = m_routes.begin(); i != m_routes.end(); )
+    {
+      if (i->first == id || i->second == id)
+        i = m_routes.erase(i);
+      else
+        ++i;
+    }
+    select_stems(m_candidates);
+  }
+  //---------------------------------------------------------------------------------
+  size_t dandelionpp_relay::get_embargoed_count() const
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    return m_embargoes.size();
+  }
+}
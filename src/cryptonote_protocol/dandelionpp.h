@@ -0,0 +1,188 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include "common/command_line.h"
+#include "crypto/hash.h"
+#include "cryptonote_basic/blobdatatype.h"
+
+namespace cryptonote
+{
+  extern const command_line::arg_descriptor<size_t> arg_tx_relay_stems;
+  extern const command_line::arg_descriptor<uint64_t> arg_tx_relay_fluff_interval;
+
+  /**
+   * @brief Dandelion++ routing of relayed transactions
+   *
+   * Transactions first travel along a stem, each node forwarding to one of
+   * a few outgoing peers chosen once per epoch, so that the node a
+   * transaction came from cannot be found by watching which peer announces
+   * it first. In a fraction of epochs a node fluffs instead, and the
+   * transaction is flooded from there. Each stem hop sets an embargo timer,
+   * after which the transaction is fluffed if it was not seen fluffed, so a
+   * peer dropping stem transactions only delays them.
+   *
+   * Only the p2p relay is affected. Stem transactions go into the pool as
+   * soon as they are received, and pool RPC calls show them before they are
+   * fluffed, so a node on the stem whose RPC is reachable exposes them early.
+   *
+   * Fluffed transactions are queued and flooded in batches, one message per
+   * peer and interval rather than one per peer and transaction.
+   *
+   * Connections are identified by their id, the nil id meaning this node.
+   * Time is passed in so tests can run on a simulated clock. Thread safe.
+   */
+  class dandelionpp_relay
+  {
+  public:
+    typedef boost::uuids::uuid connection_id;
+
+    dandelionpp_relay();
+    explicit dandelionpp_relay(uint64_t seed);
+
+    /**
+     * @brief sets the parameters, 0 stems disables the stem phase
+     *
+     * @param stems the number of stem peers per epoch
+     * @param fluff_probability the percentage of epochs in which to fluff
+     * @param epoch_ms the epoch length
+     * @param embargo_ms the average embargo time
+     * @param fluff_interval_ms the time fluffed transactions are batched for
+     */
+    void set_config(size_t stems, unsigned fluff_probability, uint64_t epoch_ms, uint64_t embargo_ms, uint64_t fluff_interval_ms);
+
+    //! whether transactions are stemmed at all
+    bool is_stem_enabled() const;
+
+    //! whether this node fluffs stem transactions in the current epoch
+    bool is_fluff_epoch() const;
+
+    /**
+     * @brief updates the candidate stem peers, starting a new epoch when due
+     *
+     * Within an epoch, stem peers which went away are replaced and the
+     * others kept.
+     *
+     * @param outgoing the outgoing connections which may be stem peers
+     * @param now_ms the current time
+     */
+    void update_peers(const std::vector<connection_id> &outgoing, uint64_t now_ms);
+
+    /**
+     * @brief decides where to send a stem transaction
+     *
+     * Transactions from one connection all go to the same stem peer within
+     * an epoch. Local transactions are always stemmed. A stemmed
+     * transaction is put under embargo.
+     *
+     * @param from the connection the transaction came from
+     * @param blob the transaction
+     * @param to return-by-reference the stem peer
+     * @param now_ms the current time
+     *
+     * @return true to stem to the given peer, false to fluff
+     */
+    bool route_stem(const connection_id &from, const blobdata &blob, connection_id &to, uint64_t now_ms);
+
+    /**
+     * @brief queues a transaction for the next fluff batch, lifting any embargo
+     *
+     * @param blob the transaction
+     * @param from the connection it came from, which it is not sent back to
+     */
+    void queue_fluff(const blobdata &blob, const connection_id &from);
+
+    /**
+     * @brief lifts the embargo on a transaction another node fluffed
+     */
+    void on_fluff_seen(const blobdata &blob);
+
+    /**
+     * @brief moves transactions whose embargo expired to the fluff queue
+     *
+     * @return the number of transactions moved
+     */
+    size_t check_embargoes(uint64_t now_ms);
+
+    /**
+     * @brief takes the queued fluff batch if the batching interval is over
+     *
+     * @param txs return-by-reference the transactions to flood
+     * @param sources return-by-reference the connection each came from
+     * @param now_ms the current time
+     *
+     * @return true if there is a batch to flood
+     */
+    bool take_fluff_batch(std::vector<blobdata> &txs, std::vector<connection_id> &sources, uint64_t now_ms);
+
+    /**
+     * @brief forgets a closed connection, picking other stem peers if needed
+     */
+    void remove_connection(const connection_id &id);
+
+    //! the number of transactions under embargo
+    size_t get_embargoed_count() const;
+
+  private:
+    struct embargo
+    {
+      blobdata blob;
+      uint64_t deadline_ms;
+    };
+
+    void select_stems(const std::vector<connection_id> &candidates);
+    bool lift_embargo(const crypto::hash &id);
+
+    mutable boost::mutex m_lock;
+    std::mt19937_64 m_rng;
+    size_t m_stems;
+    unsigned m_fluff_probability;
+    uint64_t m_epoch_ms;
+    uint64_t m_embargo_ms;
+    uint64_t m_fluff_interval_ms;
+
+    uint64_t m_epoch_start_ms;
+    bool m_fluff_epoch;
+    std::vector<connection_id> m_candidates;
+    std::vector<connection_id> m_stem_peers;
+    std::map<connection_id, connection_id> m_routes;
+
+    std::unordered_map<crypto::hash, embargo> m_embargoes;
+    std::vector<blobdata> m_fluff_txs;
+    std::vector<connection_id> m_fluff_sources;
+    uint64_t m_next_fluff_ms;
+  };
+}
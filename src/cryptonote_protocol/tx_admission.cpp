@@ -0,0 +1,150 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <set>
+#include "misc_os_dependent.h"
+#include "cryptonote_config.h"
+#include "tx_admission.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "cn.protocol"
+
+namespace
+{
+  // in units of one ring member check
+  const uint64_t base_cost = 10;
+  const uint64_t key_image_cost = 2;
+  const uint64_t bulletproof_cost = 32;
+  const uint64_t bulletproof_output_cost = 16;
+  const uint64_t borromean_output_cost = 64;
+  const uint64_t token_genesis_cost = 50;
+  const uint64_t token_cost = 4;
+}
+
+namespace cryptonote
+{
+  const command_line::arg_descriptor<uint64_t> arg_tx_relay_cost_rate = {
+    "tx-relay-cost-rate"
+  , "Verification cost units per second each peer may relay transactions for, about 100 per typical transaction (0 to disable)"
+  , DEFAULT_TX_RELAY_COST_RATE
+  };
+  const command_line::arg_descriptor<uint64_t> arg_tx_relay_cost_burst = {
+    "tx-relay-cost-burst"
+  , "Verification cost units each peer may relay transactions for at once"
+  , DEFAULT_TX_RELAY_COST_BURST
+  };
+
+  //---------------------------------------------------------------------------------
+  uint64_t estimate_tx_verification_cost(const transaction &tx)
+  {
+    uint64_t cost = base_cost;
+    std::set<TokenId> tokens;
+    for (const txin_v &in: tx.vin)
+    {
+      if (in.type() != typeid(txin_to_key))
+        continue;
+      const txin_to_key &in_to_key = boost::get<txin_to_key>(in);
+      cost += in_to_key.key_offsets.size() + key_image_cost;
+      tokens.insert(in_to_key.token_id);
+    }
+    for (const tx_out &out: tx.vout)
+      tokens.insert(out.token_id);
+
+    const uint8_t type = tx.rct_signatures.type;
+    if (rct::is_rct_bulletproof(type))
+    {
+      // aggregated proofs are padded to a power of 2 outputs
+      uint64_t outputs = 1;
+      while (outputs < tx.vout.size())
+        outputs <<= 1;
+      cost += bulletproof_cost + outputs * bulletproof_output_cost;
+    }
+    else if (rct::is_rct_borromean(type))
+    {
+      cost += tx.vout.size() * borromean_output_cost;
+    }
+
+    if (tx.is_token_genesis())
+      cost += token_genesis_cost;
+    if (tokens.size() > 1)
+      cost += tokens.size() * token_cost;
+    return cost;
+  }
+  //---------------------------------------------------------------------------------
+  tx_admission::tx_admission():
+    m_rate(DEFAULT_TX_RELAY_COST_RATE),
+    m_burst(DEFAULT_TX_RELAY_COST_BURST),
+    m_refused(0)
+  {
+  }
+  //---------------------------------------------------------------------------------
+  void tx_admission::set_limits(uint64_t rate, uint64_t burst)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    m_rate = rate;
+    m_burst = std::max(burst, rate);
+    m_buckets.clear();
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_admission::admit(const boost::uuids::uuid &connection_id, uint64_t cost, uint64_t now_ms)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    if (m_rate == 0)
+      return true;
+
+    auto it = m_buckets.find(connection_id);
+    if (it == m_buckets.end())
+      it = m_buckets.insert(std::make_pair(connection_id, bucket{(double)m_burst, now_ms})).first;
+    bucket &b = it->second;
+    if (now_ms > b.last_ms)
+    {
+      b.units = std::min((double)m_burst, b.units + (now_ms - b.last_ms) * m_rate / 1000.0);
+      b.last_ms = now_ms;
+    }
+
+    if (b.units < cost)
+    {
+      ++m_refused;
+      return false;
+    }
+    b.units -= cost;
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_admission::admit(const boost::uuids::uuid &connection_id, uint64_t cost)
+  {
+    return admit(connection_id, cost, epee::misc_utils::get_tick_count());
+  }
+  //---------------------------------------------------------------------------------
+  void tx_admission::remove_connection(const boost::uuids::uuid &connection_id)
+  {
+    boost::unique_lock<boost::mutex> lock(m_lock);
+    m_buckets.erase(connection_id);
+  }
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <boost/thread/mutex.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include "common/command_line.h"
+#include "cryptonote_basic/cryptonote_basic.h"
+
+namespace cryptonote
+{
+  extern const command_line::arg_descriptor<uint64_t> arg_tx_relay_cost_rate;
+  extern const command_line::arg_descriptor<uint64_t> arg_tx_relay_cost_burst;
+
+  /**
+   * @brief rough estimate of the CPU time needed to verify a transaction
+   *
+   * One cost unit is about the time to check one ring member of a ring
+   * signature. Inputs cost by ring size, range proofs by type and number
+   * of outputs, with extra for token genesis and multi-token transactions.
+   * Only the transaction prefix and the rct base are needed.
+   *
+   * @param tx the transaction, which may be parsed with parse_and_validate_tx_base_from_blob
+   *
+   * @return the estimated cost
+   */
+  uint64_t estimate_tx_verification_cost(const transaction &tx);
+
+  /**
+   * @brief per connection token buckets limiting the verification cost of relayed transactions
+   *
+   * Each connection may spend up to burst cost units at once, refilled at
+   * rate units per second. Transactions over budget are not verified nor
+   * relayed, so one peer flooding the pool cannot starve the others.
+   */
+  class tx_admission
+  {
+  public:
+    tx_admission();
+
+    /**
+     * @brief sets the limits, a rate of 0 disables limiting
+     */
+    void set_limits(uint64_t rate, uint64_t burst);
+
+    /**
+     * @brief takes cost units from a connection's bucket
+     *
+     * @param connection_id the connection relaying the transaction
+     * @param cost the estimated verification cost
+     * @param now_ms the current time in milliseconds
+     *
+     * @return true if the connection had enough units left
+     */
+    bool admit(const boost::uuids::uuid &connection_id, uint64_t cost, uint64_t now_ms);
+    bool admit(const boost::uuids::uuid &connection_id, uint64_t cost);
+
+    /**
+     * @brief forgets a closed connection
+     */
+    void remove_connection(const boost::uuids::uuid &connection_id);
+
+    //! the number of transactions refused since startup
+    uint64_t get_refused_count() const { return m_refused; }
+
+  private:
+    struct bucket
+    {
+      double units;
+      uint64_t last_ms;
+    };
+
+    mutable boost::mutex m_lock;
+    std::map<boost::uuids::uuid, bucket> m_buckets;
+    uint64_t m_rate;
+    uint64_t m_burst;
+    std::atomic<uint64_t> m_refused; //!< read without m_lock
+  };
+}
@@ -69,7 +69,7 @@ public:
       boost::program_options::variables_map const & vm
     )
     : core{vm}
-    , protocol{vm, core, command_line::get_arg(vm, cryptonote::arg_offline)}
+    , protocol{vm, core, command_line::get_arg(vm, cryptonote::arg_offline) || command_line::get_arg(vm, cryptonote::arg_db_read_only_replica)}
     , p2p{vm, protocol}
   {
     // Handle circular dependencies
@@ -95,6 +95,7 @@ public:
 void t_daemon::init_options(boost::program_options::options_description & option_spec)
 {
   t_core::init_options(option_spec);
+  t_protocol::init_options(option_spec);
   t_p2p::init_options(option_spec);
   t_rpc::init_options(option_spec);
 }
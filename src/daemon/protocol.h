@@ -45,6 +45,11 @@ private:
 
   t_protocol_raw m_protocol;
 public:
+  static void init_options(boost::program_options::options_description & option_spec)
+  {
+    t_protocol_raw::init_options(option_spec);
+  }
+
   t_protocol(
       boost::program_options::variables_map const & vm
     , t_core & core, bool offline = false
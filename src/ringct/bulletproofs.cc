@@ -32,6 +32,7 @@
 #include "bulletproofs.h"
 
 #include "common/perf_timer.h"
+#include "common/threadpool.h"
 #include "cryptonote_config.h"
 #include "misc_log_ex.h"
 #include "multiexp.h"
@@ -46,7 +47,10 @@ extern "C" {
 #include <openssl/bn.h>
 
 #include <cstdlib>
+#include <exception>
+#include <functional>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -455,7 +459,7 @@ Bulletproof bulletproof_PROVE(const rct::key &sv, const rct::key &gamma)
   rct::keyV aL(N), aR(N);
 
   PERF_TIMER_START_BP(PROVE_v);
-  rct::addKeys2(V, gamma, sv, rct::H);
+  rct::addKeys2Generator(V, gamma, sv, rct::H);
   V = rct::scalarmultKey(V, INV_EIGHT);
   PERF_TIMER_STOP(PROVE_v);
 
@@ -581,9 +585,9 @@ try_again:
   // PAPER LINES 47-48
   rct::key tau1 = rct::skGen(), tau2 = rct::skGen();
 
-  rct::key T1 = rct::addKeys(rct::scalarmultKey(H, t1), rct::scalarmultBase(tau1));
+  rct::key T1 = rct::addKeys(rct::scalarmultGenerator(H, t1), rct::scalarmultBase(tau1));
   T1 = rct::scalarmultKey(T1, INV_EIGHT);
-  rct::key T2 = rct::addKeys(rct::scalarmultKey(H, t2), rct::scalarmultBase(tau2));
+  rct::key T2 = rct::addKeys(rct::scalarmultGenerator(H, t2), rct::scalarmultBase(tau2));
   T2 = rct::scalarmultKey(T2, INV_EIGHT);
 
   // PAPER LINES 49-51
@@ -660,11 +664,11 @@ try_again:
     // PAPER LINES 18-19
     L[round] = vector_exponent_custom(slice(Gprime, nprime, Gprime.size()), slice(Hprime, 0, nprime), slice(aprime, 0, nprime), slice(bprime, nprime, bprime.size()));
     sc_mul(tmp.bytes, cL.bytes, x_ip.bytes);
-    rct::addKeys(L[round], L[round], rct::scalarmultKey(H, tmp));
+    rct::addKeys(L[round], L[round], rct::scalarmultGenerator(H, tmp));
     L[round] = rct::scalarmultKey(L[round], INV_EIGHT);
     R[round] = vector_exponent_custom(slice(Gprime, 0, nprime), slice(Hprime, nprime, Hprime.size()), slice(aprime, nprime, aprime.size()), slice(bprime, 0, nprime));
     sc_mul(tmp.bytes, cR.bytes, x_ip.bytes);
-    rct::addKeys(R[round], R[round], rct::scalarmultKey(H, tmp));
+    rct::addKeys(R[round], R[round], rct::scalarmultGenerator(H, tmp));
     R[round] = rct::scalarmultKey(R[round], INV_EIGHT);
 
     // PAPER LINES 21-22
@@ -739,7 +743,7 @@ Bulletproof bulletproof_PROVE(const rct::keyV &sv, const rct::keyV &gamma)
   PERF_TIMER_START_BP(PROVE_v);
   for (size_t i = 0; i < sv.size(); ++i)
   {
-    rct::addKeys2(V[i], gamma[i], sv[i], rct::H);
+    rct::addKeys2Generator(V[i], gamma[i], sv[i], rct::H);
     V[i] = rct::scalarmultKey(V[i], INV_EIGHT);
   }
   PERF_TIMER_STOP(PROVE_v);
@@ -862,9 +866,9 @@ try_again:
   // PAPER LINES 47-48
   rct::key tau1 = rct::skGen(), tau2 = rct::skGen();
 
-  rct::key T1 = rct::addKeys(rct::scalarmultKey(H, t1), rct::scalarmultBase(tau1));
+  rct::key T1 = rct::addKeys(rct::scalarmultGenerator(H, t1), rct::scalarmultBase(tau1));
   T1 = rct::scalarmultKey(T1, INV_EIGHT);
-  rct::key T2 = rct::addKeys(rct::scalarmultKey(H, t2), rct::scalarmultBase(tau2));
+  rct::key T2 = rct::addKeys(rct::scalarmultGenerator(H, t2), rct::scalarmultBase(tau2));
   T2 = rct::scalarmultKey(T2, INV_EIGHT);
 
   // PAPER LINES 49-51
@@ -954,11 +958,11 @@ try_again:
     // PAPER LINES 18-19
     L[round] = vector_exponent_custom(slice(Gprime, nprime, Gprime.size()), slice(Hprime, 0, nprime), slice(aprime, 0, nprime), slice(bprime, nprime, bprime.size()));
     sc_mul(tmp.bytes, cL.bytes, x_ip.bytes);
-    rct::addKeys(L[round], L[round], rct::scalarmultKey(H,tmp));
+    rct::addKeys(L[round], L[round], rct::scalarmultGenerator(H, tmp));
     L[round] = rct::scalarmultKey(L[round], INV_EIGHT);
     R[round] = vector_exponent_custom(slice(Gprime, 0, nprime), slice(Hprime, nprime, Hprime.size()), slice(aprime, nprime, aprime.size()), slice(bprime, 0, nprime));
     sc_mul(tmp.bytes, cR.bytes, x_ip.bytes);
-    rct::addKeys(R[round], R[round], rct::scalarmultKey(H, tmp));
+    rct::addKeys(R[round], R[round], rct::scalarmultGenerator(H, tmp));
     R[round] = rct::scalarmultKey(R[round], INV_EIGHT);
 
     // PAPER LINES 21-22
@@ -1270,76 +1274,117 @@ bool bulletproof_VERIFY(const Bulletproof &proof)
   return bulletproof_VERIFY(proofs);
 }
 
-/* Given a set of values v (0..2^N-1) and masks gamma, construct a range proof */
-BigBulletproof bulletproof_PROVE(const std::vector<bulletproof_input> &bp)
+// one token's share of a BigBulletproof
+struct big_bulletproof_part
 {
-  CHECK_AND_ASSERT_THROW_MES(!bp.empty(), "bp vector is empty");
-  
-  std::vector<keyV> bigV;
-  keyV bigT1, bigT2, bigTau, bigT, bigA, bigS, bigMu;
-  std::vector<keyV> bigL, bigR;
-  keyV bigAP, bigBP;
-  keyV bigO;
-  
-  init_exponents();
-  
-  PERF_TIMER_UNIT(PROVE, 1000000);
-  
-  for (const bulletproof_input &tbp: bp) {
-    const rct::keyV &sv = std::get<0>(tbp);
-    const rct::keyV &gamma = std::get<1>(tbp);
-    const rct::key &omega = std::get<2>(tbp);
-  
-    CHECK_AND_ASSERT_THROW_MES(sv.size() == gamma.size(), "Incompatible sizes of sv and gamma");
-    CHECK_AND_ASSERT_THROW_MES(!sv.empty(), "sv is empty");
-    for (const rct::key &sve: sv)
-      CHECK_AND_ASSERT_THROW_MES(is_reduced(sve), "Invalid sv input");
-    for (const rct::key &g: gamma)
-      CHECK_AND_ASSERT_THROW_MES(is_reduced(g), "Invalid gamma input");
-  
-    constexpr size_t logN = 6; // log2(64)
-    constexpr size_t N = 1<<logN;
-    size_t M, logM;
-    for (logM = 0; (M = 1<<logM) <= maxM && M < sv.size(); ++logM);
-    CHECK_AND_ASSERT_THROW_MES(M <= maxM, "sv/gamma are too large");
-    const size_t logMN = logM + logN;
-    const size_t MN = M * N;
-  
-    rct::keyV V(sv.size());
-    rct::keyV aL(MN), aR(MN);
-    rct::key tmp;
-  
-    PERF_TIMER_START_BP(PROVE_v);
-    for (size_t i = 0; i < sv.size(); ++i)
-    {
-      addKeys2(V[i], gamma[i], sv[i], omega);
-      V[i] = scalarmultKey(V[i], INV_EIGHT);
-    }
-    PERF_TIMER_STOP(PROVE_v);
-  
-    PERF_TIMER_START_BP(PROVE_aLaR);
-    for (size_t j = 0; j < M; ++j)
+  rct::keyV V;
+  rct::key A, S, T1, T2, taux, mu;
+  rct::keyV L, R;
+  rct::key a, b, t;
+};
+
+// runs f and g on the threadpool and waits for both, rethrowing f's exception first
+static void run_in_parallel(const std::function<void()> &f, const std::function<void()> &g)
+{
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  tools::threadpool::waiter waiter;
+  std::exception_ptr ef, eg;
+  tpool.submit(&waiter, [&]() { try { f(); } catch (...) { ef = std::current_exception(); } });
+  try { g(); } catch (...) { eg = std::current_exception(); }
+  waiter.wait(&tpool);
+  if (ef)
+    std::rethrow_exception(ef);
+  if (eg)
+    std::rethrow_exception(eg);
+}
+
+// calls f(i) for i in [0, n) in contiguous chunks, one per thread, rethrowing the lowest index's exception
+static void parallel_for(size_t n, const std::function<void(size_t)> &f)
+{
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  const size_t chunks = std::min<size_t>(n, std::max<size_t>(1, tpool.get_max_concurrency()));
+  if (chunks <= 1)
+  {
+    for (size_t i = 0; i < n; ++i)
+      f(i);
+    return;
+  }
+  std::vector<std::exception_ptr> errors(chunks);
+  tools::threadpool::waiter waiter;
+  for (size_t c = 0; c < chunks; ++c)
+  {
+    const size_t begin = n * c / chunks, end = n * (c + 1) / chunks;
+    tpool.submit(&waiter, [&f, &errors, c, begin, end]() {
+      try
+      {
+        for (size_t i = begin; i < end; ++i)
+          f(i);
+      }
+      catch (...) { errors[c] = std::current_exception(); }
+    });
+  }
+  waiter.wait(&tpool);
+  for (const std::exception_ptr &e: errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+
+static void bulletproof_PROVE_part(const bulletproof_input &input, big_bulletproof_part &part)
+{
+  const rct::keyV &sv = std::get<0>(input);
+  const rct::keyV &gamma = std::get<1>(input);
+  const rct::key &omega = std::get<2>(input);
+
+  CHECK_AND_ASSERT_THROW_MES(sv.size() == gamma.size(), "Incompatible sizes of sv and gamma");
+  CHECK_AND_ASSERT_THROW_MES(!sv.empty(), "sv is empty");
+  for (const rct::key &sve: sv)
+    CHECK_AND_ASSERT_THROW_MES(is_reduced(sve), "Invalid sv input");
+  for (const rct::key &g: gamma)
+    CHECK_AND_ASSERT_THROW_MES(is_reduced(g), "Invalid gamma input");
+
+  constexpr size_t logN = 6; // log2(64)
+  constexpr size_t N = 1<<logN;
+  size_t M, logM;
+  for (logM = 0; (M = 1<<logM) <= maxM && M < sv.size(); ++logM);
+  CHECK_AND_ASSERT_THROW_MES(M <= maxM, "sv/gamma are too large");
+  const size_t logMN = logM + logN;
+  const size_t MN = M * N;
+
+  rct::keyV V(sv.size());
+  rct::keyV aL(MN), aR(MN);
+  rct::key tmp;
+
+  PERF_TIMER_START_BP(PROVE_v);
+  for (size_t i = 0; i < sv.size(); ++i)
+  {
+    addKeys2Generator(V[i], gamma[i], sv[i], omega);
+    V[i] = scalarmultKey(V[i], INV_EIGHT);
+  }
+  PERF_TIMER_STOP(PROVE_v);
+
+  PERF_TIMER_START_BP(PROVE_aLaR);
+  for (size_t j = 0; j < M; ++j)
+  {
+    for (size_t i = N; i-- > 0; )
     {
-      for (size_t i = N; i-- > 0; )
+      if (j >= sv.size())
       {
-        if (j >= sv.size())
-        {
-          aL[j*N+i] = rct::zero();
-        }
-        else if (sv[j][i/8] & (((uint64_t)1)<<(i%8)))
-        {
-          aL[j*N+i] = rct::identity();
-        }
-        else
-        {
-          aL[j*N+i] = rct::zero();
-        }
-        sc_sub(aR[j*N+i].bytes, aL[j*N+i].bytes, rct::identity().bytes);
+        aL[j*N+i] = rct::zero();
+      }
+      else if (sv[j][i/8] & (((uint64_t)1)<<(i%8)))
+      {
+        aL[j*N+i] = rct::identity();
+      }
+      else
+      {
+        aL[j*N+i] = rct::zero();
       }
+      sc_sub(aR[j*N+i].bytes, aL[j*N+i].bytes, rct::identity().bytes);
     }
-    PERF_TIMER_STOP(PROVE_aLaR);
-  
-    // DEBUG: Test to ensure this recovers the value
+  }
+  PERF_TIMER_STOP(PROVE_aLaR);
+
+  // DEBUG: Test to ensure this recovers the value
 #ifdef DEBUG_BP
     for (size_t j = 0; j < M; ++j)
   {
@@ -1358,122 +1403,122 @@ BigBulletproof bulletproof_PROVE(const std::vector<bulletproof_input> &bp)
     CHECK_AND_ASSERT_THROW_MES(test_aR == v_test, "test_aR failed");
   }
 #endif
-  
-  try_again:
-    rct::key hash_cache = rct::hash_to_scalar(V);
-  
-    PERF_TIMER_START_BP(PROVE_step1);
-    // PAPER LINES 38-39
-    rct::key alpha = rct::skGen();
-    rct::key ve = vector_exponent(aL, aR);
-    rct::key A;
-    rct::addKeys(A, ve, rct::scalarmultBase(alpha));
+
+try_again:
+  rct::key hash_cache = rct::hash_to_scalar(V);
+
+  PERF_TIMER_START_BP(PROVE_step1);
+  // PAPER LINES 38-39
+  // the two multiexps are independent, randomness is drawn beforehand
+  rct::key alpha = rct::skGen();
+  rct::keyV sL = rct::skvGen(MN), sR = rct::skvGen(MN);
+  rct::key rho = rct::skGen();
+  rct::key A, S;
+  run_in_parallel([&]() {
+    rct::addKeys(A, vector_exponent(aL, aR), rct::scalarmultBase(alpha));
     A = rct::scalarmultKey(A, INV_EIGHT);
-  
+  }, [&]() {
     // PAPER LINES 40-42
-    rct::keyV sL = rct::skvGen(MN), sR = rct::skvGen(MN);
-    rct::key rho = rct::skGen();
-    ve = vector_exponent(sL, sR);
-    rct::key S;
-    rct::addKeys(S, ve, rct::scalarmultBase(rho));
+    rct::addKeys(S, vector_exponent(sL, sR), rct::scalarmultBase(rho));
     S = rct::scalarmultKey(S, INV_EIGHT);
-  
-    // PAPER LINES 43-45
-    rct::key y = hash_cache_mash(hash_cache, A, S);
-    if (y == rct::zero())
-    {
-      PERF_TIMER_STOP(PROVE_step1);
-      MINFO("y is 0, trying again");
-      goto try_again;
-    }
-    rct::key z = hash_cache = rct::hash_to_scalar(y);
-    if (z == rct::zero())
-    {
-      PERF_TIMER_STOP(PROVE_step1);
-      MINFO("z is 0, trying again");
-      goto try_again;
-    }
-  
-    // Polynomial construction by coefficients
-    const auto zMN = vector_dup(z, MN);
-    rct::keyV l0 = vector_subtract(aL, zMN);
-    const rct::keyV &l1 = sL;
-  
-    // This computes the ugly sum/concatenation from PAPER LINE 65
-    rct::keyV zero_twos(MN);
-    const rct::keyV zpow = vector_powers(z, M+2);
-    for (size_t i = 0; i < MN; ++i)
+  });
+
+  // PAPER LINES 43-45
+  rct::key y = hash_cache_mash(hash_cache, A, S);
+  if (y == rct::zero())
+  {
+    PERF_TIMER_STOP(PROVE_step1);
+    MINFO("y is 0, trying again");
+    goto try_again;
+  }
+  rct::key z = hash_cache = rct::hash_to_scalar(y);
+  if (z == rct::zero())
+  {
+    PERF_TIMER_STOP(PROVE_step1);
+    MINFO("z is 0, trying again");
+    goto try_again;
+  }
+
+  // Polynomial construction by coefficients
+  const auto zMN = vector_dup(z, MN);
+  rct::keyV l0 = vector_subtract(aL, zMN);
+  const rct::keyV &l1 = sL;
+
+  // This computes the ugly sum/concatenation from PAPER LINE 65
+  rct::keyV zero_twos(MN);
+  const rct::keyV zpow = vector_powers(z, M+2);
+  for (size_t i = 0; i < MN; ++i)
+  {
+    zero_twos[i] = rct::zero();
+    for (size_t j = 1; j <= M; ++j)
     {
-      zero_twos[i] = rct::zero();
-      for (size_t j = 1; j <= M; ++j)
+      if (i >= (j-1)*N && i < j*N)
       {
-        if (i >= (j-1)*N && i < j*N)
-        {
-          CHECK_AND_ASSERT_THROW_MES(1+j < zpow.size(), "invalid zpow index");
-          CHECK_AND_ASSERT_THROW_MES(i-(j-1)*N < twoN.size(), "invalid twoN index");
-          sc_muladd(zero_twos[i].bytes, zpow[1+j].bytes, twoN[i-(j-1)*N].bytes, zero_twos[i].bytes);
-        }
+        CHECK_AND_ASSERT_THROW_MES(1+j < zpow.size(), "invalid zpow index");
+        CHECK_AND_ASSERT_THROW_MES(i-(j-1)*N < twoN.size(), "invalid twoN index");
+        sc_muladd(zero_twos[i].bytes, zpow[1+j].bytes, twoN[i-(j-1)*N].bytes, zero_twos[i].bytes);
       }
     }
-  
-    rct::keyV r0 = vector_add(aR, zMN);
-    const auto yMN = vector_powers(y, MN);
-    r0 = hadamard(r0, yMN);
-    r0 = vector_add(r0, zero_twos);
-    rct::keyV r1 = hadamard(yMN, sR);
-  
-    // Polynomial construction before PAPER LINE 46
-    rct::key t1_1 = inner_product(l0, r1);
-    rct::key t1_2 = inner_product(l1, r0);
-    rct::key t1;
-    sc_add(t1.bytes, t1_1.bytes, t1_2.bytes);
-    rct::key t2 = inner_product(l1, r1);
-  
-    PERF_TIMER_STOP(PROVE_step1);
-  
-    PERF_TIMER_START_BP(PROVE_step2);
-    // PAPER LINES 47-48
-    rct::key tau1 = rct::skGen(), tau2 = rct::skGen();
-  
-    key T1 = addKeys(scalarmultKey(omega, t1), scalarmultBase(tau1));
-    T1 = scalarmultKey(T1, INV_EIGHT);
-    key T2 = addKeys(scalarmultKey(omega, t2), scalarmultBase(tau2));
-    T2 = scalarmultKey(T2, INV_EIGHT);
-  
-    // PAPER LINES 49-51
-    rct::key x = hash_cache_mash(hash_cache, z, T1, T2);
-    if (x == rct::zero())
-    {
-      PERF_TIMER_STOP(PROVE_step2);
-      MINFO("x is 0, trying again");
-      goto try_again;
-    }
-  
-    // PAPER LINES 52-53
-    rct::key taux;
-    sc_mul(taux.bytes, tau1.bytes, x.bytes);
-    rct::key xsq;
-    sc_mul(xsq.bytes, x.bytes, x.bytes);
-    sc_muladd(taux.bytes, tau2.bytes, xsq.bytes, taux.bytes);
-    for (size_t j = 1; j <= sv.size(); ++j)
-    {
-      CHECK_AND_ASSERT_THROW_MES(j+1 < zpow.size(), "invalid zpow index");
-      sc_muladd(taux.bytes, zpow[j+1].bytes, gamma[j-1].bytes, taux.bytes);
-    }
-    rct::key mu;
-    sc_muladd(mu.bytes, x.bytes, rho.bytes, alpha.bytes);
-  
-    // PAPER LINES 54-57
-    rct::keyV l = l0;
-    l = vector_add(l, vector_scalar(l1, x));
-    rct::keyV r = r0;
-    r = vector_add(r, vector_scalar(r1, x));
+  }
+
+  rct::keyV r0 = vector_add(aR, zMN);
+  const auto yMN = vector_powers(y, MN);
+  r0 = hadamard(r0, yMN);
+  r0 = vector_add(r0, zero_twos);
+  rct::keyV r1 = hadamard(yMN, sR);
+
+  // Polynomial construction before PAPER LINE 46
+  rct::key t1_1 = inner_product(l0, r1);
+  rct::key t1_2 = inner_product(l1, r0);
+  rct::key t1;
+  sc_add(t1.bytes, t1_1.bytes, t1_2.bytes);
+  rct::key t2 = inner_product(l1, r1);
+
+  PERF_TIMER_STOP(PROVE_step1);
+
+  PERF_TIMER_START_BP(PROVE_step2);
+  // PAPER LINES 47-48
+  rct::key tau1 = rct::skGen(), tau2 = rct::skGen();
+
+  key T1 = addKeys(scalarmultGenerator(omega, t1), scalarmultBase(tau1));
+  T1 = scalarmultKey(T1, INV_EIGHT);
+  key T2 = addKeys(scalarmultGenerator(omega, t2), scalarmultBase(tau2));
+  T2 = scalarmultKey(T2, INV_EIGHT);
+
+  // PAPER LINES 49-51
+  rct::key x = hash_cache_mash(hash_cache, z, T1, T2);
+  if (x == rct::zero())
+  {
     PERF_TIMER_STOP(PROVE_step2);
-  
-    PERF_TIMER_START_BP(PROVE_step3);
-    rct::key t = inner_product(l, r);
-  
-    // DEBUG: Test if the l and r vectors match the polynomial forms
+    MINFO("x is 0, trying again");
+    goto try_again;
+  }
+
+  // PAPER LINES 52-53
+  rct::key taux;
+  sc_mul(taux.bytes, tau1.bytes, x.bytes);
+  rct::key xsq;
+  sc_mul(xsq.bytes, x.bytes, x.bytes);
+  sc_muladd(taux.bytes, tau2.bytes, xsq.bytes, taux.bytes);
+  for (size_t j = 1; j <= sv.size(); ++j)
+  {
+    CHECK_AND_ASSERT_THROW_MES(j+1 < zpow.size(), "invalid zpow index");
+    sc_muladd(taux.bytes, zpow[j+1].bytes, gamma[j-1].bytes, taux.bytes);
+  }
+  rct::key mu;
+  sc_muladd(mu.bytes, x.bytes, rho.bytes, alpha.bytes);
+
+  // PAPER LINES 54-57
+  rct::keyV l = l0;
+  l = vector_add(l, vector_scalar(l1, x));
+  rct::keyV r = r0;
+  r = vector_add(r, vector_scalar(r1, x));
+  PERF_TIMER_STOP(PROVE_step2);
+
+  PERF_TIMER_START_BP(PROVE_step3);
+  rct::key t = inner_product(l, r);
+
+  // DEBUG: Test if the l and r vectors match the polynomial forms
 #ifdef DEBUG_BP
     rct::key test_t;
   const rct::key t0 = inner_product(l0, r0);
@@ -1481,94 +1526,139 @@ BigBulletproof bulletproof_PROVE(const std::vector<bulletproof_input> &bp)
   sc_muladd(test_t.bytes, t2.bytes, xsq.bytes, test_t.bytes);
   CHECK_AND_ASSERT_THROW_MES(test_t == t, "test_t check failed");
 #endif
-  
-    // PAPER LINES 32-33
-    rct::key x_ip = hash_cache_mash(hash_cache, x, taux, mu, t);
-    if (x_ip == rct::zero())
-    {
-      PERF_TIMER_STOP(PROVE_step3);
-      MINFO("x_ip is 0, trying again");
-      goto try_again;
-    }
-  
-    // These are used in the inner product rounds
-    size_t nprime = MN;
-    rct::keyV Gprime(MN);
-    rct::keyV Hprime(MN);
-    rct::keyV aprime(MN);
-    rct::keyV bprime(MN);
-    const rct::key yinv = invert(y);
-    rct::key yinvpow = rct::identity();
-    for (size_t i = 0; i < MN; ++i)
-    {
-      Gprime[i] = Gi[i];
-      Hprime[i] = scalarmultKey(Hi_p3[i], yinvpow);
-      sc_mul(yinvpow.bytes, yinvpow.bytes, yinv.bytes);
-      aprime[i] = l[i];
-      bprime[i] = r[i];
-    }
-    rct::keyV L(logMN);
-    rct::keyV R(logMN);
-    int round = 0;
-    rct::keyV w(logMN); // this is the challenge x in the inner product protocol
+
+  // PAPER LINES 32-33
+  rct::key x_ip = hash_cache_mash(hash_cache, x, taux, mu, t);
+  if (x_ip == rct::zero())
+  {
     PERF_TIMER_STOP(PROVE_step3);
-  
-    PERF_TIMER_START_BP(PROVE_step4);
-    // PAPER LINE 13
-    while (nprime > 1)
-    {
-      // PAPER LINE 15
-      nprime /= 2;
-  
-      // PAPER LINES 16-17
-      rct::key cL = inner_product(slice(aprime, 0, nprime), slice(bprime, nprime, bprime.size()));
-      rct::key cR = inner_product(slice(aprime, nprime, aprime.size()), slice(bprime, 0, nprime));
-  
-      // PAPER LINES 18-19
+    MINFO("x_ip is 0, trying again");
+    goto try_again;
+  }
+
+  // These are used in the inner product rounds
+  size_t nprime = MN;
+  rct::keyV Gprime(MN);
+  rct::keyV Hprime(MN);
+  rct::keyV aprime(MN);
+  rct::keyV bprime(MN);
+  const rct::key yinv = invert(y);
+  rct::keyV yinvpow(MN);
+  yinvpow[0] = rct::identity();
+  for (size_t i = 1; i < MN; ++i)
+    sc_mul(yinvpow[i].bytes, yinvpow[i - 1].bytes, yinv.bytes);
+  parallel_for(MN, [&](size_t i) {
+    Hprime[i] = scalarmultKey(Hi_p3[i], yinvpow[i]);
+  });
+  for (size_t i = 0; i < MN; ++i)
+  {
+    Gprime[i] = Gi[i];
+    aprime[i] = l[i];
+    bprime[i] = r[i];
+  }
+  rct::keyV L(logMN);
+  rct::keyV R(logMN);
+  int round = 0;
+  rct::keyV w(logMN); // this is the challenge x in the inner product protocol
+  PERF_TIMER_STOP(PROVE_step3);
+
+  PERF_TIMER_START_BP(PROVE_step4);
+  // PAPER LINE 13
+  while (nprime > 1)
+  {
+    // PAPER LINE 15
+    nprime /= 2;
+
+    // PAPER LINES 16-17
+    rct::key cL = inner_product(slice(aprime, 0, nprime), slice(bprime, nprime, bprime.size()));
+    rct::key cR = inner_product(slice(aprime, nprime, aprime.size()), slice(bprime, 0, nprime));
+
+    // PAPER LINES 18-19
+    run_in_parallel([&]() {
+      rct::key tmpL;
       L[round] = vector_exponent_custom(slice(Gprime, nprime, Gprime.size()), slice(Hprime, 0, nprime), slice(aprime, 0, nprime), slice(bprime, nprime, bprime.size()));
-      sc_mul(tmp.bytes, cL.bytes, x_ip.bytes);
-      rct::addKeys(L[round], L[round], rct::scalarmultKey(H, tmp));
+      sc_mul(tmpL.bytes, cL.bytes, x_ip.bytes);
+      rct::addKeys(L[round], L[round], rct::scalarmultGenerator(H, tmpL));
       L[round] = rct::scalarmultKey(L[round], INV_EIGHT);
+    }, [&]() {
       R[round] = vector_exponent_custom(slice(Gprime, 0, nprime), slice(Hprime, nprime, Hprime.size()), slice(aprime, nprime, aprime.size()), slice(bprime, 0, nprime));
       sc_mul(tmp.bytes, cR.bytes, x_ip.bytes);
-      rct::addKeys(R[round], R[round], rct::scalarmultKey(H, tmp));
+      rct::addKeys(R[round], R[round], rct::scalarmultGenerator(H, tmp));
       R[round] = rct::scalarmultKey(R[round], INV_EIGHT);
-  
-      // PAPER LINES 21-22
-      w[round] = hash_cache_mash(hash_cache, L[round], R[round]);
-      if (w[round] == rct::zero())
-      {
-        PERF_TIMER_STOP(PROVE_step4);
-        MINFO("w[round] is 0, trying again");
-        goto try_again;
-      }
-  
-      // PAPER LINES 24-25
-      const rct::key winv = invert(w[round]);
-      Gprime = hadamard2(vector_scalar2(slice(Gprime, 0, nprime), winv), vector_scalar2(slice(Gprime, nprime, Gprime.size()), w[round]));
-      Hprime = hadamard2(vector_scalar2(slice(Hprime, 0, nprime), w[round]), vector_scalar2(slice(Hprime, nprime, Hprime.size()), winv));
-  
-      // PAPER LINES 28-29
-      aprime = vector_add(vector_scalar(slice(aprime, 0, nprime), w[round]), vector_scalar(slice(aprime, nprime, aprime.size()), winv));
-      bprime = vector_add(vector_scalar(slice(bprime, 0, nprime), winv), vector_scalar(slice(bprime, nprime, bprime.size()), w[round]));
-  
-      ++round;
+    });
+
+    // PAPER LINES 21-22
+    w[round] = hash_cache_mash(hash_cache, L[round], R[round]);
+    if (w[round] == rct::zero())
+    {
+      PERF_TIMER_STOP(PROVE_step4);
+      MINFO("w[round] is 0, trying again");
+      goto try_again;
     }
-    PERF_TIMER_STOP(PROVE_step4);
-  
-    bigV.push_back(V);
-    bigT1.push_back(T1);
-    bigT2.push_back(T2);
-    bigTau.push_back(taux);
-    bigT.push_back(t);
-    bigA.push_back(A);
-    bigS.push_back(S);
-    bigMu.push_back(mu);
-    bigL.push_back(L);
-    bigR.push_back(R);
-    bigAP.push_back(aprime[0]);
-    bigBP.push_back(bprime[0]);
-    bigO.push_back(omega);
+
+    // PAPER LINES 24-25
+    const rct::key winv = invert(w[round]);
+    Gprime = hadamard2(vector_scalar2(slice(Gprime, 0, nprime), winv), vector_scalar2(slice(Gprime, nprime, Gprime.size()), w[round]));
+    Hprime = hadamard2(vector_scalar2(slice(Hprime, 0, nprime), w[round]), vector_scalar2(slice(Hprime, nprime, Hprime.size()), winv));
+
+    // PAPER LINES 28-29
+    aprime = vector_add(vector_scalar(slice(aprime, 0, nprime), w[round]), vector_scalar(slice(aprime, nprime, aprime.size()), winv));
+    bprime = vector_add(vector_scalar(slice(bprime, 0, nprime), winv), vector_scalar(slice(bprime, nprime, bprime.size()), w[round]));
+
+    ++round;
+  }
+  PERF_TIMER_STOP(PROVE_step4);
+
+  part.V = V;
+  part.A = A;
+  part.S = S;
+  part.T1 = T1;
+  part.T2 = T2;
+  part.taux = taux;
+  part.mu = mu;
+  part.L = L;
+  part.R = R;
+  part.a = aprime[0];
+  part.b = bprime[0];
+  part.t = t;
+}
+
+/* Given a set of values v (0..2^N-1) and masks gamma, construct a range proof */
+BigBulletproof bulletproof_PROVE(const std::vector<bulletproof_input> &bp)
+{
+  CHECK_AND_ASSERT_THROW_MES(!bp.empty(), "bp vector is empty");
+
+  init_exponents();
+
+  PERF_TIMER_UNIT(PROVE, 1000000);
+
+  // each token's proof is independent, and lands at its input's index whatever the scheduling
+  std::vector<big_bulletproof_part> parts(bp.size());
+  parallel_for(bp.size(), [&](size_t i) {
+    bulletproof_PROVE_part(bp[i], parts[i]);
+  });
+
+  std::vector<keyV> bigV;
+  keyV bigT1, bigT2, bigTau, bigT, bigA, bigS, bigMu;
+  std::vector<keyV> bigL, bigR;
+  keyV bigAP, bigBP;
+  keyV bigO;
+  for (size_t i = 0; i < bp.size(); ++i)
+  {
+    big_bulletproof_part &part = parts[i];
+    bigV.push_back(std::move(part.V));
+    bigT1.push_back(part.T1);
+    bigT2.push_back(part.T2);
+    bigTau.push_back(part.taux);
+    bigT.push_back(part.t);
+    bigA.push_back(part.A);
+    bigS.push_back(part.S);
+    bigMu.push_back(part.mu);
+    bigL.push_back(std::move(part.L));
+    bigR.push_back(std::move(part.R));
+    bigAP.push_back(part.a);
+    bigBP.push_back(part.b);
+    bigO.push_back(std::get<2>(bp[i]));
   }
   
   // PAPER LINE 58 (with inclusions from PAPER LINE 8 and PAPER LINE 20)
@@ -1617,7 +1707,14 @@ bool bulletproof_VERIFY(const std::vector<const BigBulletproof*> &proofs)
   
   // Figure out which proof is the longest
   size_t max_length = 0;
-  for (const auto p: proofs) {
+  for (const BigBulletproof *p: proofs) {
+    const size_t n_tokens = p->V.size();
+    CHECK_AND_ASSERT_MES(n_tokens > 0, false, "Proof has no tokens");
+    CHECK_AND_ASSERT_MES(p->A.size() == n_tokens && p->S.size() == n_tokens && p->T1.size() == n_tokens &&
+                         p->T2.size() == n_tokens && p->taux.size() == n_tokens && p->mu.size() == n_tokens &&
+                         p->L.size() == n_tokens && p->R.size() == n_tokens && p->a.size() == n_tokens &&
+                         p->b.size() == n_tokens && p->t.size() == n_tokens && p->o.size() == n_tokens,
+                         false, "Mismatched token counts");
     for (const auto &l: p->L) {
       max_length = std::max(max_length, l.size());
     }
@@ -1630,22 +1727,22 @@ bool bulletproof_VERIFY(const std::vector<const BigBulletproof*> &proofs)
   
   key tmp{{}};
   
-  ge_p3 check1;
-  
-  for (size_t ind = 0; ind < proofs[0]->V.size(); ind++) {
-  
-    // setup weighted aggregates
-    rct::key Z0 = rct::identity();
-    rct::key z1 = rct::zero();
-    rct::key Z2 = rct::identity();
-    rct::key z3 = rct::zero();
-    rct::keyV z4(maxMN, rct::zero()), z5(maxMN, rct::zero());
-    rct::key Y2 = rct::identity(), Y3 = rct::identity(), Y4 = rct::identity();
-    rct::key y0 = rct::zero(), y1 = rct::zero();
-    
-    for (const BigBulletproof *p: proofs) {
-      const BigBulletproof &proof = *p;
-  
+  // setup weighted aggregates
+  // every token of every proof uses the same Gi/Hi, so all of them go into a
+  // single pair of checks below; only the value generator differs per token
+  rct::key Z0 = rct::identity();
+  rct::key z1 = rct::zero();
+  rct::key Z2 = rct::identity();
+  rct::key z3 = rct::zero();
+  rct::keyV z4(maxMN, rct::zero()), z5(maxMN, rct::zero());
+  rct::key Y2 = rct::identity(), Y3 = rct::identity(), Y4 = rct::identity();
+  rct::key y0 = rct::zero();
+  std::unordered_map<rct::key, rct::key> y1; // by value generator
+
+  for (const BigBulletproof *p: proofs) {
+    const BigBulletproof &proof = *p;
+
+    for (size_t ind = 0; ind < proof.V.size(); ind++) {
       const keyV &V = proof.V[ind];
       const key &A = proof.A[ind];
       const key &S = proof.S[ind];
@@ -1721,7 +1818,8 @@ bool bulletproof_VERIFY(const std::vector<const BigBulletproof*> &proofs)
       std::vector<MultiexpData> multiexp_data;
       multiexp_data.reserve(V.size());
       sc_sub(tmp.bytes, t.bytes, tmp.bytes);
-      sc_muladd(y1.bytes, tmp.bytes, weight.bytes, y1.bytes);
+      rct::key &y1o = y1.emplace(o, rct::zero()).first->second;
+      sc_muladd(y1o.bytes, tmp.bytes, weight.bytes, y1o.bytes);
       for (size_t j = 0; j < proof8_V.size(); j++) {
         multiexp_data.emplace_back(zpow[j + 2], proof8_V[j]);
       }
@@ -1822,44 +1920,44 @@ bool bulletproof_VERIFY(const std::vector<const BigBulletproof*> &proofs)
       sc_mul(tmp.bytes, tmp.bytes, x_ip.bytes);
       sc_muladd(z3.bytes, tmp.bytes, weight.bytes, z3.bytes);
       PERF_TIMER_STOP(VERIFY_line_26_new);
-      
-      ge_scalarmult_base(&check1, y0.bytes);
-      addKeys_acc_p3(&check1, y1, o);
-      sub_acc_p3(&check1, Y2);
-      sub_acc_p3(&check1, Y3);
-      sub_acc_p3(&check1, Y4);
-    }
-  
-    // now check all proofs at once
-    PERF_TIMER_START_BP(VERIFY_step2_check);
-  
-    if (!ge_p3_is_point_at_infinity(&check1)) {
-      MERROR("Verification failure at step 1");
-      return false;
-    }
-  
-    ge_p3 check2;
-    sc_sub(tmp.bytes, rct::zero().bytes, z1.bytes);
-    ge_double_scalarmult_base_vartime_p3(&check2, z3.bytes, &ge_p3_H, tmp.bytes);
-    add_acc_p3(&check2, Z0);
-    add_acc_p3(&check2, Z2);
-  
-    std::vector<MultiexpData> multiexp_data_2;
-    multiexp_data_2.reserve(2 * maxMN);
-    for (size_t i = 0; i < maxMN; ++i) {
-      sc_sub(tmp.bytes, rct::zero().bytes, z4[i].bytes);
-      multiexp_data_2.emplace_back(tmp, Gi_p3[i]);
-      sc_sub(tmp.bytes, rct::zero().bytes, z5[i].bytes);
-      multiexp_data_2.emplace_back(tmp, Hi_p3[i]);
-    }
-    add_acc_p3(&check2, multiexp(multiexp_data_2, true));
-    PERF_TIMER_STOP(VERIFY_step2_check);
-  
-    if (!ge_p3_is_point_at_infinity(&check2)) {
-      MERROR("Verification failure at step 2");
-      return false;
     }
-    
+  }
+
+  // now check all proofs at once
+  PERF_TIMER_START_BP(VERIFY_step2_check);
+
+  ge_p3 check1;
+  ge_scalarmult_base(&check1, y0.bytes);
+  for (const auto &e: y1)
+    add_acc_p3(&check1, rct::scalarmultGenerator(e.first, e.second));
+  sub_acc_p3(&check1, Y2);
+  sub_acc_p3(&check1, Y3);
+  sub_acc_p3(&check1, Y4);
+  if (!ge_p3_is_point_at_infinity(&check1)) {
+    MERROR("Verification failure at step 1");
+    return false;
+  }
+
+  ge_p3 check2;
+  sc_sub(tmp.bytes, rct::zero().bytes, z1.bytes);
+  ge_double_scalarmult_base_vartime_p3(&check2, z3.bytes, &ge_p3_H, tmp.bytes);
+  add_acc_p3(&check2, Z0);
+  add_acc_p3(&check2, Z2);
+
+  std::vector<MultiexpData> multiexp_data_2;
+  multiexp_data_2.reserve(2 * maxMN);
+  for (size_t i = 0; i < maxMN; ++i) {
+    sc_sub(tmp.bytes, rct::zero().bytes, z4[i].bytes);
+    multiexp_data_2.emplace_back(tmp, Gi_p3[i]);
+    sc_sub(tmp.bytes, rct::zero().bytes, z5[i].bytes);
+    multiexp_data_2.emplace_back(tmp, Hi_p3[i]);
+  }
+  add_acc_p3(&check2, multiexp(multiexp_data_2, true));
+  PERF_TIMER_STOP(VERIFY_step2_check);
+
+  if (!ge_p3_is_point_at_infinity(&check2)) {
+    MERROR("Verification failure at step 2");
+    return false;
   }
 
   PERF_TIMER_STOP(VERIFY);
@@ -1881,4 +1979,13 @@ bool bulletproof_VERIFY(const BigBulletproof &proof)
   return bulletproof_VERIFY(proofs);
 }
 
+size_t bulletproof_get_cache_size()
+{
+  size_t size = rct::getGeneratorTablesSize();
+  boost::lock_guard<boost::mutex> lock(init_mutex);
+  if (straus_HiGi_cache)
+    size += (sizeof(Hi)+sizeof(Hi_p3))*2 + straus_get_cache_size(straus_HiGi_cache) + pippenger_get_cache_size(pippenger_HiGi_cache);
+  return size;
+}
+
 }  // namespace rct
@@ -60,6 +60,9 @@ bool bulletproof_VERIFY(const BigBulletproof &proof);
 bool bulletproof_VERIFY(const std::vector<const BigBulletproof*> &proofs);
 bool bulletproof_VERIFY(const std::vector<BigBulletproof> &proofs);
 
+// memory held by the generator caches used for proving and verifying, in bytes
+size_t bulletproof_get_cache_size();
+
 }
 
 #endif
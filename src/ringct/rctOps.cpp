@@ -33,7 +33,12 @@
 
 #include "misc_log_ex.h"
 
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
 
 using namespace crypto;
 using namespace std;
@@ -45,6 +50,91 @@ using namespace std;
 
 namespace rct {
 
+    namespace {
+        const size_t max_generator_tables = 64; // about 30 kB each
+        const size_t max_token_points = 4096;
+
+        struct generator_table {
+            ge_precomp table[32][8];
+        };
+
+        std::shared_ptr<const generator_table> make_generator_table(const key &P) {
+            ge_p3 P3;
+            CHECK_AND_ASSERT_THROW_MES_L1(ge_frombytes_vartime(&P3, P.bytes) == 0, "ge_frombytes_vartime failed at "+boost::lexical_cast<std::string>(__LINE__));
+            std::shared_ptr<generator_table> table = std::make_shared<generator_table>();
+            ge_precomp_init(table->table, &P3);
+            return table;
+        }
+
+        const generator_table &get_H_table() {
+            static const std::shared_ptr<const generator_table> table = make_generator_table(H);
+            return *table;
+        }
+
+        // Token generators and their fixed-base tables. Tables are only built
+        // for points which came out of tokenIdToPoint, and the oldest ones are
+        // dropped when there are too many.
+        class generator_cache {
+        public:
+            key get_point(cryptonote::TokenId token_id) {
+                {
+                    boost::lock_guard<boost::mutex> lock(m_lock);
+                    const auto i = m_points.find(token_id);
+                    if (i != m_points.end())
+                        return i->second;
+                }
+                const key point = hashToPoint(smearBits(token_id));
+                boost::lock_guard<boost::mutex> lock(m_lock);
+                if (m_points.size() >= max_token_points) {
+                    m_points.clear();
+                    m_generators.clear();
+                }
+                m_points[token_id] = point;
+                m_generators.insert(point);
+                return point;
+            }
+
+            std::shared_ptr<const generator_table> get_table(const key &P) {
+                {
+                    boost::lock_guard<boost::mutex> lock(m_lock);
+                    const auto i = m_tables.find(P);
+                    if (i != m_tables.end())
+                        return i->second;
+                    if (m_generators.find(P) == m_generators.end())
+                        return nullptr;
+                }
+                std::shared_ptr<const generator_table> table = make_generator_table(P);
+                boost::lock_guard<boost::mutex> lock(m_lock);
+                const auto i = m_tables.insert(std::make_pair(P, table));
+                if (!i.second)
+                    return i.first->second;
+                m_order.push_back(P);
+                if (m_order.size() > max_generator_tables) {
+                    m_tables.erase(m_order.front());
+                    m_order.pop_front();
+                }
+                return table;
+            }
+
+            size_t get_tables_size() {
+                boost::lock_guard<boost::mutex> lock(m_lock);
+                return m_tables.size() * sizeof(generator_table);
+            }
+
+        private:
+            boost::mutex m_lock;
+            std::unordered_map<cryptonote::TokenId, key> m_points;
+            std::unordered_set<key> m_generators;
+            std::unordered_map<key, std::shared_ptr<const generator_table>> m_tables;
+            std::deque<key> m_order;
+        };
+
+        generator_cache &get_generator_cache() {
+            static generator_cache cache;
+            return cache;
+        }
+    }
+
     //Various key initialization functions
 
     //initializes a key matrix;
@@ -128,7 +218,7 @@ namespace rct {
 
     void gp_genC(key & C, const key & a, const key & o, xmr_amount amount)
     {
-      key bH = scalarmultKey(o, d2h(amount));
+      key bH = scalarmultGenerator(o, d2h(amount));
       addKeys1(C, a, bH);
     }
 
@@ -161,7 +251,7 @@ namespace rct {
 
     key gp_zeroCommit(xmr_amount amount, const key &o) {
       key am = d2h(amount);
-      key bH = scalarmultKey(o, am);
+      key bH = scalarmultGenerator(o, am);
       return addKeys(G, bH);
     }
 
@@ -177,7 +267,7 @@ namespace rct {
     key gp_commit(xmr_amount amount, const key &mask, const key &omega) {
       key c = scalarmultBase(mask);
       key am = d2h(amount);
-      key bH = scalarmultKey(omega, am);
+      key bH = scalarmultGenerator(omega, am);
       addKeys(c, c, bH);
       return c;
     }
@@ -230,13 +320,34 @@ namespace rct {
 
     //Computes aH where H= toPoint(cn_fast_hash(G)), G the basepoint
     key scalarmultH(const key & a) {
-        ge_p2 R;
-        ge_scalarmult(&R, a.bytes, &ge_p3_H);
+        ge_p3 R;
+        ge_scalarmult_precomp(&R, a.bytes, get_H_table().table);
         key aP;
-        ge_tobytes(aP.bytes, &R);
+        ge_p3_tobytes(aP.bytes, &R);
         return aP;
     }
 
+    //does a * P where P is H or a token generator, from a precomputed table
+    key scalarmultGenerator(const key &P, const key &a) {
+        if (a.bytes[31] > 127)
+            return scalarmultKey(P, a);
+        if (P == H)
+            return scalarmultH(a);
+        const std::shared_ptr<const generator_table> table = get_generator_cache().get_table(P);
+        if (!table)
+            return scalarmultKey(P, a);
+        ge_p3 R;
+        ge_scalarmult_precomp(&R, a.bytes, table->table);
+        key aP;
+        ge_p3_tobytes(aP.bytes, &R);
+        return aP;
+    }
+
+    //memory held by the precomputed generator tables
+    size_t getGeneratorTablesSize() {
+        return sizeof(get_H_table()) + get_generator_cache().get_tables_size();
+    }
+
     //Computes 8P
     key scalarmult8(const key & P) {
         ge_p3 p3;
@@ -314,6 +425,18 @@ namespace rct {
         ge_tobytes(aGbB.bytes, &rv);
     }
 
+    //aGbB = aG + bB as addKeys2, B being input after applying "precomp"
+    void addKeys2(key &aGbB, const key &a, const key &b, const ge_dsmp B) {
+        ge_p2 rv;
+        ge_double_scalarmult_base_precomp_vartime(&rv, b.bytes, B, a.bytes);
+        ge_tobytes(aGbB.bytes, &rv);
+    }
+
+    //aGbB = aG + bB as addKeys2, B being H or a token generator
+    void addKeys2Generator(key &aGbB, const key &a, const key &b, const key &B) {
+        addKeys1(aGbB, a, scalarmultGenerator(B, b));
+    }
+
     //Does some precomputation to make addKeys3 more efficient
     // input B a curve point and output a ge_dsmp which has precomputation applied
     void precomp(ge_dsmp rv, const key & B) {
@@ -543,7 +666,7 @@ namespace rct {
 
     key tokenIdToPoint(cryptonote::TokenId token_id)
     {
-        return token_id ? hashToPoint(smearBits(token_id)) : H;
+        return token_id ? get_generator_cache().get_point(token_id) : H;
     }
 
     keyV tokenIdToPoint(const std::vector<cryptonote::TokenId> &token_ids)
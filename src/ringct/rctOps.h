@@ -126,6 +126,10 @@ namespace rct {
     key scalarmultKey(const key &P, const key &a);
     //Computes aH where H= toPoint(cn_fast_hash(G)), G the basepoint
     key scalarmultH(const key & a);
+    //does a * P like scalarmultKey, but with a precomputed table if P is H or a token generator
+    key scalarmultGenerator(const key &P, const key &a);
+    //returns the memory used by the precomputed tables of H and the token generators, in bytes
+    size_t getGeneratorTablesSize();
     // multiplies a point by 8
     key scalarmult8(const key & P);
     // checks a is in the main subgroup (ie, not a small one)
@@ -141,6 +145,10 @@ namespace rct {
     void addKeys1(key &aGB, const key &a, const key & B);
     //aGbB = aG + bB where a, b are scalars, G is the basepoint and B is a point
     void addKeys2(key &aGbB, const key &a, const key &b, const key &B);
+    //aGbB = aG + bB like addKeys2, B must be input after applying "precomp"
+    void addKeys2(key &aGbB, const key &a, const key &b, const ge_dsmp B);
+    //aGbB = aG + bB like addKeys2, but with a precomputed table if B is H or a token generator
+    void addKeys2Generator(key &aGbB, const key &a, const key &b, const key &B);
     //Does some precomputation to make addKeys3 more efficient
     // input B a curve point and output a ge_dsmp which has precomputation applied
     void precomp(ge_dsmp rv, const key &B);
@@ -0,0 +1,136 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rctPointCache.h"
+#include "rctOps.h"
+#include "misc_log_ex.h"
+
+namespace rct {
+
+    point_cache::point_cache(size_t max_entries):
+        m_max_shard_entries((max_entries + SHARDS - 1) / SHARDS),
+        m_enabled(true),
+        m_hits(0),
+        m_misses(0)
+    {
+    }
+
+    std::shared_ptr<const point_cache_entry> point_cache::make_entry(const key &k, bool output_key) {
+        std::shared_ptr<point_cache_entry> e = std::make_shared<point_cache_entry>();
+        CHECK_AND_ASSERT_THROW_MES(ge_frombytes_vartime(&e->P, k.bytes) == 0, "ge_frombytes_vartime failed");
+        e->is_output_key = output_key;
+        e->Hp_valid = false;
+        if (output_key) {
+            ge_dsm_precomp(e->P_dsmp, &e->P);
+
+            //as hashToPoint, but keeping the point decompressed
+            ge_p2 point;
+            ge_p1p1 point2;
+            ge_p3 Hp;
+            key h = cn_fast_hash(k), Hpk;
+            ge_fromfe_frombytes_vartime(&point, h.bytes);
+            ge_mul8(&point2, &point);
+            ge_p1p1_to_p3(&Hp, &point2);
+            ge_p3_tobytes(Hpk.bytes, &Hp);
+            e->Hp_valid = !(Hpk == identity());
+            if (e->Hp_valid)
+                ge_dsm_precomp(e->Hp_dsmp, &Hp);
+        }
+        return e;
+    }
+
+    std::shared_ptr<const point_cache_entry> point_cache::get(const key &k, bool output_key) {
+        if (!m_enabled)
+            return make_entry(k, output_key);
+
+        shard &s = m_shards[k.bytes[0] % SHARDS];
+        {
+            boost::unique_lock<boost::mutex> lock(s.lock);
+            auto it = s.entries.find(k);
+            if (it != s.entries.end() && (it->second.first->is_output_key || !output_key)) {
+                s.lru.splice(s.lru.begin(), s.lru, it->second.second);
+                ++m_hits;
+                return it->second.first;
+            }
+        }
+
+        ++m_misses;
+        std::shared_ptr<const point_cache_entry> e = make_entry(k, output_key);
+
+        boost::unique_lock<boost::mutex> lock(s.lock);
+        auto it = s.entries.find(k);
+        if (it != s.entries.end()) {
+            //added by another thread meanwhile, or a commitment now seen as an output key
+            it->second.first = e;
+            s.lru.splice(s.lru.begin(), s.lru, it->second.second);
+            return e;
+        }
+        s.lru.push_front(k);
+        s.entries.insert(std::make_pair(k, std::make_pair(e, s.lru.begin())));
+        if (s.entries.size() > m_max_shard_entries) {
+            s.entries.erase(s.lru.back());
+            s.lru.pop_back();
+        }
+        return e;
+    }
+
+    void point_cache::set_enabled(bool enabled) {
+        m_enabled = enabled;
+        if (!enabled)
+            clear();
+    }
+
+    bool point_cache::is_enabled() const {
+        return m_enabled;
+    }
+
+    void point_cache::clear() {
+        for (shard &s: m_shards) {
+            boost::unique_lock<boost::mutex> lock(s.lock);
+            s.lru.clear();
+            s.entries.clear();
+        }
+    }
+
+    point_cache_stats point_cache::get_stats() const {
+        point_cache_stats stats;
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.entries = 0;
+        for (const shard &s: m_shards) {
+            boost::unique_lock<boost::mutex> lock(s.lock);
+            stats.entries += s.entries.size();
+        }
+        return stats;
+    }
+
+    point_cache &get_point_cache() {
+        static point_cache cache(RCT_POINT_CACHE_SIZE);
+        return cache;
+    }
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <boost/thread/mutex.hpp>
+
+#include "rctTypes.h"
+
+#define RCT_POINT_CACHE_SIZE 4096
+
+namespace rct {
+
+    //Decompressed forms of a ring member key
+    struct point_cache_entry {
+        ge_p3 P;
+        ge_dsmp P_dsmp;     //only set for output keys
+        ge_dsmp Hp_dsmp;    //precomp of hashToPoint(P), only set for output keys
+        bool is_output_key;
+        bool Hp_valid;      //false if hashToPoint(P) is the identity
+    };
+
+    struct point_cache_stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t entries;
+    };
+
+    /**
+     * @brief a bounded cache of decompressed ring member keys
+     *
+     * Popular outputs appear in many rings, so their keys and commitments
+     * get decompressed over and over during verification. Entries are
+     * split over shards by the first byte of the key, each with its own
+     * lock, and the least recently used entries of a shard are dropped
+     * when it is full. Only public data goes in, so lookups need not be
+     * constant time. Thread safe.
+     */
+    class point_cache {
+    public:
+        explicit point_cache(size_t max_entries);
+
+        /**
+         * @brief returns the decompressed form of a key
+         *
+         * Throws if the key is not a valid point.
+         *
+         * @param k the compressed key
+         * @param output_key if true, the precomputed tables for P and
+         *        hashToPoint(P) are also set, as used for key images
+         */
+        std::shared_ptr<const point_cache_entry> get(const key &k, bool output_key);
+
+        //when disabled, get computes every entry afresh and stores nothing
+        void set_enabled(bool enabled);
+        bool is_enabled() const;
+        void clear();
+        point_cache_stats get_stats() const;
+
+    private:
+        static const size_t SHARDS = 16;
+
+        struct shard {
+            mutable boost::mutex lock;
+            std::list<key> lru;
+            std::unordered_map<key, std::pair<std::shared_ptr<const point_cache_entry>, std::list<key>::iterator>> entries;
+        };
+
+        static std::shared_ptr<const point_cache_entry> make_entry(const key &k, bool output_key);
+
+        shard m_shards[SHARDS];
+        size_t m_max_shard_entries;
+        std::atomic<bool> m_enabled;
+        std::atomic<uint64_t> m_hits;
+        std::atomic<uint64_t> m_misses;
+    };
+
+    //the cache used by ring signature verification
+    point_cache &get_point_cache();
+}
@@ -32,6 +32,7 @@
 #include "rctSigs.h"
 
 #include "bulletproofs.h"
+#include "rctPointCache.h"
 #include "common/perf_timer.h"
 #include "common/threadpool.h"
 #include "common/util.h"
@@ -305,8 +306,9 @@ namespace rct {
         CHECK_AND_ASSERT_MES(sc_check(rv.cc.bytes) == 0, false, "Bad cc");
 
         size_t i = 0, j = 0, ii = 0;
-        key c,  L, R, Hi;
+        key c,  L, R;
         key c_old = copy(rv.cc);
+        point_cache &pcache = get_point_cache();
         vector<geDsmp> Ip(dsRows);
         for (i = 0 ; i < dsRows ; i++) {
             precomp(Ip[i].k, rv.II[i]);
@@ -318,10 +320,10 @@ namespace rct {
         while (i < cols) {
             sc_0(c.bytes);
             for (j = 0; j < dsRows; j++) {
-                addKeys2(L, rv.ss[i][j], c_old, pk[i][j]);
-                hashToPoint(Hi, pk[i][j]);
-                CHECK_AND_ASSERT_MES(!(Hi == rct::identity()), false, "Data hashed to point at infinity");
-                addKeys3(R, rv.ss[i][j], Hi, c_old, Ip[j].k);
+                std::shared_ptr<const point_cache_entry> P = pcache.get(pk[i][j], true);
+                CHECK_AND_ASSERT_MES(P->Hp_valid, false, "Data hashed to point at infinity");
+                addKeys2(L, rv.ss[i][j], c_old, P->P_dsmp);
+                addKeys3(R, rv.ss[i][j], P->Hp_dsmp, c_old, Ip[j].k);
                 toHash[3 * j + 1] = pk[i][j];
                 toHash[3 * j + 2] = L;
                 toHash[3 * j + 3] = R;
@@ -631,10 +633,20 @@ namespace rct {
             keyV tmp(rows + 1);
             size_t i;
             keyM M(cols, tmp);
+            //C is the same for every column, so decompress it once
+            ge_p3 C3;
+            CHECK_AND_ASSERT_MES(ge_frombytes_vartime(&C3, C.bytes) == 0, false, "ge_frombytes_vartime failed");
+            ge_cached Cc;
+            ge_p3_to_cached(&Cc, &C3);
+            point_cache &pcache = get_point_cache();
             //create the matrix to mg sig
             for (i = 0; i < cols; i++) {
                     M[i][0] = pubs[i].dest;
-                    subKeys(M[i][1], pubs[i].mask, C);
+                    ge_p1p1 t;
+                    ge_p3 t3;
+                    ge_sub(&t, &pcache.get(pubs[i].mask, false)->P, &Cc);
+                    ge_p1p1_to_p3(&t3, &t);
+                    ge_p3_tobytes(M[i][1].bytes, &t3);
             }
             //DP(C);
             return MLSAG_Ver(message, M, mg, rows);
@@ -1309,6 +1321,7 @@ rctSig genRctTgtx(std::function<key(const key &)>
           //check pseudoOuts vs Outs..
           if (!equalKeys(sumPseudoOuts, sumOutpks)) {
             LOG_PRINT_L1("Sum check failed");
+            waiter.wait(&tpool); // range proofs of earlier rctSigs may still be queued
             return false;
           }
 
@@ -1327,6 +1340,7 @@ rctSig genRctTgtx(std::function<key(const key &)>
         if (!proofs.empty() && !verBulletproof(proofs))
         {
           LOG_PRINT_L1("Aggregate range proof verified failed");
+          waiter.wait(&tpool);
           return false;
         }
 
@@ -1461,13 +1475,51 @@ rctSig genRctTgtx(std::function<key(const key &)>
       return verRctSemanticsSimple({&rv});
     }
 
-    //ver RingCT simple
-    //assumes only post-rct style inputs (at least for max anonymity)
-    bool verRctNonSemanticsSimple(const rctSig & rv) {
-      try
+    typedef bool (*batch_verifier)(const std::vector<const rctSig*> &rvv);
+
+    //rvv[begin, end) is known to contain at least one bad rctSig
+    static void bisectBadRctSemantics(batch_verifier verify, const std::vector<const rctSig*> &rvv, size_t begin, size_t end, std::vector<size_t> &bad)
+    {
+      if (end - begin == 1)
+      {
+        bad.push_back(begin);
+        return;
+      }
+      const size_t mid = begin + (end - begin) / 2;
+      if (verify(std::vector<const rctSig*>(rvv.begin() + begin, rvv.begin() + mid)))
       {
-        PERF_TIMER(verRctNonSemanticsSimple);
+        //the left half is good, so the bad one is on the right
+        bisectBadRctSemantics(verify, rvv, mid, end, bad);
+        return;
+      }
+      bisectBadRctSemantics(verify, rvv, begin, mid, bad);
+      if (!verify(std::vector<const rctSig*>(rvv.begin() + mid, rvv.begin() + end)))
+        bisectBadRctSemantics(verify, rvv, mid, end, bad);
+    }
 
+    static bool verRctSemanticsFindBad(batch_verifier verify, const std::vector<const rctSig*> &rvv, std::vector<size_t> &bad)
+    {
+      bad.clear();
+      if (rvv.empty() || verify(rvv))
+        return true;
+      bisectBadRctSemantics(verify, rvv, 0, rvv.size(), bad);
+      return false;
+    }
+
+    bool verRctSemanticsSimple(const std::vector<const rctSig*> &rvv, std::vector<size_t> &bad)
+    {
+      return verRctSemanticsFindBad(static_cast<batch_verifier>(&verRctSemanticsSimple), rvv, bad);
+    }
+
+    bool verRctSemanticsSimpleBig(const std::vector<const rctSig*> &rvv, std::vector<size_t> &bad)
+    {
+      return verRctSemanticsFindBad(static_cast<batch_verifier>(&verRctSemanticsSimpleBig), rvv, bad);
+    }
+
+    //checks the layout of a simple rctSig and gets the message its MGs sign
+    static bool prepareRctNonSemanticsSimple(const rctSig & rv, key &message) {
+      try
+      {
         CHECK_AND_ASSERT_MES(is_rct_simple(rv.type), false, "verRctNonSemanticsSimple called on non simple rctSig");
         const bool bulletproof = is_rct_bulletproof(rv.type);
         // semantics check is early, and mixRing/MGs aren't resolved yet
@@ -1475,33 +1527,9 @@ rctSig genRctTgtx(std::function<key(const key &)>
           CHECK_AND_ASSERT_MES(rv.p.pseudoOuts.size() == rv.mixRing.size(), false, "Mismatched sizes of rv.p.pseudoOuts and mixRing");
         else
           CHECK_AND_ASSERT_MES(rv.pseudoOuts.size() == rv.mixRing.size(), false, "Mismatched sizes of rv.pseudoOuts and mixRing");
+        CHECK_AND_ASSERT_MES(rv.p.MGs.size() == rv.mixRing.size(), false, "Mismatched sizes of rv.p.MGs and mixRing");
 
-        const size_t threads = std::max(rv.outPk.size(), rv.mixRing.size());
-
-        std::deque<bool> results(threads);
-        tools::threadpool& tpool = tools::threadpool::getInstance();
-        tools::threadpool::waiter waiter;
-
-        const keyV &pseudoOuts = bulletproof ? rv.p.pseudoOuts : rv.pseudoOuts;
-
-        const key message = get_pre_mlsag_hash(rv, hw::get_device("default"));
-
-        results.clear();
-        results.resize(rv.p.MGs.size());
-        for (size_t i = 0 ; i < rv.p.MGs.size() ; i++) {
-          tpool.submit(&waiter, [&, i] {
-              results[i] = verRctMGSimple(message, rv.p.MGs[i], rv.mixRing[i], pseudoOuts[i]);
-          });
-        }
-        waiter.wait(&tpool);
-
-        for (size_t i = 0; i < results.size(); ++i) {
-          if (!results[i]) {
-            LOG_PRINT_L1("verRctMGSimple failed for input " << i);
-            return false;
-          }
-        }
-
+        message = get_pre_mlsag_hash(rv, hw::get_device("default"));
         return true;
       }
       // we can get deep throws from ge_frombytes_vartime if input isn't valid
@@ -1517,6 +1545,73 @@ rctSig genRctTgtx(std::function<key(const key &)>
       }
     }
 
+    //ver RingCT simple
+    //assumes only post-rct style inputs (at least for max anonymity)
+    bool verRctNonSemanticsSimple(const rctSig & rv) {
+      std::vector<size_t> bad;
+      return verRctNonSemanticsSimple({&rv}, bad);
+    }
+
+    //ver RingCT simple, for the MGs of all inputs of several rctSigs at once
+    bool verRctNonSemanticsSimple(const std::vector<const rctSig*> &rvv, std::vector<size_t> &bad) {
+      PERF_TIMER(verRctNonSemanticsSimple);
+
+      tools::threadpool& tpool = tools::threadpool::getInstance();
+      tools::threadpool::waiter waiter;
+
+      // nothing may return once tasks are queued, as they use the locals below
+      bad.clear();
+      for (size_t n = 0; n < rvv.size(); ++n)
+        if (!rvv[n])
+          bad.push_back(n);
+      CHECK_AND_ASSERT_MES(bad.empty(), false, "rctSig pointer is NULL");
+
+      // the messages hash the whole rctSig, so they are worth spreading too
+      std::deque<bool> prepared(rvv.size());
+      keyV messages(rvv.size());
+      for (size_t n = 0; n < rvv.size(); ++n)
+        tpool.submit(&waiter, [&, n] { prepared[n] = prepareRctNonSemanticsSimple(*rvv[n], messages[n]); });
+      waiter.wait(&tpool);
+
+      // then every input of every rctSig goes to the pool on its own
+      std::vector<size_t> offsets(rvv.size() + 1, 0);
+      for (size_t n = 0; n < rvv.size(); ++n)
+        offsets[n + 1] = offsets[n] + (prepared[n] ? rvv[n]->p.MGs.size() : 0);
+      std::deque<bool> results(offsets.back());
+      for (size_t n = 0; n < rvv.size(); ++n)
+      {
+        if (!prepared[n])
+          continue;
+        const rctSig &rv = *rvv[n];
+        const keyV &pseudoOuts = is_rct_bulletproof(rv.type) ? rv.p.pseudoOuts : rv.pseudoOuts;
+        for (size_t i = 0; i < rv.p.MGs.size(); i++) {
+          tpool.submit(&waiter, [&, n, i] {
+              results[offsets[n] + i] = verRctMGSimple(messages[n], rv.p.MGs[i], rv.mixRing[i], pseudoOuts[i]);
+          });
+        }
+      }
+      waiter.wait(&tpool);
+
+      for (size_t n = 0; n < rvv.size(); ++n)
+      {
+        if (!prepared[n])
+        {
+          bad.push_back(n);
+          continue;
+        }
+        for (size_t i = offsets[n]; i < offsets[n + 1]; ++i)
+        {
+          if (!results[i])
+          {
+            LOG_PRINT_L1("verRctMGSimple failed for input " << i - offsets[n]);
+            bad.push_back(n);
+            break;
+          }
+        }
+      }
+      return bad.empty();
+    }
+
     //RingCT protocol
     //genRct:
     //   creates an rctSig with all data necessary to verify the rangeProofs and that the signer owns one of the
@@ -1543,7 +1638,7 @@ rctSig genRctTgtx(std::function<key(const key &)>
         key Ctmp;
         CHECK_AND_ASSERT_THROW_MES(sc_check(mask.bytes) == 0, "warning, bad ECDH mask");
         CHECK_AND_ASSERT_THROW_MES(sc_check(amount.bytes) == 0, "warning, bad ECDH amount");
-        addKeys2(Ctmp, mask, amount, H);
+        addKeys2Generator(Ctmp, mask, amount, H);
         DP("Ctmp");
         DP(Ctmp);
         if (equalKeys(C, Ctmp) == false) {
@@ -1575,7 +1670,7 @@ rctSig genRctTgtx(std::function<key(const key &)>
         key Ctmp;
         CHECK_AND_ASSERT_THROW_MES(sc_check(mask.bytes) == 0, "warning, bad ECDH mask");
         CHECK_AND_ASSERT_THROW_MES(sc_check(amount.bytes) == 0, "warning, bad ECDH amount");
-        addKeys2(Ctmp, mask, amount, omega);
+        addKeys2Generator(Ctmp, mask, amount, omega);
         DP("Ctmp");
         DP(Ctmp);
         if (equalKeys(C, Ctmp) == false) {
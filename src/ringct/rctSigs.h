@@ -174,7 +174,14 @@ namespace rct {
     bool verRctSemanticsSimple(const rctSig & rv);
     bool verRctSemanticsSimple(const std::vector<const rctSig*> &rv);
     bool verRctSemanticsSimpleBig(const std::vector<const rctSig*> &rv);
+    //batch verification which, on failure, finds the bad rctSigs by bisecting the batch,
+    //taking O(k log n) batch verifications for k bad ones among n. Their indices are returned in bad
+    bool verRctSemanticsSimple(const std::vector<const rctSig*> &rv, std::vector<size_t> &bad);
+    bool verRctSemanticsSimpleBig(const std::vector<const rctSig*> &rv, std::vector<size_t> &bad);
     bool verRctNonSemanticsSimple(const rctSig & rv);
+    //verifies the MGs of all inputs of all the rctSigs in parallel, rather than one rctSig after
+    //another. The indices of the rctSigs which fail are returned in bad
+    bool verRctNonSemanticsSimple(const std::vector<const rctSig*> &rv, std::vector<size_t> &bad);
     static inline bool verRctSimple(const rctSig & rv) { return verRctSemanticsSimple(rv) && verRctNonSemanticsSimple(rv); }
     xmr_amount decodeRct(const rctSig & rv, const key & sk, unsigned int i, key & mask, hw::device &hwdev);
     xmr_amount decodeRct(const rctSig & rv, const key & sk, unsigned int i, hw::device &hwdev);
@@ -45,6 +45,7 @@ using namespace epee;
 #include "misc_language.h"
 #include "storages/http_abstract_invoke.h"
 #include "crypto/hash.h"
+#include "ringct/bulletproofs.h"
 #include "rpc/rpc_args.h"
 #include "core_rpc_server_error_codes.h"
 #include "p2p/net_node.h"
@@ -210,6 +211,7 @@ namespace cryptonote
     }
     res.database_size = m_core.get_blockchain_storage().get_db().get_database_size();
     res.update_available = m_core.is_update_available();
+    res.generator_cache_size = rct::bulletproof_get_cache_size();
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -761,6 +763,7 @@ namespace cryptonote
 
     NOTIFY_NEW_TRANSACTIONS::request r;
     r.txs.push_back(tx_blob);
+    r.dandelionpp = true;
     m_core.get_protocol()->relay_transactions(r, fake_context);
     //TODO: make sure that tx has reached other nodes here, probably wait to receive reflections from other nodes
     res.status = CORE_RPC_STATUS_OK;
@@ -1719,6 +1722,7 @@ namespace cryptonote
     }
     res.database_size = m_core.get_blockchain_storage().get_db().get_database_size();
     res.update_available = m_core.is_update_available();
+    res.generator_cache_size = rct::bulletproof_get_cache_size();
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -2223,6 +2227,36 @@ namespace cryptonote
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_fee_rate_ladder(const COMMAND_RPC_GET_FEE_RATE_LADDER::request& req, COMMAND_RPC_GET_FEE_RATE_LADDER::response& res, epee::json_rpc::error& error_resp)
+  {
+    PERF_TIMER(on_get_fee_rate_ladder);
+    bool r;
+    if (use_bootstrap_daemon_if_necessary<COMMAND_RPC_GET_FEE_RATE_LADDER>(invoke_http_mode::JON_RPC, "get_fee_rate_ladder", req, res, r))
+      return r;
+
+    static const uint64_t max_blocks = 100;
+    if (req.blocks == 0 || req.blocks > max_blocks)
+    {
+      error_resp.code = CORE_RPC_ERROR_CODE_WRONG_PARAM;
+      error_resp.message = "blocks must be between 1 and " + std::to_string(max_blocks);
+      return false;
+    }
+
+    const Blockchain &blockchain = m_core.get_blockchain_storage();
+    res.base_fee = blockchain.get_dynamic_base_fee_estimate(10);
+    // the penalty free block weight, which miners fill before paying for growth
+    res.block_weight = blockchain.get_current_cumulative_block_weight_limit() / 2;
+    if (!m_core.get_txpool_fee_rate_ladder(res.block_weight, req.blocks, res.ladder, res.percentiles, res.txs_total, res.weight_total))
+    {
+      error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
+      error_resp.message = "Failed to get txpool fee rate ladder";
+      return false;
+    }
+
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_get_output_distribution(const COMMAND_RPC_GET_OUTPUT_DISTRIBUTION::request &req,
                                                    COMMAND_RPC_GET_OUTPUT_DISTRIBUTION::response      &res,
                                                    epee::json_rpc::error                              &error_resp)
@@ -51,7 +51,7 @@ namespace cryptonote
 // advance which version they will stop working with
 // Don't go over 32767 for any of these
 #define CORE_RPC_VERSION_MAJOR 2
-#define CORE_RPC_VERSION_MINOR 1
+#define CORE_RPC_VERSION_MINOR 4
 #define MAKE_CORE_RPC_VERSION(major,minor) (((major)<<16)|(minor))
 #define CORE_RPC_VERSION MAKE_CORE_RPC_VERSION(CORE_RPC_VERSION_MAJOR, CORE_RPC_VERSION_MINOR)
 
@@ -909,6 +909,7 @@ namespace cryptonote
       bool was_bootstrap_ever_used;
       uint64_t database_size;
       bool update_available;
+      uint64_t generator_cache_size;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(status)
@@ -943,6 +944,7 @@ namespace cryptonote
         KV_SERIALIZE(was_bootstrap_ever_used)
         KV_SERIALIZE(database_size)
         KV_SERIALIZE(update_available)
+        KV_SERIALIZE_OPT(generator_cache_size, (uint64_t)0)
       END_KV_SERIALIZE_MAP()
     };
   };
@@ -1595,6 +1597,63 @@ namespace cryptonote
     uint64_t time_in_pool;
   };
 
+  struct fee_rate_step
+  {
+    uint64_t blocks;
+    uint64_t fee_per_byte;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(blocks)
+      KV_SERIALIZE(fee_per_byte)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct fee_rate_percentile
+  {
+    uint32_t percentile;
+    uint64_t fee_per_byte;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(percentile)
+      KV_SERIALIZE(fee_per_byte)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct COMMAND_RPC_GET_FEE_RATE_LADDER
+  {
+    struct request
+    {
+      uint64_t blocks;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_OPT(blocks, (uint64_t)10)
+      END_KV_SERIALIZE_MAP()
+    };
+
+    struct response
+    {
+      std::string status;
+      uint64_t base_fee;
+      uint64_t block_weight;
+      uint64_t txs_total;
+      uint64_t weight_total;
+      std::vector<fee_rate_step> ladder;
+      std::vector<fee_rate_percentile> percentiles;
+      bool untrusted;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(status)
+        KV_SERIALIZE(base_fee)
+        KV_SERIALIZE(block_weight)
+        KV_SERIALIZE(txs_total)
+        KV_SERIALIZE(weight_total)
+        KV_SERIALIZE(ladder)
+        KV_SERIALIZE(percentiles)
+        KV_SERIALIZE(untrusted)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
   struct COMMAND_RPC_GET_TRANSACTION_POOL_BACKLOG
   {
     struct request
@@ -1643,8 +1702,10 @@ namespace cryptonote
     uint64_t histo_98pc;
     std::vector<txpool_histo> histo;
     uint32_t num_double_spends;
+    uint32_t revalidation_total;
+    uint32_t revalidation_checked;
 
-    txpool_stats(): bytes_total(0), bytes_min(0), bytes_max(0), bytes_med(0), fee_total(0), oldest(0), txs_total(0), num_failing(0), num_10m(0), num_not_relayed(0), histo_98pc(0), num_double_spends(0) {}
+    txpool_stats(): bytes_total(0), bytes_min(0), bytes_max(0), bytes_med(0), fee_total(0), oldest(0), txs_total(0), num_failing(0), num_10m(0), num_not_relayed(0), histo_98pc(0), num_double_spends(0), revalidation_total(0), revalidation_checked(0) {}
 
     BEGIN_KV_SERIALIZE_MAP()
       KV_SERIALIZE(bytes_total)
@@ -1660,6 +1721,8 @@ namespace cryptonote
       KV_SERIALIZE(histo_98pc)
       KV_SERIALIZE_CONTAINER_POD_AS_BLOB(histo)
       KV_SERIALIZE(num_double_spends)
+      KV_SERIALIZE(revalidation_total)
+      KV_SERIALIZE(revalidation_checked)
     END_KV_SERIALIZE_MAP()
   };
 
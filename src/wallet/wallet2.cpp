@@ -188,6 +188,29 @@ namespace
 
     return public_keys;
   }
+
+  // checks the proofs in chunks over the threadpool, setting good[i] for each
+  void check_tx_proofs_parallel(const std::vector<crypto::tx_proof_entry> &proofs, std::vector<int> &good)
+  {
+    good.resize(proofs.size());
+    tools::threadpool &tpool = tools::threadpool::getInstance();
+    const size_t n_chunks = std::min<size_t>(tpool.get_max_concurrency(), proofs.size());
+    if (n_chunks <= 1)
+    {
+      crypto::check_tx_proofs(proofs.data(), proofs.size(), good.data());
+      return;
+    }
+    tools::threadpool::waiter waiter;
+    for (size_t c = 0; c < n_chunks; ++c)
+    {
+      const size_t begin = proofs.size() * c / n_chunks;
+      const size_t end = proofs.size() * (c + 1) / n_chunks;
+      tpool.submit(&waiter, [&proofs, &good, begin, end]() {
+        crypto::check_tx_proofs(proofs.data() + begin, end - begin, good.data() + begin);
+      });
+    }
+    waiter.wait(&tpool);
+  }
 }
 
 namespace
@@ -2224,32 +2247,70 @@ void wallet2::process_parsed_blocks(uint64_t start_height, const std::vector<cry
     }
   };
 
-  for (auto &slot: tx_cache_data)
+  if (hwdev.get_type() == hw::device::SOFTWARE)
+  {
+    // the view secret key is the same for every tx pubkey, so derive them in batches
+    std::vector<wallet2::is_out_data*> iods;
+    for (auto &slot: tx_cache_data)
+    {
+      for (auto &iod: slot.primary)
+        iods.push_back(&iod);
+      for (auto &iod: slot.additional)
+        iods.push_back(&iod);
+    }
+    const size_t n_chunks = std::max<size_t>(1, std::min<size_t>(tpool.get_max_concurrency(), iods.size()));
+    for (size_t c = 0; c < n_chunks; ++c)
+    {
+      const size_t begin = iods.size() * c / n_chunks;
+      const size_t end = iods.size() * (c + 1) / n_chunks;
+      tpool.submit(&waiter, [&iods, &keys, begin, end]() {
+        std::vector<crypto::public_key> pkeys(end - begin);
+        std::vector<crypto::key_derivation> derivations(end - begin);
+        std::vector<int> good(end - begin);
+        for (size_t i = begin; i < end; ++i)
+          pkeys[i - begin] = iods[i]->pkey;
+        crypto::generate_key_derivations(pkeys.data(), pkeys.size(), keys.m_view_secret_key, derivations.data(), good.data());
+        for (size_t i = begin; i < end; ++i)
+        {
+          if (!good[i - begin])
+            MWARNING("Failed to generate key derivation from tx pubkey, skipping");
+          iods[i]->derivation = derivations[i - begin];
+        }
+      }, true);
+    }
+  }
+  else
   {
-    for (auto &iod: slot.primary)
-      tpool.submit(&waiter, [&gender, &iod]() { gender(iod); }, true);
-    for (auto &iod: slot.additional)
-      tpool.submit(&waiter, [&gender, &iod]() { gender(iod); }, true);
+    for (auto &slot: tx_cache_data)
+    {
+      for (auto &iod: slot.primary)
+        tpool.submit(&waiter, [&gender, &iod]() { gender(iod); }, true);
+      for (auto &iod: slot.additional)
+        tpool.submit(&waiter, [&gender, &iod]() { gender(iod); }, true);
+    }
   }
   waiter.wait(&tpool);
 
-  auto geniod = [&](const cryptonote::transaction &tx, size_t n_vouts, size_t txidx) {
-    for (size_t k = 0; k < n_vouts; ++k)
-    {
-      const auto &o = tx.vout[k];
-      if (o.target.type() == typeid(cryptonote::txout_to_key))
-      {
-        std::vector<crypto::key_derivation> additional_derivations;
-        for (const auto &iod: tx_cache_data[txidx].additional)
-          additional_derivations.push_back(iod.derivation);
-        const auto &key = boost::get<txout_to_key>(o.target).key;
-        for (size_t l = 0; l < tx_cache_data[txidx].primary.size(); ++l)
-        {
-          THROW_WALLET_EXCEPTION_IF(tx_cache_data[txidx].primary[l].received.size() != n_vouts,
-              error::wallet_internal_error, "Unexpected received array size");
-          tx_cache_data[txidx].primary[l].received[k] = is_out_to_acc_precomp(m_subaddresses, key, tx_cache_data[txidx].primary[l].derivation, additional_derivations, k, hwdev);
-          additional_derivations.clear();
-        }
+  // gather every output to check, so the subaddress spend keys can be derived in batches
+  std::vector<std::vector<crypto::key_derivation>> additional_derivations(tx_cache_data.size());
+  std::vector<cryptonote::out_to_acc_query> queries;
+  std::vector<boost::optional<cryptonote::subaddress_receive_info>*> received;
+  auto add_queries = [&](const cryptonote::transaction &tx, size_t n_vouts, size_t txidx) {
+    for (const auto &iod: tx_cache_data[txidx].additional)
+      additional_derivations[txidx].push_back(iod.derivation);
+    for (size_t l = 0; l < tx_cache_data[txidx].primary.size(); ++l)
+    {
+      auto &iod = tx_cache_data[txidx].primary[l];
+      THROW_WALLET_EXCEPTION_IF(iod.received.size() != n_vouts,
+          error::wallet_internal_error, "Unexpected received array size");
+      for (size_t k = 0; k < n_vouts; ++k)
+      {
+        const auto &o = tx.vout[k];
+        if (o.target.type() != typeid(cryptonote::txout_to_key))
+          continue;
+        // additional tx pubkeys are only tried along with the first shared one
+        queries.push_back({boost::get<txout_to_key>(o.target).key, &iod.derivation, l == 0 ? &additional_derivations[txidx] : nullptr, k});
+        received.push_back(&iod.received[k]);
       }
     }
   };
@@ -2261,18 +2322,31 @@ void wallet2::process_parsed_blocks(uint64_t start_height, const std::vector<cry
     {
       THROW_WALLET_EXCEPTION_IF(txidx >= tx_cache_data.size(), error::wallet_internal_error, "txidx out of range");
       const size_t n_vouts = m_refresh_type == RefreshType::RefreshOptimizeCoinbase ? 1 : parsed_blocks[i].block.miner_tx.vout.size();
-      tpool.submit(&waiter, [&, i, txidx](){ geniod(parsed_blocks[i].block.miner_tx, n_vouts, txidx); }, true);
+      add_queries(parsed_blocks[i].block.miner_tx, n_vouts, txidx);
     }
     ++txidx;
     for (size_t j = 0; j < parsed_blocks[i].txes.size(); ++j)
     {
       THROW_WALLET_EXCEPTION_IF(txidx >= tx_cache_data.size(), error::wallet_internal_error, "txidx out of range");
-      tpool.submit(&waiter, [&, i, j, txidx](){ geniod(parsed_blocks[i].txes[j], parsed_blocks[i].txes[j].vout.size(), txidx); }, true);
+      add_queries(parsed_blocks[i].txes[j], parsed_blocks[i].txes[j].vout.size(), txidx);
       ++txidx;
     }
   }
   THROW_WALLET_EXCEPTION_IF(txidx != tx_cache_data.size(), error::wallet_internal_error, "txidx did not reach expected value");
+
+  std::vector<boost::optional<cryptonote::subaddress_receive_info>> results(queries.size());
+  const size_t n_chunks = std::max<size_t>(1, std::min<size_t>(tpool.get_max_concurrency(), queries.size()));
+  for (size_t c = 0; c < n_chunks; ++c)
+  {
+    const size_t begin = queries.size() * c / n_chunks;
+    const size_t end = queries.size() * (c + 1) / n_chunks;
+    tpool.submit(&waiter, [&, begin, end]() {
+      is_out_to_acc_precomp_batch(m_subaddresses, queries.data() + begin, end - begin, results.data() + begin, hwdev);
+    }, true);
+  }
   waiter.wait(&tpool);
+  for (size_t i = 0; i < queries.size(); ++i)
+    *received[i] = std::move(results[i]);
   hwdev.set_mode(hw::device::NONE);
 
   size_t tx_cache_data_offset = 0;
@@ -11409,34 +11483,22 @@ bool wallet2::check_tx_proof(const crypto::hash &txid, const cryptonote::account
   crypto::hash prefix_hash;
   crypto::cn_fast_hash(prefix_data.data(), prefix_data.size(), prefix_hash);
 
-  // check signature
-  std::vector<int> good_signature(num_sigs, 0);
-  if (is_out)
-  {
-    good_signature[0] = is_subaddress ?
-      crypto::check_tx_proof(prefix_hash, tx_pub_key, address.m_view_public_key, address.m_spend_public_key, shared_secret[0], sig[0]) :
-      crypto::check_tx_proof(prefix_hash, tx_pub_key, address.m_view_public_key, boost::none, shared_secret[0], sig[0]);
-
-    for (size_t i = 0; i < additional_tx_pub_keys.size(); ++i)
-    {
-      good_signature[i + 1] = is_subaddress ?
-        crypto::check_tx_proof(prefix_hash, additional_tx_pub_keys[i], address.m_view_public_key, address.m_spend_public_key, shared_secret[i + 1], sig[i + 1]) :
-        crypto::check_tx_proof(prefix_hash, additional_tx_pub_keys[i], address.m_view_public_key, boost::none, shared_secret[i + 1], sig[i + 1]);
-    }
-  }
-  else
+  // check signatures, all against the same address
+  std::vector<crypto::tx_proof_entry> proofs(num_sigs);
+  for (size_t i = 0; i < num_sigs; ++i)
   {
-    good_signature[0] = is_subaddress ?
-      crypto::check_tx_proof(prefix_hash, address.m_view_public_key, tx_pub_key, address.m_spend_public_key, shared_secret[0], sig[0]) :
-      crypto::check_tx_proof(prefix_hash, address.m_view_public_key, tx_pub_key, boost::none, shared_secret[0], sig[0]);
-
-    for (size_t i = 0; i < additional_tx_pub_keys.size(); ++i)
-    {
-      good_signature[i + 1] = is_subaddress ?
-        crypto::check_tx_proof(prefix_hash, address.m_view_public_key, additional_tx_pub_keys[i], address.m_spend_public_key, shared_secret[i + 1], sig[i + 1]) :
-        crypto::check_tx_proof(prefix_hash, address.m_view_public_key, additional_tx_pub_keys[i], boost::none, shared_secret[i + 1], sig[i + 1]);
-    }
+    const crypto::public_key &R = i == 0 ? tx_pub_key : additional_tx_pub_keys[i - 1];
+    crypto::tx_proof_entry &proof = proofs[i];
+    proof.prefix_hash = prefix_hash;
+    proof.R = is_out ? R : address.m_view_public_key;
+    proof.A = is_out ? address.m_view_public_key : R;
+    if (is_subaddress)
+      proof.B = address.m_spend_public_key;
+    proof.D = shared_secret[i];
+    proof.sig = sig[i];
   }
+  std::vector<int> good_signature;
+  check_tx_proofs_parallel(proofs, good_signature);
 
   if (std::any_of(good_signature.begin(), good_signature.end(), [](int i) { return i > 0; }))
   {
@@ -11633,7 +11695,8 @@ bool wallet2::check_reserve_proof(const cryptonote::account_public_address &addr
   THROW_WALLET_EXCEPTION_IF(!ok || kispent_res.spent_status.size() != proofs.size(),
     error::wallet_internal_error, "Failed to get key image spent status from daemon");
 
-  total = spent = 0;
+  std::vector<cryptonote::transaction> txs(proofs.size());
+  std::vector<crypto::tx_proof_entry> shared_secret_proofs(proofs.size());
   for (size_t i = 0; i < proofs.size(); ++i)
   {
     const reserve_proof_entry& proof = proofs[i];
@@ -11644,27 +11707,50 @@ bool wallet2::check_reserve_proof(const cryptonote::account_public_address &addr
     THROW_WALLET_EXCEPTION_IF(!ok, error::wallet_internal_error, "Failed to parse transaction from daemon");
 
     crypto::hash tx_hash, tx_prefix_hash;
-    cryptonote::transaction tx;
+    cryptonote::transaction &tx = txs[i];
     THROW_WALLET_EXCEPTION_IF(!cryptonote::parse_and_validate_tx_from_blob(tx_data, tx, tx_hash, tx_prefix_hash), error::wallet_internal_error,
       "Failed to validate transaction from daemon");
     THROW_WALLET_EXCEPTION_IF(tx_hash != proof.txid, error::wallet_internal_error, "Failed to get the right transaction from daemon");
 
     THROW_WALLET_EXCEPTION_IF(proof.index_in_tx >= tx.vout.size(), error::wallet_internal_error, "index_in_tx is out of bound");
 
-    const cryptonote::txout_to_key* const out_key = boost::get<cryptonote::txout_to_key>(std::addressof(tx.vout[proof.index_in_tx].target));
-    THROW_WALLET_EXCEPTION_IF(!out_key, error::wallet_internal_error, "Output key wasn't found")
-
     // get tx pub key
     const crypto::public_key tx_pub_key = get_tx_pub_key_from_extra(tx);
     THROW_WALLET_EXCEPTION_IF(tx_pub_key == crypto::NullKey::p(), error::wallet_internal_error, "The tx public key isn't found");
-    const std::vector<crypto::public_key> additional_tx_pub_keys = get_additional_tx_pub_keys_from_extra(tx);
 
-    // check singature for shared secret
-    ok = crypto::check_tx_proof(prefix_hash, address.m_view_public_key, tx_pub_key, boost::none, proof.shared_secret, proof.shared_secret_sig);
-    if (!ok && additional_tx_pub_keys.size() == tx.vout.size())
-      ok = crypto::check_tx_proof(prefix_hash, address.m_view_public_key, additional_tx_pub_keys[proof.index_in_tx], boost::none, proof.shared_secret, proof.shared_secret_sig);
+    crypto::tx_proof_entry &shared_secret_proof = shared_secret_proofs[i];
+    shared_secret_proof.prefix_hash = prefix_hash;
+    shared_secret_proof.R = address.m_view_public_key;
+    shared_secret_proof.A = tx_pub_key;
+    shared_secret_proof.D = proof.shared_secret;
+    shared_secret_proof.sig = proof.shared_secret_sig;
+  }
+
+  // check signatures for shared secrets, all at once, then against the additional tx pub keys for those which failed
+  std::vector<int> good_shared_secret;
+  check_tx_proofs_parallel(shared_secret_proofs, good_shared_secret);
+
+  total = spent = 0;
+  for (size_t i = 0; i < proofs.size(); ++i)
+  {
+    const reserve_proof_entry& proof = proofs[i];
+    const cryptonote::transaction &tx = txs[i];
+
+    const cryptonote::txout_to_key* const out_key = boost::get<cryptonote::txout_to_key>(std::addressof(tx.vout[proof.index_in_tx].target));
+    THROW_WALLET_EXCEPTION_IF(!out_key, error::wallet_internal_error, "Output key wasn't found")
+
+    ok = good_shared_secret[i];
     if (!ok)
+    {
+      const std::vector<crypto::public_key> additional_tx_pub_keys = get_additional_tx_pub_keys_from_extra(tx);
+      if (additional_tx_pub_keys.size() == tx.vout.size())
+        ok = crypto::check_tx_proof(prefix_hash, address.m_view_public_key, additional_tx_pub_keys[proof.index_in_tx], boost::none, proof.shared_secret, proof.shared_secret_sig);
+    }
+    if (!ok)
+    {
+      MERROR("Bad shared secret signature in reserve proof entry " << i << ", txid " << proof.txid);
       return false;
+    }
 
     // check signature for key image
     const std::vector<const crypto::public_key*> pubs = { &out_key->key };
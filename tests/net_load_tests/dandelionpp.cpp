@@ -0,0 +1,478 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Deterministic simulation of Dandelion++ transaction relay: nodes run the
+// same routing code as the daemon, wired together by an in-memory network
+// on a simulated clock, so runs are fast and reproducible.
+
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include <boost/uuid/nil_generator.hpp>
+
+#include "gtest/gtest.h"
+
+#include "common/util.h"
+#include "misc_log_ex.h"
+#include "cryptonote_config.h"
+#include "cryptonote_protocol/dandelionpp.h"
+
+namespace
+{
+  typedef boost::uuids::uuid connection_id;
+
+  const uint64_t idle_interval_ms = 1000; // as the daemon's idle callback
+  const uint64_t epoch_ms = DANDELIONPP_EPOCH * 1000;
+  const uint64_t embargo_ms = DANDELIONPP_EMBARGO_AVERAGE * 1000;
+
+  // how a node is known to its peers, nil being reserved for the node itself
+  connection_id make_connection_id(size_t node)
+  {
+    connection_id id = boost::uuids::nil_uuid();
+    const uint64_t n = node + 1;
+    memcpy(id.data, &n, sizeof(n));
+    return id;
+  }
+
+  size_t get_node(const connection_id &id)
+  {
+    uint64_t n;
+    memcpy(&n, id.data, sizeof(n));
+    return n - 1;
+  }
+
+  cryptonote::blobdata make_tx(size_t n)
+  {
+    return "tx " + std::to_string(n) + std::string(100, 'x');
+  }
+
+  struct network_config
+  {
+    size_t nodes = 30;
+    size_t outgoing = 4;
+    size_t stems = DANDELIONPP_STEMS;
+    unsigned fluff_probability = DANDELIONPP_FLUFF_PROBABILITY;
+    uint64_t fluff_interval_ms = DANDELIONPP_FLUFF_INTERVAL;
+    uint64_t seed = 0;
+  };
+
+  class network
+  {
+  public:
+    explicit network(const network_config &config):
+      m_rng(config.seed),
+      m_now_ms(0),
+      m_next_idle_ms(0),
+      m_messages(0),
+      m_stem_messages(0),
+      m_tx_sends(0)
+    {
+      for (size_t i = 0; i < config.nodes; ++i)
+      {
+        m_nodes.emplace_back(new node(config.seed + i));
+        m_nodes.back()->relay.set_config(config.stems, config.fluff_probability, epoch_ms, embargo_ms, config.fluff_interval_ms);
+      }
+      for (size_t i = 0; i < config.nodes; ++i)
+      {
+        while (m_nodes[i]->outgoing.size() < config.outgoing)
+        {
+          const size_t peer = m_rng() % config.nodes;
+          if (peer == i || m_nodes[i]->peers.count(peer))
+            continue;
+          m_nodes[i]->outgoing.push_back(peer);
+          m_nodes[i]->peers.insert(peer);
+          m_nodes[peer]->peers.insert(i);
+        }
+      }
+    }
+
+    //! submits a transaction to a node, as a wallet would
+    void add_tx(size_t n, const cryptonote::blobdata &tx)
+    {
+      m_nodes[n]->txs.insert(std::make_pair(tx, m_now_ms));
+      relay(n, boost::uuids::nil_uuid(), true, {tx});
+    }
+
+    //! makes a node drop stem transactions instead of forwarding them
+    void set_black_hole(size_t n) { m_nodes[n]->black_hole = true; }
+
+    void run_until(uint64_t end_ms)
+    {
+      while (true)
+      {
+        const uint64_t next_message_ms = m_in_flight.empty() ? end_ms + 1 : m_in_flight.begin()->first;
+        const uint64_t next_ms = std::min(next_message_ms, m_next_idle_ms);
+        if (next_ms > end_ms)
+          break;
+        m_now_ms = next_ms;
+        if (next_ms == next_message_ms)
+        {
+          const message msg = std::move(m_in_flight.begin()->second);
+          m_in_flight.erase(m_in_flight.begin());
+          receive(msg);
+        }
+        else
+        {
+          for (size_t n = 0; n < m_nodes.size(); ++n)
+            on_idle(n);
+          m_next_idle_ms += idle_interval_ms;
+        }
+      }
+      m_now_ms = end_ms;
+    }
+
+    uint64_t now() const { return m_now_ms; }
+    size_t get_node_count() const { return m_nodes.size(); }
+    size_t get_message_count() const { return m_messages; }
+    size_t get_stem_message_count() const { return m_stem_messages; }
+    size_t get_tx_send_count() const { return m_tx_sends; }
+
+    size_t count_nodes_with(const cryptonote::blobdata &tx) const
+    {
+      size_t count = 0;
+      for (const auto &n: m_nodes)
+        count += n->txs.count(tx);
+      return count;
+    }
+
+    //! when each node first saw a transaction, or -1
+    std::vector<int64_t> get_arrival_times(const cryptonote::blobdata &tx) const
+    {
+      std::vector<int64_t> times;
+      for (const auto &n: m_nodes)
+      {
+        const auto i = n->txs.find(tx);
+        times.push_back(i == n->txs.end() ? -1 : (int64_t)i->second);
+      }
+      return times;
+    }
+
+    size_t get_embargoed_count() const
+    {
+      size_t count = 0;
+      for (const auto &n: m_nodes)
+        count += n->relay.get_embargoed_count();
+      return count;
+    }
+
+  private:
+    struct node
+    {
+      explicit node(uint64_t seed): relay(seed), black_hole(false) {}
+
+      cryptonote::dandelionpp_relay relay;
+      std::vector<size_t> outgoing;
+      std::set<size_t> peers;
+      std::map<cryptonote::blobdata, uint64_t> txs; // the pool, with arrival times
+      bool black_hole;
+    };
+
+    struct message
+    {
+      size_t from;
+      size_t to;
+      bool stem;
+      std::vector<cryptonote::blobdata> txs;
+    };
+
+    void send(size_t from, size_t to, bool stem, std::vector<cryptonote::blobdata> txs)
+    {
+      ++m_messages;
+      if (stem)
+        ++m_stem_messages;
+      m_tx_sends += txs.size();
+      const uint64_t latency_ms = 50 + m_rng() % 100;
+      m_in_flight.insert(std::make_pair(m_now_ms + latency_ms, message{from, to, stem, std::move(txs)}));
+    }
+
+    // mirrors t_cryptonote_protocol_handler::handle_notify_new_transactions
+    void receive(const message &msg)
+    {
+      node &n = *m_nodes[msg.to];
+      if (msg.stem && n.black_hole)
+        return;
+      if (!msg.stem)
+        for (const cryptonote::blobdata &tx: msg.txs)
+          n.relay.on_fluff_seen(tx);
+
+      std::vector<cryptonote::blobdata> new_txs;
+      for (const cryptonote::blobdata &tx: msg.txs)
+        if (n.txs.insert(std::make_pair(tx, m_now_ms)).second)
+          new_txs.push_back(tx);
+      if (!new_txs.empty())
+        relay(msg.to, make_connection_id(msg.from), msg.stem, new_txs);
+    }
+
+    // mirrors t_cryptonote_protocol_handler::relay_transactions
+    void relay(size_t n, const connection_id &from, bool stem, const std::vector<cryptonote::blobdata> &txs)
+    {
+      cryptonote::dandelionpp_relay &relay = m_nodes[n]->relay;
+      std::map<connection_id, std::vector<cryptonote::blobdata>> stems;
+      for (const cryptonote::blobdata &tx: txs)
+      {
+        connection_id to;
+        if (stem && relay.route_stem(from, tx, to, m_now_ms))
+          stems[to].push_back(tx);
+        else
+          relay.queue_fluff(tx, from);
+      }
+      for (auto &s: stems)
+        send(n, get_node(s.first), true, std::move(s.second));
+      flush_fluff_batch(n);
+    }
+
+    // mirrors t_cryptonote_protocol_handler::flush_fluff_batch
+    void flush_fluff_batch(size_t n)
+    {
+      std::vector<cryptonote::blobdata> txs;
+      std::vector<connection_id> sources;
+      if (!m_nodes[n]->relay.take_fluff_batch(txs, sources, m_now_ms))
+        return;
+      for (size_t peer: m_nodes[n]->peers)
+      {
+        std::vector<cryptonote::blobdata> peer_txs;
+        for (size_t i = 0; i < txs.size(); ++i)
+          if (sources[i] != make_connection_id(peer))
+            peer_txs.push_back(txs[i]);
+        if (!peer_txs.empty())
+          send(n, peer, false, std::move(peer_txs));
+      }
+    }
+
+    // mirrors t_cryptonote_protocol_handler::update_tx_relay
+    void on_idle(size_t n)
+    {
+      std::vector<connection_id> outgoing;
+      for (size_t peer: m_nodes[n]->outgoing)
+        outgoing.push_back(make_connection_id(peer));
+      m_nodes[n]->relay.update_peers(outgoing, m_now_ms);
+      m_nodes[n]->relay.check_embargoes(m_now_ms);
+      flush_fluff_batch(n);
+    }
+
+    std::mt19937_64 m_rng;
+    std::vector<std::unique_ptr<node>> m_nodes;
+    std::multimap<uint64_t, message> m_in_flight;
+    uint64_t m_now_ms;
+    uint64_t m_next_idle_ms;
+    size_t m_messages;
+    size_t m_stem_messages;
+    size_t m_tx_sends;
+  };
+
+  // submits txes one after the other at random nodes, starting once stem peers are known
+  std::vector<cryptonote::blobdata> add_txes(network &net, size_t count, uint64_t interval_ms)
+  {
+    std::vector<cryptonote::blobdata> txs;
+    std::mt19937_64 rng(count);
+    net.run_until(net.now() + 2 * idle_interval_ms);
+    for (size_t i = 0; i < count; ++i)
+    {
+      txs.push_back(make_tx(i));
+      net.add_tx(rng() % net.get_node_count(), txs.back());
+      net.run_until(net.now() + interval_ms);
+    }
+    return txs;
+  }
+}
+
+TEST(dandelionpp, routes_to_one_stem_per_source)
+{
+  cryptonote::dandelionpp_relay relay(1);
+  relay.set_config(2, 0, epoch_ms, embargo_ms, 0);
+  const std::vector<connection_id> outgoing = {make_connection_id(1), make_connection_id(2), make_connection_id(3)};
+  relay.update_peers(outgoing, 1);
+
+  std::set<connection_id> stems;
+  for (size_t source = 10; source < 30; ++source)
+  {
+    connection_id first, to;
+    ASSERT_TRUE(relay.route_stem(make_connection_id(source), make_tx(source), first, 1));
+    for (size_t i = 0; i < 5; ++i)
+    {
+      ASSERT_TRUE(relay.route_stem(make_connection_id(source), make_tx(100 * source + i), to, 1));
+      ASSERT_EQ(first, to);
+    }
+    stems.insert(to);
+  }
+  ASSERT_EQ(stems.size(), 2);
+  ASSERT_EQ(relay.get_embargoed_count(), 20 * 6);
+
+  // a stem peer going away is replaced by the one left
+  const connection_id gone = *stems.begin();
+  relay.remove_connection(gone);
+  for (size_t source = 10; source < 30; ++source)
+  {
+    connection_id to;
+    ASSERT_TRUE(relay.route_stem(make_connection_id(source), make_tx(source), to, 1));
+    ASSERT_NE(to, gone);
+  }
+}
+
+TEST(dandelionpp, fluff_epoch_stems_local_txes_only)
+{
+  cryptonote::dandelionpp_relay relay(1);
+  relay.set_config(2, 100, epoch_ms, embargo_ms, 0);
+  relay.update_peers({make_connection_id(1), make_connection_id(2)}, 1);
+  ASSERT_TRUE(relay.is_fluff_epoch());
+
+  connection_id to;
+  ASSERT_FALSE(relay.route_stem(make_connection_id(5), make_tx(0), to, 1));
+  ASSERT_TRUE(relay.route_stem(boost::uuids::nil_uuid(), make_tx(1), to, 1));
+}
+
+TEST(dandelionpp, embargo_expires_unless_fluff_seen)
+{
+  cryptonote::dandelionpp_relay relay(1);
+  relay.set_config(1, 0, epoch_ms, embargo_ms, 0);
+  relay.update_peers({make_connection_id(1)}, 1);
+
+  connection_id to;
+  ASSERT_TRUE(relay.route_stem(boost::uuids::nil_uuid(), make_tx(0), to, 1));
+  ASSERT_TRUE(relay.route_stem(boost::uuids::nil_uuid(), make_tx(1), to, 1));
+  relay.on_fluff_seen(make_tx(1));
+  ASSERT_EQ(relay.get_embargoed_count(), 1);
+
+  std::vector<cryptonote::blobdata> txs;
+  std::vector<connection_id> sources;
+  ASSERT_FALSE(relay.take_fluff_batch(txs, sources, 1));
+  ASSERT_EQ(relay.check_embargoes(1 + 4 * embargo_ms), 1);
+  ASSERT_TRUE(relay.take_fluff_batch(txs, sources, 1 + 4 * embargo_ms));
+  ASSERT_EQ(txs, std::vector<cryptonote::blobdata>{make_tx(0)});
+}
+
+TEST(dandelionpp, fluff_batches_wait_for_interval)
+{
+  cryptonote::dandelionpp_relay relay(1);
+  relay.set_config(0, 0, epoch_ms, embargo_ms, 1000);
+
+  std::vector<cryptonote::blobdata> txs;
+  std::vector<connection_id> sources;
+  relay.queue_fluff(make_tx(0), make_connection_id(1));
+  ASSERT_TRUE(relay.take_fluff_batch(txs, sources, 100));
+  ASSERT_EQ(txs.size(), 1);
+  relay.queue_fluff(make_tx(1), make_connection_id(1));
+  relay.queue_fluff(make_tx(2), make_connection_id(2));
+  ASSERT_FALSE(relay.take_fluff_batch(txs, sources, 500));
+  ASSERT_TRUE(relay.take_fluff_batch(txs, sources, 1100));
+  ASSERT_EQ(txs.size(), 2);
+  ASSERT_EQ(sources, (std::vector<connection_id>{make_connection_id(1), make_connection_id(2)}));
+}
+
+TEST(dandelionpp, all_nodes_get_txes)
+{
+  network_config config;
+  network net(config);
+  const std::vector<cryptonote::blobdata> txs = add_txes(net, 50, 200);
+  net.run_until(net.now() + 5 * embargo_ms);
+
+  for (const cryptonote::blobdata &tx: txs)
+    ASSERT_EQ(net.count_nodes_with(tx), config.nodes);
+  ASSERT_GT(net.get_stem_message_count(), 0);
+}
+
+TEST(dandelionpp, black_holes_only_delay_txes)
+{
+  network_config config;
+  config.fluff_probability = 0;
+  network net(config);
+  for (size_t n = 1; n < config.nodes; ++n)
+    net.set_black_hole(n);
+
+  // every stem ends at the first hop, so only the embargo gets the tx out
+  net.run_until(2 * idle_interval_ms);
+  net.add_tx(0, make_tx(0));
+  net.run_until(net.now() + embargo_ms / 10);
+  ASSERT_EQ(net.count_nodes_with(make_tx(0)), 1);
+  net.run_until(net.now() + 5 * embargo_ms);
+  ASSERT_EQ(net.count_nodes_with(make_tx(0)), config.nodes);
+  ASSERT_EQ(net.get_embargoed_count(), 0);
+}
+
+TEST(dandelionpp, no_stems_floods)
+{
+  network_config config;
+  config.stems = 0;
+  config.fluff_interval_ms = 0;
+  network net(config);
+  add_txes(net, 1, 0);
+  net.run_until(net.now() + 10 * idle_interval_ms);
+  ASSERT_EQ(net.count_nodes_with(make_tx(0)), config.nodes);
+  ASSERT_EQ(net.get_stem_message_count(), 0);
+}
+
+TEST(dandelionpp, batching_saves_messages)
+{
+  // txes arriving faster than the batching interval, as at peak load
+  network_config config;
+  config.fluff_interval_ms = 0;
+  network unbatched(config);
+  const std::vector<cryptonote::blobdata> txs = add_txes(unbatched, 200, 20);
+  unbatched.run_until(unbatched.now() + 5 * embargo_ms);
+
+  config.fluff_interval_ms = DANDELIONPP_FLUFF_INTERVAL;
+  network batched(config);
+  add_txes(batched, 200, 20);
+  batched.run_until(batched.now() + 5 * embargo_ms);
+
+  for (const cryptonote::blobdata &tx: txs)
+  {
+    ASSERT_EQ(unbatched.count_nodes_with(tx), config.nodes);
+    ASSERT_EQ(batched.count_nodes_with(tx), config.nodes);
+  }
+  MGINFO("messages: " << unbatched.get_message_count() << " unbatched, " << batched.get_message_count() << " batched");
+  ASSERT_LT(batched.get_message_count() * 4, unbatched.get_message_count());
+}
+
+TEST(dandelionpp, deterministic)
+{
+  network_config config;
+  config.seed = 42;
+  network a(config), b(config);
+  const std::vector<cryptonote::blobdata> txs = add_txes(a, 20, 300);
+  add_txes(b, 20, 300);
+  a.run_until(a.now() + 5 * embargo_ms);
+  b.run_until(b.now() + 5 * embargo_ms);
+
+  ASSERT_EQ(a.get_message_count(), b.get_message_count());
+  ASSERT_EQ(a.get_tx_send_count(), b.get_tx_send_count());
+  for (const cryptonote::blobdata &tx: txs)
+    ASSERT_EQ(a.get_arrival_times(tx), b.get_arrival_times(tx));
+}
+
+int main(int argc, char** argv)
+{
+  tools::on_startup();
+  epee::debug::get_set_enable_assert(true, false);
+  mlog_configure(mlog_get_default_log_path("net_load_tests_dandelionpp.log"), true);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -99,3 +99,56 @@ public:
 private:
   std::vector<rct::Bulletproof> proofs;
 };
+
+template<size_t n_outputs, size_t n_tokens>
+class test_big_bulletproof
+{
+public:
+  static const size_t loop_count = 20;
+
+  bool init()
+  {
+    for (size_t t = 0; t < n_tokens; ++t)
+    {
+      const size_t n = n_outputs / n_tokens + (t < n_outputs % n_tokens ? 1 : 0);
+      inputs.push_back(rct::bulletproof_input_raw(std::vector<uint64_t>(n, 749327532984), rct::skvGen(n), rct::hashToPoint(rct::skGen())));
+    }
+    return true;
+  }
+
+  bool test()
+  {
+    rct::bulletproof_PROVE(inputs);
+    return true;
+  }
+
+private:
+  std::vector<rct::bulletproof_input_raw> inputs;
+};
+
+template<size_t n_outputs, size_t n_tokens>
+class test_big_bulletproof_verify
+{
+public:
+  static const size_t loop_count = 50;
+
+  bool init()
+  {
+    std::vector<rct::bulletproof_input_raw> inputs;
+    for (size_t t = 0; t < n_tokens; ++t)
+    {
+      const size_t n = n_outputs / n_tokens + (t < n_outputs % n_tokens ? 1 : 0);
+      inputs.push_back(rct::bulletproof_input_raw(std::vector<uint64_t>(n, 749327532984), rct::skvGen(n), rct::hashToPoint(rct::skGen())));
+    }
+    proof = rct::bulletproof_PROVE(inputs);
+    return true;
+  }
+
+  bool test()
+  {
+    return rct::bulletproof_VERIFY(proof);
+  }
+
+private:
+  rct::BigBulletproof proof;
+};
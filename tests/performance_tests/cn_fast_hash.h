@@ -56,3 +56,34 @@ public:
 private:
   std::array<uint8_t, bytes> m_data;
 };
+
+template<size_t count, size_t bytes>
+class test_cn_fast_hash_n
+{
+public:
+  static const size_t loop_count = 100000 / count;
+
+  bool init()
+  {
+    m_data.resize(count * bytes);
+    crypto::rand(m_data.size(), m_data.data());
+    for (size_t i = 0; i < count; ++i)
+    {
+      m_pointers[i] = m_data.data() + i * bytes;
+      m_lengths[i] = bytes;
+    }
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::cn_fast_hash_n(m_pointers, m_lengths, m_hashes, count);
+    return true;
+  }
+
+private:
+  std::vector<uint8_t> m_data;
+  const void *m_pointers[count];
+  size_t m_lengths[count];
+  crypto::hash m_hashes[count];
+};
@@ -55,6 +55,9 @@ enum test_op
   op_addKeys3,
   op_addKeys3_2,
   op_isInMainSubgroup,
+  op_gp_genC,
+  op_tokenIdToPoint,
+  op_tokenIdToPoint_cached,
 };
 
 template<test_op op>
@@ -76,6 +79,8 @@ public:
     ge_p3_to_cached(&cached, &p3_0);
     rct::precomp(precomp0, point0);
     rct::precomp(precomp1, point1);
+    token_id = 0x4b4f54;
+    token_point = rct::tokenIdToPoint(token_id);
     return true;
   }
 
@@ -109,6 +114,9 @@ public:
       case op_addKeys3: rct::addKeys3(key, scalar0, point0, scalar1, precomp1); break;
       case op_addKeys3_2: rct::addKeys3(key, scalar0, precomp0, scalar1, precomp1); break;
       case op_isInMainSubgroup: rct::isInMainSubgroup(point0); break;
+      case op_gp_genC: rct::gp_genC(key, scalar0, token_point, 749327532984); break;
+      case op_tokenIdToPoint: rct::tokenIdToPoint(++token_id); break; // a fresh id misses the cache
+      case op_tokenIdToPoint_cached: rct::tokenIdToPoint(token_id); break;
       default: return false;
     }
     return true;
@@ -120,4 +128,6 @@ private:
   ge_p3 p3_0, p3_1;
   ge_cached cached;
   ge_dsmp precomp0, precomp1;
+  cryptonote::TokenId token_id;
+  rct::key token_point;
 };
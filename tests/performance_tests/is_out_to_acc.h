@@ -74,3 +74,77 @@ public:
 private:
   crypto::key_derivation m_derivation;
 };
+
+// scans n_txes transactions, half of them to bob, one tx pubkey at a time or in batches
+template<size_t n_txes, bool batched>
+class test_is_out_to_acc_scan
+{
+public:
+  static const size_t loop_count = n_txes < 32 ? 100 : 10;
+
+  bool init()
+  {
+    cryptonote::account_base alice;
+    m_bob.generate();
+    alice.generate();
+    m_subaddresses[m_bob.get_keys().m_account_address.m_spend_public_key] = {0,0};
+
+    m_txes.resize(n_txes);
+    for (size_t i = 0; i < n_txes; ++i)
+    {
+      const cryptonote::account_base &to = i % 2 ? alice : m_bob;
+      if (!cryptonote::construct_miner_tx(i, 0, 0, 2, 0, to.get_keys().m_account_address, m_txes[i]))
+        return false;
+      m_tx_pub_keys.push_back(cryptonote::get_tx_pub_key_from_extra(m_txes[i]));
+    }
+    return true;
+  }
+
+  bool test()
+  {
+    hw::device &hwdev = hw::get_device("default");
+    const crypto::secret_key &view_secret_key = m_bob.get_keys().m_view_secret_key;
+    const std::vector<crypto::key_derivation> additional_derivations;
+    std::vector<crypto::key_derivation> derivations(n_txes);
+    size_t found = 0;
+
+    if (!batched)
+    {
+      for (size_t i = 0; i < n_txes; ++i)
+      {
+        if (!crypto::generate_key_derivation(m_tx_pub_keys[i], view_secret_key, derivations[i]))
+          return false;
+        for (size_t k = 0; k < m_txes[i].vout.size(); ++k)
+        {
+          const cryptonote::txout_to_key& tx_out = boost::get<cryptonote::txout_to_key>(m_txes[i].vout[k].target);
+          if (cryptonote::is_out_to_acc_precomp(m_subaddresses, tx_out.key, derivations[i], additional_derivations, k, hwdev))
+            ++found;
+        }
+      }
+      return found >= n_txes / 2;
+    }
+
+    std::vector<int> good(n_txes);
+    crypto::generate_key_derivations(m_tx_pub_keys.data(), n_txes, view_secret_key, derivations.data(), good.data());
+    std::vector<cryptonote::out_to_acc_query> queries;
+    for (size_t i = 0; i < n_txes; ++i)
+    {
+      if (!good[i])
+        return false;
+      for (size_t k = 0; k < m_txes[i].vout.size(); ++k)
+        queries.push_back({boost::get<cryptonote::txout_to_key>(m_txes[i].vout[k].target).key, &derivations[i], nullptr, k});
+    }
+    std::vector<boost::optional<cryptonote::subaddress_receive_info>> results(queries.size());
+    cryptonote::is_out_to_acc_precomp_batch(m_subaddresses, queries.data(), queries.size(), results.data(), hwdev);
+    for (const auto &result: results)
+      if (result)
+        ++found;
+    return found >= n_txes / 2;
+  }
+
+private:
+  cryptonote::account_base m_bob;
+  std::unordered_map<crypto::public_key, cryptonote::subaddress_index> m_subaddresses;
+  std::vector<cryptonote::transaction> m_txes;
+  std::vector<crypto::public_key> m_tx_pub_keys;
+};
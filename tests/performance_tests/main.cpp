@@ -33,7 +33,9 @@
 
 #include "common/util.h"
 #include "common/command_line.h"
+#include "version.h"
 #include "performance_tests.h"
+#include "performance_report.h"
 #include "performance_utils.h"
 
 // tests
@@ -51,6 +53,7 @@
 #include "is_out_to_acc.h"
 #include "subaddress_expand.h"
 #include "sc_reduce32.h"
+#include "sk_gen.h"
 #include "cn_fast_hash.h"
 #include "rct_mlsag.h"
 #include "equality.h"
@@ -59,6 +62,7 @@
 #include "bulletproof.h"
 #include "crypto_ops.h"
 #include "multiexp.h"
+#include "pos.h"
 
 namespace po = boost::program_options;
 
@@ -76,10 +80,18 @@ int main(int argc, char** argv)
   const command_line::arg_descriptor<bool> arg_verbose = { "verbose", "Verbose output", false };
   const command_line::arg_descriptor<bool> arg_stats = { "stats", "Including statistics (min/median)", false };
   const command_line::arg_descriptor<unsigned> arg_loop_multiplier = { "loop-multiplier", "Run for that many times more loops", 1 };
+  const command_line::arg_descriptor<std::string> arg_json = { "json", "Write the results, with statistics and the CPU features, to this JSON file" };
+  const command_line::arg_descriptor<std::vector<std::string>> arg_compare = { "compare", "Compare two JSON result files instead of running tests, give it twice: base, then current" };
+  const command_line::arg_descriptor<double> arg_threshold = { "threshold", "Smallest change of the median, in percent, reported by --compare", 5.0 };
+  const command_line::arg_descriptor<double> arg_min_z = { "min-z", "Smallest difference of the means, in standard errors, reported by --compare", 3.0 };
   command_line::add_arg(desc_options, arg_filter);
   command_line::add_arg(desc_options, arg_verbose);
   command_line::add_arg(desc_options, arg_stats);
   command_line::add_arg(desc_options, arg_loop_multiplier);
+  command_line::add_arg(desc_options, arg_json);
+  command_line::add_arg(desc_options, arg_compare);
+  command_line::add_arg(desc_options, arg_threshold);
+  command_line::add_arg(desc_options, arg_min_z);
 
   po::variables_map vm;
   bool r = command_line::handle_error_helper(desc_options, [&]()
@@ -91,11 +103,41 @@ int main(int argc, char** argv)
   if (!r)
     return 1;
 
+  const std::vector<std::string> compare = command_line::get_arg(vm, arg_compare);
+  if (!compare.empty())
+  {
+    if (compare.size() != 2)
+    {
+      std::cout << "--compare needs exactly two files" << std::endl;
+      return 1;
+    }
+    performance_report base, current;
+    if (!epee::serialization::load_t_from_json_file(base, compare[0]))
+    {
+      std::cout << "Failed to load " << compare[0] << std::endl;
+      return 1;
+    }
+    if (!epee::serialization::load_t_from_json_file(current, compare[1]))
+    {
+      std::cout << "Failed to load " << compare[1] << std::endl;
+      return 1;
+    }
+    return compare_reports(base, current, command_line::get_arg(vm, arg_threshold), command_line::get_arg(vm, arg_min_z)) ? 1 : 0;
+  }
+
+  performance_report report;
+  report.version = PERFORMANCE_REPORT_VERSION;
+  report.release = MONERO_VERSION_FULL;
+  report.cpu = get_cpu_info();
+  print_cpu_info(report.cpu);
+
   const std::string filter = tools::glob_to_regex(command_line::get_arg(vm, arg_filter));
+  const std::string json_file = command_line::get_arg(vm, arg_json);
   Params p;
   p.verbose = command_line::get_arg(vm, arg_verbose);
-  p.stats = command_line::get_arg(vm, arg_stats);
+  p.stats = command_line::get_arg(vm, arg_stats) || !json_file.empty();
   p.loop_multiplier = command_line::get_arg(vm, arg_loop_multiplier);
+  p.results = json_file.empty() ? nullptr : &report.tests;
 
   performance_timer timer;
   timer.start();
@@ -177,6 +219,10 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(filter, p, test_is_out_to_acc);
   TEST_PERFORMANCE0(filter, p, test_is_out_to_acc_precomp);
+  TEST_PERFORMANCE2(filter, p, test_is_out_to_acc_scan, 16, false);
+  TEST_PERFORMANCE2(filter, p, test_is_out_to_acc_scan, 16, true);
+  TEST_PERFORMANCE2(filter, p, test_is_out_to_acc_scan, 256, false);
+  TEST_PERFORMANCE2(filter, p, test_is_out_to_acc_scan, 256, true);
   TEST_PERFORMANCE0(filter, p, test_generate_key_image_helper);
   TEST_PERFORMANCE0(filter, p, test_generate_key_derivation);
   TEST_PERFORMANCE0(filter, p, test_generate_key_image);
@@ -185,6 +231,13 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(filter, p, test_ge_frombytes_vartime);
   TEST_PERFORMANCE0(filter, p, test_generate_keypair);
   TEST_PERFORMANCE0(filter, p, test_sc_reduce32);
+
+  TEST_PERFORMANCE1(filter, p, test_sk_gen, 1);
+  TEST_PERFORMANCE1(filter, p, test_sk_gen, 2);
+  TEST_PERFORMANCE1(filter, p, test_sk_gen, 4);
+  TEST_PERFORMANCE1(filter, p, test_sk_gen, 8);
+  TEST_PERFORMANCE1(filter, p, test_sk_gen, 16);
+  TEST_PERFORMANCE1(filter, p, test_sk_gen, 32);
   TEST_PERFORMANCE1(filter, p, test_signature, false);
   TEST_PERFORMANCE1(filter, p, test_signature, true);
 
@@ -193,6 +246,10 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(filter, p, test_cn_slow_hash);
   TEST_PERFORMANCE1(filter, p, test_cn_fast_hash, 32);
   TEST_PERFORMANCE1(filter, p, test_cn_fast_hash, 16384);
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_n, 4, 64);
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_n, 8, 64);
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_n, 64, 64);
+  TEST_PERFORMANCE2(filter, p, test_cn_fast_hash_n, 64, 1024);
 
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 3, false);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 5, false);
@@ -203,6 +260,10 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 10, true);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 100, true);
 
+  TEST_PERFORMANCE3(filter, p, test_ringct_mlsag_simple_ver, 2, 11, 1);
+  TEST_PERFORMANCE3(filter, p, test_ringct_mlsag_simple_ver, 16, 11, 1); // a sweep
+  TEST_PERFORMANCE3(filter, p, test_ringct_mlsag_simple_ver, 2, 11, 16); // 16 txes verified together, as in a block
+
   TEST_PERFORMANCE2(filter, p, test_equality, memcmp32, true);
   TEST_PERFORMANCE2(filter, p, test_equality, memcmp32, false);
   TEST_PERFORMANCE2(filter, p, test_equality, verify32, false);
@@ -231,6 +292,22 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, false, 2, 1, 1, 0, 64);
   TEST_PERFORMANCE6(filter, p, test_aggregated_bulletproof, true, 2, 1, 1, 0, 64); // 64 proof, each with 2 amounts
 
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 2, 1); // 2 outputs of a single token
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 2, 2);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 4, 1);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 4, 2);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 3, 3);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 4, 4);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 16, 1);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 16, 2);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 16, 3); // uneven split, 6/5/5
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof, 16, 4); // 16 outputs split over 4 tokens
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof_verify, 2, 1);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof_verify, 2, 2);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof_verify, 4, 2);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof_verify, 16, 3);
+  TEST_PERFORMANCE2(filter, p, test_big_bulletproof_verify, 16, 4);
+
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 3, false);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 5, false);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 10, false);
@@ -257,6 +334,13 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_addKeys3);
   TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_addKeys3_2);
   TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_isInMainSubgroup);
+  TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_gp_genC);
+  TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_tokenIdToPoint);
+  TEST_PERFORMANCE1(filter, p, test_crypto_ops, op_tokenIdToPoint_cached);
+
+  TEST_PERFORMANCE0(filter, p, test_find_pos_hash);
+  TEST_PERFORMANCE0(filter, p, test_get_new_block_time_delta);
+  TEST_PERFORMANCE1(filter, p, test_check_pos_block, 11);
 
   TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_bos_coster, 2);
   TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_bos_coster, 4);
@@ -544,6 +628,12 @@ int main(int argc, char** argv)
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
+  if (!json_file.empty() && !epee::serialization::store_t_to_json_file(report, json_file))
+  {
+    std::cout << "Failed to write " << json_file << std::endl;
+    return 1;
+  }
+
   return 0;
   CATCH_ENTRY_L0("main", 1);
 }
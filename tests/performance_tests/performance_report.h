@@ -0,0 +1,253 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#define PERFORMANCE_X86_CPUID
+#endif
+
+#include "serialization/keyvalue_serialization.h"
+#include "storages/portable_storage_template_helper.h"
+
+#define PERFORMANCE_REPORT_VERSION 1
+
+/**
+ * @brief the CPU and the build options that select crypto code paths
+ */
+struct cpu_info
+{
+  std::string model;
+  uint32_t threads;
+  std::vector<std::string> features;
+  std::vector<std::string> build;
+
+  BEGIN_KV_SERIALIZE_MAP()
+    KV_SERIALIZE(model)
+    KV_SERIALIZE(threads)
+    KV_SERIALIZE(features)
+    KV_SERIALIZE(build)
+  END_KV_SERIALIZE_MAP()
+};
+
+/**
+ * @brief per call timings of one test, in nanoseconds
+ */
+struct test_result
+{
+  std::string name;
+  uint64_t loop_count;
+  uint64_t min_ns;
+  uint64_t p25_ns;
+  uint64_t median_ns;
+  uint64_t p75_ns;
+  uint64_t p90_ns;
+  uint64_t p99_ns;
+  uint64_t max_ns;
+  uint64_t mean_ns;
+  uint64_t stddev_ns;
+
+  BEGIN_KV_SERIALIZE_MAP()
+    KV_SERIALIZE(name)
+    KV_SERIALIZE(loop_count)
+    KV_SERIALIZE(min_ns)
+    KV_SERIALIZE(p25_ns)
+    KV_SERIALIZE(median_ns)
+    KV_SERIALIZE(p75_ns)
+    KV_SERIALIZE(p90_ns)
+    KV_SERIALIZE(p99_ns)
+    KV_SERIALIZE(max_ns)
+    KV_SERIALIZE(mean_ns)
+    KV_SERIALIZE(stddev_ns)
+  END_KV_SERIALIZE_MAP()
+};
+
+struct performance_report
+{
+  uint32_t version;
+  std::string release; //!< version of the code that was tested
+  cpu_info cpu;
+  std::vector<test_result> tests;
+
+  BEGIN_KV_SERIALIZE_MAP()
+    KV_SERIALIZE(version)
+    KV_SERIALIZE(release)
+    KV_SERIALIZE(cpu)
+    KV_SERIALIZE(tests)
+  END_KV_SERIALIZE_MAP()
+};
+
+cpu_info get_cpu_info()
+{
+  cpu_info info;
+  info.threads = std::thread::hardware_concurrency();
+
+#ifdef PERFORMANCE_X86_CPUID
+  unsigned int regs[12];
+  if (__get_cpuid(0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]) && regs[0] >= 0x80000004)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+      __get_cpuid(0x80000002 + i, &regs[4 * i], &regs[4 * i + 1], &regs[4 * i + 2], &regs[4 * i + 3]);
+    char brand[sizeof(regs) + 1];
+    memcpy(brand, regs, sizeof(regs));
+    brand[sizeof(regs)] = 0;
+    info.model = brand;
+    info.model.erase(0, info.model.find_first_not_of(' '));
+  }
+
+  __builtin_cpu_init();
+#define PERFORMANCE_CPU_FEATURE(f) if (__builtin_cpu_supports(f)) info.features.push_back(f)
+  PERFORMANCE_CPU_FEATURE("sse2");
+  PERFORMANCE_CPU_FEATURE("ssse3");
+  PERFORMANCE_CPU_FEATURE("sse4.1");
+  PERFORMANCE_CPU_FEATURE("sse4.2");
+  PERFORMANCE_CPU_FEATURE("aes");
+  PERFORMANCE_CPU_FEATURE("pclmul");
+  PERFORMANCE_CPU_FEATURE("avx");
+  PERFORMANCE_CPU_FEATURE("avx2");
+  PERFORMANCE_CPU_FEATURE("bmi2");
+  PERFORMANCE_CPU_FEATURE("avx512f");
+  PERFORMANCE_CPU_FEATURE("avx512bw");
+  PERFORMANCE_CPU_FEATURE("avx512dq");
+  PERFORMANCE_CPU_FEATURE("avx512vl");
+  PERFORMANCE_CPU_FEATURE("avx512ifma");
+#undef PERFORMANCE_CPU_FEATURE
+#endif
+  if (info.model.empty())
+  {
+#if defined(__aarch64__)
+    info.model = "aarch64";
+#elif defined(__arm__)
+    info.model = "arm";
+#else
+    info.model = "unknown";
+#endif
+  }
+
+#if defined(CRYPTO_FE_64)
+  info.build.push_back("fe64");
+#endif
+#if defined(NDEBUG)
+  info.build.push_back("release");
+#else
+  info.build.push_back("debug");
+#endif
+#if defined(__clang__)
+  info.build.push_back(std::string("clang ") + __clang_version__);
+#elif defined(__GNUC__)
+  info.build.push_back(std::string("gcc ") + __VERSION__);
+#elif defined(_MSC_VER)
+  info.build.push_back("msvc " + std::to_string(_MSC_VER));
+#endif
+  return info;
+}
+
+void print_cpu_info(const cpu_info &info)
+{
+  std::cout << "CPU: " << info.model << ", " << info.threads << " threads" << std::endl;
+  std::cout << "Features:";
+  for (const auto &f: info.features)
+    std::cout << " " << f;
+  std::cout << std::endl << "Build:";
+  for (const auto &b: info.build)
+    std::cout << " " << b;
+  std::cout << std::endl;
+}
+
+/**
+ * @brief compares the tests two reports have in common
+ *
+ * A test is reported as faster or slower when its median changed by at least
+ * threshold percent and the difference of the means is at least min_z standard
+ * errors, so that a change within the noise of either run is not flagged.
+ *
+ * @return the number of tests that got significantly slower
+ */
+size_t compare_reports(const performance_report &base, const performance_report &current, double threshold, double min_z)
+{
+  if (base.cpu.model != current.cpu.model || base.cpu.features != current.cpu.features || base.cpu.build != current.cpu.build)
+  {
+    std::cout << "Warning: the reports were made on different CPUs or builds" << std::endl;
+    std::cout << "Base:" << std::endl;
+    print_cpu_info(base.cpu);
+    std::cout << "Current:" << std::endl;
+    print_cpu_info(current.cpu);
+  }
+
+  std::map<std::string, const test_result*> base_tests;
+  for (const auto &t: base.tests)
+    base_tests[t.name] = &t;
+
+  size_t n_slower = 0, n_faster = 0, n_compared = 0;
+  for (const auto &t: current.tests)
+  {
+    const auto i = base_tests.find(t.name);
+    if (i == base_tests.end())
+    {
+      std::cout << t.name << ": new" << std::endl;
+      continue;
+    }
+    const test_result &b = *i->second;
+    base_tests.erase(i);
+    ++n_compared;
+
+    const double change = b.median_ns ? 100.0 * ((double)t.median_ns - b.median_ns) / b.median_ns : 0.0;
+    const double se = std::sqrt((double)b.stddev_ns * b.stddev_ns / std::max<uint64_t>(b.loop_count, 1)
+        + (double)t.stddev_ns * t.stddev_ns / std::max<uint64_t>(t.loop_count, 1));
+    const double diff = (double)t.mean_ns - b.mean_ns;
+    const double z = se > 0 ? diff / se : (diff == 0 ? 0.0 : (diff > 0 ? INFINITY : -INFINITY));
+    const char *verdict = "~";
+    if (std::fabs(change) >= threshold && std::fabs(z) >= min_z && (change > 0) == (z > 0))
+    {
+      verdict = change > 0 ? "SLOWER" : "faster";
+      if (change > 0)
+        ++n_slower;
+      else
+        ++n_faster;
+    }
+    std::cout << t.name << ": " << b.median_ns << " -> " << t.median_ns << " ns median, "
+      << std::showpos << std::fixed << std::setprecision(1) << change << "%, z " << z << std::noshowpos
+      << " " << verdict << std::endl;
+  }
+  for (const auto &i: base_tests)
+    std::cout << i.first << ": missing" << std::endl;
+
+  std::cout << n_compared << " tests compared, " << n_faster << " faster, " << n_slower << " slower" << std::endl;
+  return n_slower;
+}
@@ -31,6 +31,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <stdint.h>
 
@@ -39,6 +40,7 @@
 
 #include "misc_language.h"
 #include "common/perf_timer.h"
+#include "performance_report.h"
 
 class performance_timer
 {
@@ -71,6 +73,7 @@ struct Params
   bool verbose;
   bool stats;
   unsigned loop_multiplier;
+  std::vector<test_result> *results; //!< if not null, each passing test is added, needs stats
 };
 
 template <typename T>
@@ -152,6 +155,16 @@ public:
     return epee::misc_utils::median(values);
   }
 
+  uint64_t per_call_percentile(unsigned percent) const
+  {
+    std::vector<uint64_t> values;
+    values.reserve(m_per_call_timers.size());
+    for (const auto &pt: m_per_call_timers)
+      values.push_back(pt.value());
+    std::sort(values.begin(), values.end());
+    return values[(percent * (values.size() - 1) + 50) / 100];
+  }
+
   uint64_t per_call_stddev() const
   {
     if (m_per_call_timers.size() <= 1)
@@ -170,6 +183,8 @@ public:
   uint64_t min_time_ns() const { return tools::ticks_to_ns(per_call_min()); }
   uint64_t max_time_ns() const { return tools::ticks_to_ns(per_call_max()); }
   uint64_t median_time_ns() const { return tools::ticks_to_ns(per_call_median()); }
+  uint64_t mean_time_ns() const { return tools::ticks_to_ns(per_call_mean()); }
+  uint64_t percentile_time_ns(unsigned percent) const { return tools::ticks_to_ns(per_call_percentile(percent)); }
   uint64_t standard_deviation_time_ns() const { return tools::ticks_to_ns(per_call_stddev()); }
 
 private:
@@ -242,6 +257,23 @@ void run_test(const std::string &filter, const Params &params, const char* test_
       std::cout << " (min " << min_ns << " " << unit << ", median " << med_ns << " " << unit << ", std dev " << stddev_ns << " " << unit << ")";
     }
     std::cout << std::endl;
+
+    if (params.results)
+    {
+      test_result result;
+      result.name = test_name;
+      result.loop_count = T::loop_count * params.loop_multiplier;
+      result.min_ns = runner.min_time_ns();
+      result.p25_ns = runner.percentile_time_ns(25);
+      result.median_ns = runner.median_time_ns();
+      result.p75_ns = runner.percentile_time_ns(75);
+      result.p90_ns = runner.percentile_time_ns(90);
+      result.p99_ns = runner.percentile_time_ns(99);
+      result.max_ns = runner.max_time_ns();
+      result.mean_ns = runner.mean_time_ns();
+      result.stddev_ns = runner.standard_deviation_time_ns();
+      params.results->push_back(result);
+    }
   }
   else
   {
@@ -0,0 +1,166 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "mining/miningutil.h"
+#include "ringct/rctSigs.h"
+
+#include "multi_tx_test_base.h"
+
+class test_find_pos_hash
+{
+public:
+  static const size_t loop_count = 100000;
+
+  bool init()
+  {
+    m_key_image = crypto::rand<crypto::key_image>();
+    m_prev_id = crypto::rand<crypto::hash>();
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::hash pos_hash;
+    mining::find_pos_hash(m_key_image, m_prev_id, pos_hash);
+    return true;
+  }
+
+private:
+  crypto::key_image m_key_image;
+  crypto::hash m_prev_id;
+};
+
+class test_get_new_block_time_delta
+{
+public:
+  static const size_t loop_count = 10000;
+
+  bool init()
+  {
+    m_pos_hash = crypto::rand<crypto::hash>();
+    return true;
+  }
+
+  bool test()
+  {
+    uint64_t time_delta;
+    mining::get_new_block_time_delta(m_pos_hash, 1000 * COIN, 1000000, time_delta);
+    return time_delta > 0;
+  }
+
+private:
+  crypto::hash m_pos_hash;
+};
+
+// The checks of Blockchain::check_pos_block that do not need the chain: parsing the
+// coinstake tx, its stamp and amount, and the PoS hash. The ring signature and the
+// lookups of the previous block are left out, test_check_tx_signature covers the former.
+template<size_t a_ring_size>
+class test_check_pos_block : private multi_tx_test_base<a_ring_size>
+{
+public:
+  static const size_t loop_count = 1000;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace cryptonote;
+
+    if (!base_class::init())
+      return false;
+
+    account_base alice;
+    alice.generate();
+    std::vector<tx_destination_entry> destinations;
+    destinations.push_back(tx_destination_entry(0, this->m_source_amount, alice.get_keys().m_account_address, false));
+
+    std::unordered_map<crypto::public_key, cryptonote::subaddress_index> subaddresses;
+    subaddresses[this->m_miners[this->real_source_idx].get_keys().m_account_address.m_spend_public_key] = {0,0};
+    TxConstructionContext context;
+    context.d_sender_account_keys = this->m_miners[this->real_source_idx].get_keys();
+    context.d_subaddresses        = subaddresses;
+    context.d_sources             = this->m_sources;
+    context.d_destinations        = destinations;
+    context.d_change_addr         = account_public_address{};
+    context.d_range_proof_type    = rct::RangeProofPaddedBulletproof;
+    transaction tx;
+    if (!construct_tx_and_get_tx_key(context, tx))
+      return false;
+    if (tx.rct_signatures.p.pseudoOuts.size() != 1)
+      return false;
+
+    // the stamp holds the mask part of the input commitment
+    tx_extra_pos_stamp stamp{};
+    stamp.amount = this->m_source_amount;
+    stamp.crypto_hash = crypto::rand<crypto::hash>();
+    rct::subKeys(stamp.key, tx.rct_signatures.p.pseudoOuts[0], rct::scalarmultH(rct::d2h(stamp.amount)));
+    if (!add_pos_stamp_to_tx_extra(tx.extra, stamp))
+      return false;
+    tx.invalidate_hashes();
+    m_tx_blob = tx_to_blob(tx);
+
+    m_prev_id = crypto::rand<crypto::hash>();
+    m_difficulty = 1000000;
+    crypto::hash pos_hash;
+    mining::find_pos_hash(boost::get<txin_to_key>(tx.vin[0]).k_image, m_prev_id, pos_hash);
+    mining::get_new_block_time_delta(pos_hash, stamp.amount, m_difficulty, m_time_delta);
+    m_time_delta = std::max<uint64_t>(m_time_delta / 1000, 1);
+    return true;
+  }
+
+  bool test()
+  {
+    using namespace cryptonote;
+
+    transaction tx;
+    if (!parse_and_validate_tx_from_blob(m_tx_blob, tx))
+      return false;
+    if (tx.vin.size() != 1 || tx.vin[0].type() != typeid(txin_to_key))
+      return false;
+    tx_extra_pos_stamp stamp;
+    if (!get_pos_stamp(tx, stamp))
+      return false;
+    if (!rct::confirmTransactionAmount(tx.rct_signatures, stamp.key, stamp.amount))
+      return false;
+    crypto::hash pos_hash;
+    mining::find_pos_hash(boost::get<txin_to_key>(tx.vin[0]).k_image, m_prev_id, pos_hash);
+    return mining::check_pos_hash(pos_hash, stamp.amount, m_difficulty, m_time_delta);
+  }
+
+private:
+  cryptonote::blobdata m_tx_blob;
+  crypto::hash m_prev_id;
+  uint64_t m_difficulty;
+  uint64_t m_time_delta;
+};
@@ -86,3 +86,49 @@ private:
   size_t ind;
   rct::mgSig IIccss;
 };
+
+template<size_t a_inputs, size_t a_ring_size, size_t a_num_txes>
+class test_ringct_mlsag_simple_ver
+{
+public:
+  static const size_t inputs = a_inputs;
+  static const size_t ring_size = a_ring_size;
+  static const size_t loop_count = 10;
+
+  bool init()
+  {
+    m_sigs.resize(a_num_txes);
+    for (size_t n = 0; n < a_num_txes; ++n)
+    {
+      rct::ctkeyV sc, pc;
+      rct::ctkey sctmp, pctmp;
+      rct::ctamountV inamounts;
+      for (size_t i = 0; i < inputs; ++i)
+      {
+        inamounts.push_back({1000, rct::H});
+        std::tie(sctmp, pctmp) = rct::ctskpkGen(1000);
+        sc.push_back(sctmp);
+        pc.push_back(pctmp);
+      }
+      const std::vector<rct::xmr_amount> outamounts(1, inputs * 1000);
+      const rct::keyV destinations(1, rct::pkGen());
+      const rct::keyV amount_keys(1, rct::hash_to_scalar(rct::zero()));
+      m_sigs[n] = rct::genRctSimple(rct::zero(), sc, pc, destinations, inamounts, outamounts, amount_keys, NULL, NULL, 0, ring_size - 1, hw::get_device("default"));
+      m_rvv.push_back(&m_sigs[n]);
+    }
+    return true;
+  }
+
+  bool test()
+  {
+    // a single tx goes through the per tx entry point, as in the pool
+    if (a_num_txes == 1)
+      return rct::verRctNonSemanticsSimple(m_sigs[0]);
+    std::vector<size_t> bad;
+    return rct::verRctNonSemanticsSimple(m_rvv, bad);
+  }
+
+private:
+  std::vector<rct::rctSig> m_sigs;
+  std::vector<const rct::rctSig*> m_rvv;
+};
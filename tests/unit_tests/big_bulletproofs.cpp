@@ -234,3 +234,28 @@ TEST(big_bulletproofs, valid_aggregated)
   rct::BigBulletproof proof = bulletproof_PROVE(bulletproofs);
   ASSERT_TRUE(rct::bulletproof_VERIFY({proof}));
 }
+
+TEST(big_bulletproofs, batch_different_tokens)
+{
+  // Concerns:
+  // 1. Proofs with different numbers of tokens, and different tokens at the same index, can be verified together.
+  // 2. One bad token in the batch fails the whole batch.
+
+  rct::key seed{{}};
+  rct::keyV omegas;
+  for (size_t i = 0; i < 3; ++i) {
+    std::generate(std::begin(seed.bytes), std::end(seed.bytes), std::ref(rbe));
+    omegas.push_back(hashToPoint(seed));
+  }
+
+  std::vector<rct::BigBulletproof> proofs;
+  proofs.push_back(rct::bulletproof_PROVE({std::make_tuple(std::vector<uint64_t>{dist(mt)}, rct::keyV{rct::skGen()}, omegas[0])}));
+  proofs.push_back(rct::bulletproof_PROVE({std::make_tuple(std::vector<uint64_t>{dist(mt), dist(mt)}, rct::skvGen(2), omegas[1]),
+                                           std::make_tuple(std::vector<uint64_t>{dist(mt)}, rct::keyV{rct::skGen()}, omegas[2]),
+                                           std::make_tuple(std::vector<uint64_t>{dist(mt), dist(mt), dist(mt)}, rct::skvGen(3), omegas[0])}));
+  proofs.push_back(rct::bulletproof_PROVE({std::make_tuple(std::vector<uint64_t>{dist(mt)}, rct::keyV{rct::skGen()}, omegas[2])}));
+  ASSERT_TRUE(rct::bulletproof_VERIFY(proofs));
+
+  proofs[1].o[1] = omegas[1];
+  ASSERT_FALSE(rct::bulletproof_VERIFY(proofs));
+}
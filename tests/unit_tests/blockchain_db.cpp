@@ -32,7 +32,12 @@
 #include <cstdio>
 #include <iostream>
 #include <chrono>
+#include <future>
 #include <thread>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "gtest/gtest.h"
 
@@ -43,6 +48,12 @@
 #include "blockchain_db/berkeleydb/db_bdb.h"
 #endif
 #include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_core/blockchain.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_core/snapshot.h"
+#include "cryptonote_core/tx_pool.h"
+#include "ringct/rctSigs.h"
+#include "device/device.hpp"
 
 using namespace cryptonote;
 using epee::string_tools::pod_to_hex;
@@ -153,6 +164,80 @@ std::string h2b(const std::string& s)
   return result;
 }
 
+// a tx spending one rct input, with prunable data
+transaction make_rct_tx(rct::RangeProofType range_proof_type = rct::RangeProofBorromean)
+{
+  rct::ctkeyV sc, pc;
+  rct::ctkey sctmp, pctmp;
+  std::tie(sctmp, pctmp) = rct::ctskpkGen(1000);
+  sc.push_back(sctmp);
+  pc.push_back(pctmp);
+  const rct::key dest = rct::pkGen();
+
+  transaction tx;
+  tx.version = TxVersion::ring_signatures;
+  tx.unlock_time = 0;
+  txin_to_key in;
+  in.amount = 0;
+  in.key_offsets = {0, 1};
+  in.k_image = rct::rct2ki(rct::pkGen());
+  tx.vin.push_back(in);
+  tx_out out;
+  out.amount = 0;
+  out.target = txout_to_key(rct::rct2pk(dest));
+  tx.vout.push_back(out);
+  // the real input is first in its ring of two
+  const rct::ctkeyM mix_ring = {{pc[0], {rct::pkGen(), rct::pkGen()}}};
+  rct::ctkeyV out_sk;
+  tx.rct_signatures = rct::genRctSimple([](const rct::key &) { return rct::zero(); }, sc, {dest}, {{1000, rct::H}}, {1000}, 0,
+      mix_ring, {rct::skGen()}, NULL, NULL, {0}, out_sk, range_proof_type, hw::get_device("default"));
+  return tx;
+}
+
+// a pre-PoS block on top of prev_id holding txs, whose miner tx output is
+// stored with a commitment as on the real chain
+block make_block(const crypto::hash &prev_id, uint64_t height, const std::vector<transaction> &txs)
+{
+  block b;
+  b.major_version = 1;
+  b.minor_version = 1;
+  b.timestamp = 1500000000 + height * 120;
+  b.prev_id = prev_id;
+  b.nonce = 0;
+  b.miner_tx.version = TxVersion::ring_signatures;
+  b.miner_tx.unlock_time = height + 60;
+  txin_gen in;
+  in.height = height;
+  b.miner_tx.vin.push_back(in);
+  tx_out out;
+  out.amount = 1000000;
+  out.target = txout_to_key(rct::rct2pk(rct::pkGen()));
+  b.miner_tx.vout.push_back(out);
+  b.miner_tx.rct_signatures.type = (uint8_t)rct::RctType::RCTTypeNull;
+  for (const auto &tx: txs)
+    b.tx_hashes.push_back(get_transaction_hash(tx));
+  return b;
+}
+
+// throws from the next height() call once fail_next is set
+class flaky_lmdb : public BlockchainLMDB
+{
+public:
+  flaky_lmdb(): fail_next(false) {}
+
+  virtual uint64_t height() const
+  {
+    if (fail_next)
+    {
+      fail_next = false;
+      throw DB_ERROR("Injected failure");
+    }
+    return BlockchainLMDB::height();
+  }
+
+  mutable bool fail_next;
+};
+
 template <typename T>
 class BlockchainDBTest : public testing::Test
 {
@@ -345,4 +430,258 @@ TYPED_TEST(BlockchainDBTest, RetrieveBlockData)
   ASSERT_HASH_EQ(get_block_hash(this->m_blocks[1]), hashes[1]);
 }
 
+TEST(BlockchainLMDB, ColdDataFolder)
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  const std::string hot_dir = (dir / "hot").string(), cold_dir = (dir / "cold").string();
+
+  const transaction tx = make_rct_tx();
+  const crypto::hash txid = get_transaction_hash(tx);
+  {
+    BlockchainLMDB db;
+    HardFork hf(db, 1, 0);
+    db.set_cold_data_folder(cold_dir);
+    ASSERT_NO_THROW(db.open(hot_dir));
+    hf.init();
+    db.set_hard_fork(&hf);
+
+    ASSERT_NO_THROW(db.add_block(make_block(crypto::null_hash, 0, {tx}), 1000, 1, 1000000, {tx}));
+    ASSERT_TRUE(boost::filesystem::exists(boost::filesystem::path(cold_dir) / "data.mdb"));
+
+    // the full blob is put back together from both environments
+    blobdata blob;
+    ASSERT_TRUE(db.get_tx_blob(txid, blob));
+    ASSERT_EQ(tx_to_blob(tx), blob);
+    transaction read_tx;
+    ASSERT_TRUE(db.get_tx(txid, read_tx));
+    ASSERT_EQ(tx.rct_signatures.p.MGs.size(), read_tx.rct_signatures.p.MGs.size());
+    ASSERT_HASH_EQ(tx.rct_signatures.p.MGs[0].cc, read_tx.rct_signatures.p.MGs[0].cc);
+
+    block popped;
+    std::vector<transaction> popped_txs;
+    ASSERT_NO_THROW(db.pop_block(popped, popped_txs));
+    ASSERT_EQ(1, popped_txs.size());
+    ASSERT_FALSE(db.tx_exists(txid));
+    ASSERT_FALSE(db.get_tx_blob(txid, blob));
+    db.close();
+  }
+
+  // a split db is only ever opened split
+  {
+    BlockchainLMDB db;
+    ASSERT_THROW(db.open(hot_dir), DB_OPEN_FAILURE);
+  }
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(BlockchainLMDB, Snapshot)
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  const std::string db_dir = (dir / "db").string(), snapshot_dir = (dir / "snapshot").string(), node_dir = (dir / "node").string();
+
+  std::vector<crypto::hash> ids;
+  {
+    BlockchainLMDB db;
+    HardFork hf(db, 1, 0);
+    ASSERT_NO_THROW(db.open(db_dir));
+    hf.init();
+    db.set_hard_fork(&hf);
+    for (uint64_t height = 0; height < 3; ++height)
+    {
+      const block b = make_block(ids.empty() ? crypto::null_hash : ids.back(), height, {});
+      ASSERT_NO_THROW(db.add_block(b, 1000, 1, 1000000, {}));
+      ids.push_back(get_block_hash(b));
+    }
+    ASSERT_TRUE(create_snapshot(db, snapshot_dir));
+    ASSERT_FALSE(create_snapshot(db, snapshot_dir));
+    db.close();
+  }
+
+  // the manifest alone is not enough to trust a snapshot
+  checkpoints points;
+  uint64_t trusted_height = 0;
+  ASSERT_FALSE(verify_snapshot(snapshot_dir, points, trusted_height));
+
+  checkpoints wrong_points;
+  ASSERT_TRUE(wrong_points.add_checkpoint(2, pod_to_hex(ids[1])));
+  ASSERT_FALSE(verify_snapshot(snapshot_dir, wrong_points, trusted_height));
+
+  // checkpoints above the top block are ignored
+  ASSERT_TRUE(points.add_checkpoint(1, pod_to_hex(ids[1])));
+  ASSERT_TRUE(points.add_checkpoint(10, pod_to_hex(crypto::null_hash)));
+  ASSERT_TRUE(install_snapshot(snapshot_dir, node_dir, points, trusted_height));
+  ASSERT_EQ(1, trusted_height);
+  {
+    BlockchainLMDB db;
+    ASSERT_NO_THROW(db.open(node_dir, DBF_RDONLY));
+    ASSERT_EQ(3, db.height());
+    ASSERT_HASH_EQ(ids[2], db.top_block_hash());
+    db.close();
+  }
+
+  // an existing database is never overwritten
+  ASSERT_FALSE(install_snapshot(snapshot_dir, node_dir, points, trusted_height));
+  boost::filesystem::remove_all(dir);
+}
+
+#ifndef _WIN32
+TEST(BlockchainLMDB, ReadOnlyReplica)
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  const std::string db_dir = dir.string();
+
+  std::vector<crypto::hash> ids;
+  const auto add_blocks = [&](size_t count) {
+    BlockchainLMDB db;
+    HardFork hf(db, 1, 0);
+    db.open(db_dir);
+    hf.init();
+    db.set_hard_fork(&hf);
+    for (size_t n = 0; n < count; ++n)
+    {
+      const block b = make_block(ids.empty() ? crypto::null_hash : ids.back(), ids.size(), {});
+      db.add_block(b, 1000, 1, 1000000, {});
+      ids.push_back(get_block_hash(b));
+    }
+    db.close();
+  };
+  ASSERT_NO_THROW(add_blocks(1));
+
+  const std::pair<uint8_t, uint64_t> hard_forks[2] = {std::make_pair(1, 0), std::make_pair(0, 0)};
+  const test_options options = {hard_forks};
+  // the pool and the chain refer to each other, as in core
+  struct chain_and_pool
+  {
+    chain_and_pool(): pool(chain), chain(pool) {}
+    tx_memory_pool pool;
+    Blockchain chain;
+  } storage;
+  Blockchain &replica = storage.chain;
+  BlockchainLMDB *db = new BlockchainLMDB();
+  ASSERT_NO_THROW(db->open(db_dir, DBF_RDONLY));
+  ASSERT_TRUE(replica.init(db, FAKECHAIN, true, &options));
+  ASSERT_FALSE(replica.refresh_read_only_db());
+  ASSERT_EQ(1, replica.get_current_blockchain_height());
+
+  // LMDB does not allow a second handle on the environment in the same
+  // process, so the writer runs in its own, as it does next to a replica
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    try { add_blocks(2); }
+    catch (...) { _exit(1); }
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  ASSERT_TRUE(replica.refresh_read_only_db());
+  ASSERT_EQ(3, replica.get_current_blockchain_height());
+  ASSERT_HASH_EQ(ids[0], replica.get_db().get_block_from_height(1).prev_id);
+  ASSERT_HASH_EQ(get_block_hash(replica.get_db().get_block_from_height(2)), replica.get_tail_id());
+  ASSERT_FALSE(replica.refresh_read_only_db());
+
+  replica.deinit();
+  boost::filesystem::remove_all(dir);
+}
+#endif
+
+TEST(core, preverify_range_proofs)
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  const std::pair<uint8_t, uint64_t> hard_forks[2] = {std::make_pair(1, 0), std::make_pair(0, 0)};
+  const test_options options = {hard_forks};
+  core c(nullptr);
+  flaky_lmdb *db = new flaky_lmdb();
+  ASSERT_NO_THROW(db->open(dir.string()));
+  ASSERT_TRUE(c.get_blockchain_storage().init(db, FAKECHAIN, true, &options));
+
+  // a span of two blocks, with a bad range proof in the second one
+  std::vector<transaction> txs;
+  std::vector<crypto::hash> txids;
+  for (size_t n = 0; n < 4; ++n)
+    txs.push_back(make_rct_tx(rct::RangeProofBulletproof));
+  txs[3].rct_signatures.p.bulletproofs[0].taux = rct::skGen();
+  for (const transaction &tx: txs)
+    txids.push_back(get_transaction_hash(tx));
+  std::vector<block_complete_entry> blocks(2);
+  crypto::hash prev_id = c.get_blockchain_storage().get_tail_id();
+  for (size_t b = 0; b < blocks.size(); ++b)
+  {
+    const std::vector<transaction> block_txs(txs.begin() + 2 * b, txs.begin() + 2 * b + 2);
+    const block blk = make_block(prev_id, b + 1, block_txs);
+    blocks[b].block = block_to_blob(blk);
+    for (const transaction &tx: block_txs)
+      blocks[b].txs.push_back(tx_to_blob(tx));
+    prev_id = get_block_hash(blk);
+  }
+
+  c.preverify_range_proofs(blocks);
+  for (size_t n = 0; n < txs.size(); ++n)
+    ASSERT_EQ(n != 3, c.is_semantics_preverified_tx(txids[n]));
+
+  // the marks last until the span is handled
+  ASSERT_TRUE(c.prepare_handle_incoming_blocks(blocks));
+  c.cleanup_handle_incoming_blocks();
+  ASSERT_FALSE(c.is_semantics_preverified_tx(txids[0]));
+
+  // a failure while preverifying marks nothing, and does not keep the
+  // incoming tx lock from being released
+  db->fail_next = true;
+  ASSERT_TRUE(c.prepare_handle_incoming_blocks(blocks));
+  ASSERT_FALSE(db->fail_next);
+  for (const crypto::hash &txid: txids)
+    ASSERT_FALSE(c.is_semantics_preverified_tx(txid));
+  c.cleanup_handle_incoming_blocks();
+
+  std::shared_ptr<std::promise<void>> done = std::make_shared<std::promise<void>>();
+  std::future<void> locked = done->get_future();
+  std::thread([&c, done]() {
+    std::vector<tx_verification_context> tvc;
+    c.handle_incoming_txs({}, tvc, true, true, false);
+    done->set_value();
+  }).detach();
+  ASSERT_EQ(std::future_status::ready, locked.wait_for(std::chrono::seconds(30)));
+
+  c.get_blockchain_storage().deinit();
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(get_block_hashes, matches_get_block_hash)
+{
+  block base;
+  ASSERT_TRUE(parse_and_validate_block_from_blob(h2b(t_blocks[0]), base));
+
+  // different numbers of tx hashes give hashing blobs of different lengths
+  std::vector<block> blocks;
+  for (size_t i = 0; i < 9; ++i)
+  {
+    block b = base;
+    b.nonce = i;
+    for (size_t n = 0; n < i * 5; ++n)
+      b.tx_hashes.push_back(crypto::cn_fast_hash(&n, sizeof(n)));
+    b.invalidate_hashes();
+    blocks.push_back(b);
+  }
+  // one whose hash is already cached
+  get_block_hash(blocks[4]);
+
+  std::vector<crypto::hash> hashes;
+  get_block_hashes(blocks, hashes);
+  ASSERT_EQ(blocks.size(), hashes.size());
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    block copy = blocks[i];
+    copy.invalidate_hashes();
+    ASSERT_HASH_EQ(get_block_hash(copy), hashes[i]);
+
+    // the cached hash goes along when the block is moved on to be handled
+    ASSERT_TRUE(blocks[i].is_hash_valid());
+    block moved = std::move(blocks[i]);
+    ASSERT_HASH_EQ(get_block_hash(moved), hashes[i]);
+  }
+}
+
 }  // anonymous namespace
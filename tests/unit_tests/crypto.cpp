@@ -34,6 +34,7 @@
 #include <string>
 
 #include "cryptonote_basic/cryptonote_basic_impl.h"
+#include "ringct/rctOps.h"
 
 namespace
 {
@@ -97,3 +98,115 @@ TEST(Crypto, verify_32)
     }
   }
 }
+
+TEST(Crypto, tx_proofs)
+{
+  // proofs for one address, half of them to its subaddress form, then a stranger's
+  crypto::public_key A, B, A2;
+  crypto::secret_key a, b, a2;
+  crypto::generate_keys(A, a);
+  crypto::generate_keys(B, b);
+  crypto::generate_keys(A2, a2);
+
+  std::vector<crypto::tx_proof_entry> proofs;
+  for (size_t i = 0; i < 9; ++i)
+  {
+    const bool subaddress = i % 2;
+    const crypto::public_key &view = i == 8 ? A2 : A;
+    crypto::tx_proof_entry proof;
+    crypto::secret_key r;
+    proof.prefix_hash = crypto::rand<crypto::hash>();
+    crypto::generate_keys(proof.R, r);
+    if (subaddress)
+    {
+      proof.B = B;
+      proof.R = rct::rct2pk(rct::scalarmultKey(rct::pk2rct(B), rct::sk2rct(r)));
+    }
+    proof.A = view;
+    proof.D = rct::rct2pk(rct::scalarmultKey(rct::pk2rct(view), rct::sk2rct(r)));
+    crypto::generate_tx_proof(proof.prefix_hash, proof.R, proof.A, proof.B, proof.D, r, proof.sig);
+    ASSERT_TRUE(crypto::check_tx_proof(proof.prefix_hash, proof.R, proof.A, proof.B, proof.D, proof.sig));
+    proofs.push_back(proof);
+  }
+
+  std::vector<int> good(proofs.size());
+  crypto::check_tx_proofs(proofs.data(), proofs.size(), good.data());
+  for (size_t i = 0; i < proofs.size(); ++i)
+    ASSERT_TRUE(good[i]);
+
+  // a bad proof is reported alone
+  proofs[3].D = proofs[2].D;
+  proofs[6].prefix_hash = crypto::rand<crypto::hash>();
+  crypto::check_tx_proofs(proofs.data(), proofs.size(), good.data());
+  for (size_t i = 0; i < proofs.size(); ++i)
+  {
+    ASSERT_EQ(good[i], i != 3 && i != 6);
+    ASSERT_EQ(crypto::check_tx_proof(proofs[i].prefix_hash, proofs[i].R, proofs[i].A, proofs[i].B, proofs[i].D, proofs[i].sig), good[i]);
+  }
+}
+
+TEST(Crypto, cn_fast_hash_n)
+{
+  // enough messages of mixed lengths to exercise every lane count and
+  // lanes finishing at different times
+  static const size_t lengths[] = {0, 1, 32, 64, 135, 136, 137, 200, 272, 1000, 31, 76, 4096, 7, 8, 9, 300};
+  static const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+  std::vector<std::vector<uint8_t>> messages(count);
+  std::vector<const void*> data(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    messages[i].resize(lengths[i] + 1);
+    crypto::rand(messages[i].size(), messages[i].data());
+    data[i] = messages[i].data();
+  }
+
+  for (size_t n = 0; n <= count; ++n)
+  {
+    std::vector<crypto::hash> hashes(n);
+    crypto::cn_fast_hash_n(data.data(), lengths, hashes.data(), n);
+    for (size_t i = 0; i < n; ++i)
+      ASSERT_EQ(hashes[i], crypto::cn_fast_hash(data[i], lengths[i]));
+  }
+}
+
+TEST(Crypto, key_derivation_batches)
+{
+  crypto::public_key A;
+  crypto::secret_key a;
+  crypto::generate_keys(A, a);
+
+  static const size_t n = 70;
+  std::vector<crypto::public_key> tx_keys(n), out_keys(n), derived(n);
+  std::vector<crypto::key_derivation> derivations(n);
+  std::vector<size_t> output_indices(n);
+  std::vector<int> good(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    crypto::secret_key r;
+    crypto::generate_keys(tx_keys[i], r);
+    crypto::generate_keys(out_keys[i], r);
+    output_indices[i] = i * 131;
+  }
+  // not a point
+  tx_keys[9] = crypto::public_key{};
+  tx_keys[9].data[0] = 2;
+  out_keys[13] = tx_keys[9];
+
+  crypto::generate_key_derivations(tx_keys.data(), n, a, derivations.data(), good.data());
+  for (size_t i = 0; i < n; ++i)
+  {
+    crypto::key_derivation derivation;
+    ASSERT_EQ(good[i], crypto::generate_key_derivation(tx_keys[i], a, derivation));
+    if (good[i])
+      ASSERT_EQ(memcmp(&derivation, &derivations[i], sizeof(derivation)), 0);
+  }
+
+  crypto::derive_subaddress_public_keys(out_keys.data(), derivations.data(), output_indices.data(), n, derived.data(), good.data());
+  for (size_t i = 0; i < n; ++i)
+  {
+    crypto::public_key key;
+    ASSERT_EQ(good[i], crypto::derive_subaddress_public_key(out_keys[i], derivations[i], output_indices[i], key));
+    if (good[i])
+      ASSERT_EQ(key, derived[i]);
+  }
+}
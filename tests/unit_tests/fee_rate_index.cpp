@@ -0,0 +1,133 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <vector>
+#include "gtest/gtest.h"
+#include "crypto/crypto.h"
+#include "cryptonote_core/fee_rate_index.h"
+
+namespace
+{
+  struct pool_tx
+  {
+    crypto::hash txid;
+    double fee_per_byte;
+    uint64_t weight;
+  };
+
+  // reference answer, walking transactions from the highest fee per byte down
+  double brute_force_fee_rate_at_weight(std::vector<pool_tx> txs, uint64_t weight)
+  {
+    std::sort(txs.begin(), txs.end(), [](const pool_tx &a, const pool_tx &b) { return a.fee_per_byte > b.fee_per_byte; });
+    uint64_t cumulative = 0;
+    for (const pool_tx &tx: txs)
+    {
+      cumulative += tx.weight;
+      if (cumulative > weight)
+        return tx.fee_per_byte;
+    }
+    return 0.0;
+  }
+}
+
+TEST(fee_rate_index, empty)
+{
+  cryptonote::fee_rate_index index;
+  ASSERT_EQ(index.size(), 0);
+  ASSERT_EQ(index.total_weight(), 0);
+  ASSERT_EQ(index.get_percentile(50), 0.0);
+  ASSERT_EQ(index.get_fee_rate_at_weight(0), 0.0);
+}
+
+TEST(fee_rate_index, insert_erase)
+{
+  cryptonote::fee_rate_index index;
+  const crypto::hash txid0 = crypto::rand<crypto::hash>();
+  const crypto::hash txid1 = crypto::rand<crypto::hash>();
+
+  index.insert(txid0, 10.0, 1000);
+  index.insert(txid1, 20.0, 2000);
+  ASSERT_EQ(index.size(), 2);
+  ASSERT_EQ(index.total_weight(), 3000);
+
+  // reinserting replaces
+  index.insert(txid0, 30.0, 500);
+  ASSERT_EQ(index.size(), 2);
+  ASSERT_EQ(index.total_weight(), 2500);
+  ASSERT_EQ(index.get_percentile(100), 30.0);
+  ASSERT_EQ(index.get_percentile(0), 20.0);
+
+  ASSERT_TRUE(index.erase(txid0));
+  ASSERT_FALSE(index.erase(txid0));
+  ASSERT_EQ(index.size(), 1);
+  ASSERT_EQ(index.total_weight(), 2000);
+
+  index.clear();
+  ASSERT_EQ(index.size(), 0);
+  ASSERT_EQ(index.total_weight(), 0);
+}
+
+TEST(fee_rate_index, fee_rate_at_weight)
+{
+  cryptonote::fee_rate_index index;
+  std::vector<pool_tx> txs;
+  for (int n = 0; n < 500; ++n)
+  {
+    const pool_tx tx{crypto::rand<crypto::hash>(), (double)(crypto::rand<uint32_t>() % 1000), 1000 + crypto::rand<uint32_t>() % 10000};
+    txs.push_back(tx);
+    index.insert(tx.txid, tx.fee_per_byte, tx.weight);
+  }
+  // drop a few to check aggregates are maintained on erase
+  for (int n = 0; n < 100; ++n)
+  {
+    ASSERT_TRUE(index.erase(txs.back().txid));
+    txs.pop_back();
+  }
+
+  uint64_t total = 0;
+  for (const pool_tx &tx: txs)
+    total += tx.weight;
+  ASSERT_EQ(index.size(), txs.size());
+  ASSERT_EQ(index.total_weight(), total);
+
+  for (uint64_t weight = 0; weight <= total + 10000; weight += 7919)
+    ASSERT_EQ(index.get_fee_rate_at_weight(weight), brute_force_fee_rate_at_weight(txs, weight));
+}
+
+TEST(fee_rate_index, percentiles)
+{
+  cryptonote::fee_rate_index index;
+  for (int n = 1; n <= 101; ++n)
+    index.insert(crypto::rand<crypto::hash>(), n, 1000);
+  ASSERT_EQ(index.get_percentile(0), 1.0);
+  ASSERT_EQ(index.get_percentile(10), 11.0);
+  ASSERT_EQ(index.get_percentile(50), 51.0);
+  ASSERT_EQ(index.get_percentile(90), 91.0);
+  ASSERT_EQ(index.get_percentile(100), 101.0);
+}
@@ -29,6 +29,11 @@
 
 #include "gtest/gtest.h"
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "crypto/crypto.h"
 
 extern "C" {
@@ -46,3 +51,29 @@ TEST(random32_unbiased, less_than_order)
     ASSERT_EQ(memcmp(tmp, tmp2, 32), 0);
   }
 }
+
+#ifndef _WIN32
+TEST(random, fork_does_not_repeat)
+{
+  unsigned char parent[32], child[32];
+  // seed this thread's generator before forking
+  crypto::generate_random_bytes_thread_safe(sizeof(parent), parent);
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    crypto::generate_random_bytes_thread_safe(sizeof(child), child);
+    _exit(write(fds[1], child, sizeof(child)) == sizeof(child) ? 0 : 1);
+  }
+  close(fds[1]);
+  crypto::generate_random_bytes_thread_safe(sizeof(parent), parent);
+  ASSERT_EQ(read(fds[0], child, sizeof(child)), sizeof(child));
+  close(fds[0]);
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_NE(memcmp(parent, child, sizeof(parent)), 0);
+}
+#endif
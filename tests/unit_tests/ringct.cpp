@@ -38,6 +38,7 @@
 #include "ringct/rctTypes.h"
 #include "ringct/rctSigs.h"
 #include "ringct/rctOps.h"
+#include "ringct/rctPointCache.h"
 #include "device/device.hpp"
 
 using namespace std;
@@ -138,6 +139,48 @@ TEST(ringct, MG_sigs)
         ASSERT_FALSE(MLSAG_Ver(message, P, IIccss, R));
 }
 
+TEST(ringct, MG_sigs_point_cache)
+{
+    const int N = 4;// #cols
+    const int R = 2;// #rows
+    keyM xm = keyMInit(R, N);
+    keyM P  = keyMInit(R, N);
+    keyV sk = skvGen(R);
+    const int ind = 1;
+    for (int j = 0 ; j < R ; j++) {
+        for (int i = 0 ; i < N ; i++)
+        {
+            xm[i][j] = skGen();
+            P[i][j] = scalarmultBase(xm[i][j]);
+        }
+        sk[j] = xm[ind][j];
+    }
+    key message = skGen();
+    mgSig sig = MLSAG_Gen(message, P, sk, NULL, NULL, ind, R, hw::get_device("default"));
+    mgSig bad = sig;
+    bad.ss[0][0] = skGen();
+
+    point_cache &cache = get_point_cache();
+    const bool was_enabled = cache.is_enabled();
+
+    cache.set_enabled(false);
+    ASSERT_TRUE(MLSAG_Ver(message, P, sig, R));
+    ASSERT_FALSE(MLSAG_Ver(message, P, bad, R));
+    ASSERT_EQ(cache.get_stats().entries, 0u);
+
+    cache.set_enabled(true);
+    ASSERT_TRUE(MLSAG_Ver(message, P, sig, R));
+    point_cache_stats before = cache.get_stats();
+    ASSERT_TRUE(MLSAG_Ver(message, P, sig, R));
+    ASSERT_FALSE(MLSAG_Ver(message, P, bad, R));
+    point_cache_stats after = cache.get_stats();
+    ASSERT_EQ(after.hits - before.hits, (uint64_t)(2 * N * R));
+    ASSERT_EQ(after.misses, before.misses);
+
+    cache.clear();
+    cache.set_enabled(was_enabled);
+}
+
 TEST(ringct, range_proofs)
 {
         //Ring CT Stuff
@@ -376,6 +419,37 @@ static rct::rctSig make_sample_simple_rct_sig(int n_inputs, const uint64_t input
     return genRctSimple(rct::zero(), sc, pc, destinations, inamounts, outamounts, amount_keys, NULL, NULL, fee, 3, hw::get_device("default"));
 }
 
+static rct::rctSig make_sample_big_rct_sig(int n_inputs, const uint64_t input_amounts[], int n_outputs, const uint64_t output_amounts[], uint64_t fee)
+{
+    ctkeyV sc, pc;
+    ctkey sctmp, pctmp;
+    rct::ctamountV inamounts;
+    std::map<cryptonote::TokenId, std::vector<xmr_amount>> outamounts;
+    keyV destinations;
+    keyV amount_keys;
+    ctkeyM mixRing;
+    std::vector<unsigned int> index;
+    ctkeyV outSk;
+    key Sk, Pk;
+
+    for (int n = 0; n < n_inputs; ++n) {
+        inamounts.push_back({input_amounts[n], rct::H});
+        tie(sctmp, pctmp) = ctskpkGen(input_amounts[n]);
+        sc.push_back(sctmp);
+        mixRing.push_back({pctmp, std::get<1>(ctskpkGen(input_amounts[n]))});
+        index.push_back(0);
+    }
+
+    for (int n = 0; n < n_outputs; ++n) {
+        outamounts[cryptonote::CUTCOIN_ID].push_back(output_amounts[n]);
+        amount_keys.push_back(hash_to_scalar(zero()));
+        skpkGen(Sk, Pk);
+        destinations.push_back(Pk);
+    }
+
+    return genRctSimpleBig([](const rct::key &) { return rct::zero(); }, sc, destinations, inamounts, outamounts, fee, mixRing, amount_keys, NULL, NULL, index, outSk, hw::get_device("default"));
+}
+
 static bool range_proof_test(bool expected_valid,
     int n_inputs, const uint64_t input_amounts[], int n_outputs, const uint64_t output_amounts[], bool last_is_fee, bool simple)
 {
@@ -1102,6 +1176,34 @@ TEST(ringct, mul8)
   ASSERT_EQ(rct::scalarmultKey(rct::scalarmultKey(rct::H, rct::INV_EIGHT), rct::EIGHT), rct::H);
 }
 
+TEST(ringct, generator_tables)
+{
+  for (int n = 0; n < 16; ++n)
+  {
+    const rct::key a = rct::skGen();
+    const rct::key amount = rct::d2h(crypto::rand<uint64_t>());
+    ASSERT_EQ(rct::scalarmultH(a), rct::scalarmultKey(rct::H, a));
+    ASSERT_EQ(rct::scalarmultGenerator(rct::H, amount), rct::scalarmultKey(rct::H, amount));
+
+    const cryptonote::TokenId token_id = crypto::rand<uint64_t>() | 1;
+    const rct::key omega = rct::tokenIdToPoint(token_id);
+    ASSERT_EQ(omega, rct::hashToPoint(rct::smearBits(token_id)));
+    ASSERT_EQ(rct::tokenIdToPoint(token_id), omega);
+    ASSERT_EQ(rct::scalarmultGenerator(omega, a), rct::scalarmultKey(omega, a));
+    ASSERT_EQ(rct::gp_commit(h2d(amount), a, omega), rct::addKeys(rct::scalarmultBase(a), rct::scalarmultKey(omega, amount)));
+
+    rct::key C;
+    rct::addKeys2(C, a, amount, omega);
+    rct::key C2;
+    rct::addKeys2Generator(C2, a, amount, omega);
+    ASSERT_EQ(C, C2);
+
+    // points which are not generators are multiplied as any other
+    const rct::key P = rct::pkGen();
+    ASSERT_EQ(rct::scalarmultGenerator(P, a), rct::scalarmultKey(P, a));
+  }
+}
+
 TEST(ringct, aggregated)
 {
   static const size_t N_PROOFS = 16;
@@ -1118,3 +1220,84 @@ TEST(ringct, aggregated)
 
   ASSERT_TRUE(verRctSemanticsSimple(sp));
 }
+
+TEST(ringct, aggregated_find_bad)
+{
+  static const size_t N_PROOFS = 16;
+  std::vector<rctSig> s(N_PROOFS);
+  std::vector<const rctSig*> sp(N_PROOFS);
+
+  for (size_t n = 0; n < N_PROOFS; ++n)
+  {
+    static const uint64_t inputs[] = {1000, 1000};
+    static const uint64_t outputs[] = {500, 1500};
+    s[n] = make_sample_simple_rct_sig(NELTS(inputs), inputs, NELTS(outputs), outputs, 0);
+    sp[n] = &s[n];
+  }
+
+  std::vector<size_t> bad;
+  ASSERT_TRUE(verRctSemanticsSimple(std::vector<const rctSig*>(), bad));
+  ASSERT_TRUE(verRctSemanticsSimple(sp, bad));
+  ASSERT_TRUE(bad.empty());
+
+  // the amounts no longer balance
+  s[3].txnFee = 1;
+  s[11].txnFee = 1;
+  ASSERT_FALSE(verRctSemanticsSimple(sp, bad));
+  ASSERT_EQ(bad, std::vector<size_t>({3, 11}));
+}
+
+TEST(ringct, non_semantics_find_bad)
+{
+  static const size_t N_SIGS = 8;
+  std::vector<rctSig> s(N_SIGS);
+  std::vector<const rctSig*> sp(N_SIGS);
+
+  for (size_t n = 0; n < N_SIGS; ++n)
+  {
+    static const uint64_t inputs[] = {1000, 1000};
+    static const uint64_t outputs[] = {500, 1500};
+    s[n] = make_sample_simple_rct_sig(NELTS(inputs), inputs, NELTS(outputs), outputs, 0);
+    sp[n] = &s[n];
+  }
+
+  std::vector<size_t> bad;
+  ASSERT_TRUE(verRctNonSemanticsSimple(std::vector<const rctSig*>(), bad));
+  ASSERT_TRUE(verRctNonSemanticsSimple(sp, bad));
+  ASSERT_TRUE(bad.empty());
+
+  // a bad MG on the first or second input, and a layout which does not match
+  s[1].p.MGs[0].cc = rct::skGen();
+  s[4].mixRing.pop_back();
+  s[6].p.MGs[1].ss[0][0] = rct::skGen();
+  ASSERT_FALSE(verRctNonSemanticsSimple(sp, bad));
+  ASSERT_EQ(bad, std::vector<size_t>({1, 4, 6}));
+
+  sp[5] = NULL;
+  ASSERT_FALSE(verRctNonSemanticsSimple(sp, bad));
+  ASSERT_EQ(bad, std::vector<size_t>({5}));
+}
+
+TEST(ringct, aggregated_find_bad_big)
+{
+  static const size_t N_PROOFS = 8;
+  std::vector<rctSig> s(N_PROOFS);
+  std::vector<const rctSig*> sp(N_PROOFS);
+
+  for (size_t n = 0; n < N_PROOFS; ++n)
+  {
+    static const uint64_t inputs[] = {1000, 1000};
+    static const uint64_t outputs[] = {500, 1500};
+    s[n] = make_sample_big_rct_sig(NELTS(inputs), inputs, NELTS(outputs), outputs, 0);
+    sp[n] = &s[n];
+  }
+
+  std::vector<size_t> bad;
+  ASSERT_TRUE(verRctSemanticsSimpleBig(sp, bad));
+  ASSERT_TRUE(bad.empty());
+
+  // the amounts still balance, only the range proof is broken
+  s[5].p.bigBulletproofs[0].taux[0] = rct::skGen();
+  ASSERT_FALSE(verRctSemanticsSimpleBig(sp, bad));
+  ASSERT_EQ(bad, std::vector<size_t>({5}));
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <boost/uuid/uuid.hpp>
+#include "gtest/gtest.h"
+#include "crypto/crypto.h"
+#include "cryptonote_protocol/tx_admission.h"
+
+namespace
+{
+  cryptonote::transaction make_tx(size_t inputs, size_t ring_size, size_t outputs, uint8_t rct_type)
+  {
+    cryptonote::transaction tx;
+    for (size_t n = 0; n < inputs; ++n)
+    {
+      cryptonote::txin_to_key in;
+      in.key_offsets.resize(ring_size);
+      tx.vin.push_back(in);
+    }
+    tx.vout.resize(outputs);
+    tx.rct_signatures.type = rct_type;
+    return tx;
+  }
+}
+
+TEST(tx_admission, cost)
+{
+  const uint8_t bp = (uint8_t)rct::RctType::RCTTypeBulletproof;
+  const uint64_t typical = cryptonote::estimate_tx_verification_cost(make_tx(2, 11, 2, bp));
+  ASSERT_GT(cryptonote::estimate_tx_verification_cost(make_tx(16, 11, 2, bp)), typical);
+  ASSERT_GT(cryptonote::estimate_tx_verification_cost(make_tx(2, 11, 16, bp)), typical);
+  ASSERT_GT(cryptonote::estimate_tx_verification_cost(make_tx(2, 11, 2, (uint8_t)rct::RctType::RCTTypeSimple)), typical);
+
+  cryptonote::transaction genesis = make_tx(2, 11, 2, bp);
+  genesis.set_token_genesis(true);
+  ASSERT_GT(cryptonote::estimate_tx_verification_cost(genesis), typical);
+}
+
+TEST(tx_admission, bucket)
+{
+  const boost::uuids::uuid peer1 = crypto::rand<boost::uuids::uuid>();
+  const boost::uuids::uuid peer2 = crypto::rand<boost::uuids::uuid>();
+  cryptonote::tx_admission admission;
+  admission.set_limits(100, 1000);
+
+  // the burst is available at once, then it refills at the rate
+  ASSERT_TRUE(admission.admit(peer1, 600, 0));
+  ASSERT_TRUE(admission.admit(peer1, 400, 0));
+  ASSERT_FALSE(admission.admit(peer1, 1, 0));
+  ASSERT_FALSE(admission.admit(peer1, 200, 1000));
+  ASSERT_TRUE(admission.admit(peer1, 100, 1000));
+  ASSERT_EQ(admission.get_refused_count(), 2);
+
+  // peers do not share a bucket
+  ASSERT_TRUE(admission.admit(peer2, 1000, 1000));
+
+  // refills up to the burst only
+  ASSERT_FALSE(admission.admit(peer1, 1001, 100000));
+  ASSERT_TRUE(admission.admit(peer1, 1000, 100000));
+
+  // a new connection starts with a full bucket
+  ASSERT_FALSE(admission.admit(peer2, 1000, 1000));
+  admission.remove_connection(peer2);
+  ASSERT_TRUE(admission.admit(peer2, 1000, 1000));
+}
+
+TEST(tx_admission, disabled)
+{
+  const boost::uuids::uuid peer = crypto::rand<boost::uuids::uuid>();
+  cryptonote::tx_admission admission;
+  admission.set_limits(0, 0);
+  for (int n = 0; n < 100; ++n)
+    ASSERT_TRUE(admission.admit(peer, 1000000, 0));
+  ASSERT_EQ(admission.get_refused_count(), 0);
+}
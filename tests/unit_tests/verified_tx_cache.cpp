@@ -0,0 +1,99 @@
+// Copyright (c) 2018-2021, CUT coin
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+#include "crypto/crypto.h"
+#include "ringct/rctOps.h"
+#include "cryptonote_core/verified_tx_cache.h"
+
+namespace
+{
+  crypto::hash make_hash(unsigned char n)
+  {
+    crypto::hash h = crypto::null_hash;
+    h.data[0] = n;
+    return h;
+  }
+
+  rct::rctSig make_rct(size_t inputs, size_t ring)
+  {
+    rct::rctSig rv;
+    rv.mixRing.resize(inputs);
+    for (auto &row: rv.mixRing)
+      for (size_t i = 0; i < ring; ++i)
+        row.push_back({rct::pkGen(), rct::pkGen()});
+    return rv;
+  }
+}
+
+TEST(verified_tx_cache, add_has)
+{
+  cryptonote::verified_tx_cache cache(4);
+  ASSERT_FALSE(cache.has(make_hash(1)));
+  cache.add(make_hash(1));
+  ASSERT_TRUE(cache.has(make_hash(1)));
+  ASSERT_FALSE(cache.has(make_hash(2)));
+  cache.add(make_hash(1));
+  ASSERT_EQ(cache.size(), 1);
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0);
+  ASSERT_FALSE(cache.has(make_hash(1)));
+}
+
+TEST(verified_tx_cache, evicts_least_recently_used)
+{
+  cryptonote::verified_tx_cache cache(3);
+  cache.add(make_hash(1));
+  cache.add(make_hash(2));
+  cache.add(make_hash(3));
+  ASSERT_TRUE(cache.has(make_hash(1)));
+  cache.add(make_hash(4));
+  ASSERT_EQ(cache.size(), 3);
+  ASSERT_TRUE(cache.has(make_hash(1)));
+  ASSERT_FALSE(cache.has(make_hash(2)));
+  ASSERT_TRUE(cache.has(make_hash(3)));
+  ASSERT_TRUE(cache.has(make_hash(4)));
+}
+
+TEST(verified_tx_cache, ring_key_binds_ring)
+{
+  const crypto::hash txid = make_hash(1);
+  rct::rctSig rv = make_rct(2, 11);
+  const crypto::hash key = cryptonote::verified_tx_cache::get_ring_key(txid, rv);
+  ASSERT_EQ(key, cryptonote::verified_tx_cache::get_ring_key(txid, rv));
+
+  ASSERT_NE(key, cryptonote::verified_tx_cache::get_ring_key(make_hash(2), rv));
+
+  rct::rctSig other = rv;
+  other.mixRing[1][5].dest = rct::pkGen();
+  ASSERT_NE(key, cryptonote::verified_tx_cache::get_ring_key(txid, other));
+
+  other = rv;
+  other.mixRing[0][0].mask = rct::pkGen();
+  ASSERT_NE(key, cryptonote::verified_tx_cache::get_ring_key(txid, other));
+}